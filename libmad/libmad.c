@@ -262,6 +262,17 @@ int mad_decode(void* hMad, char *inmemory,int inmemsize, char *outmemory,
 	if (mad_frame_decode(&dec->frame, &dec->stream) == -1) {
 		if (dec->stream.error == MAD_ERROR_BUFLEN)
 			return MAD_NEED_MORE_INPUT;
+		/* report how far libmad got, so the caller skips the whole bad frame
+		   (or the garbage up to the next sync word) instead of one byte */
+		if (dec->stream.next_frame) {
+			unsigned char const *ptr = dec->stream.next_frame;
+			if (dec->stream.error == MAD_ERROR_LOSTSYNC) {
+				while (ptr < dec->stream.bufend - 1 &&
+				       !(ptr[0] == 0xff && (ptr[1] & 0xe0) == 0xe0))
+					++ptr;
+			}
+			*read = (char*)ptr - inmemory;
+		}
 		return MAD_RECOVERABLE(dec->stream.error) ? MAD_ERR : MAD_FATAL_ERR;
 	}
 
@@ -308,6 +319,25 @@ void mad_uninit(void* hMad)
 	free(dec);
 }
 
+void mad_reset(void* hMad)
+{
+	dec_struct* dec = (dec_struct*)hMad;
+
+	/* keep the main_data and overlap allocations, only forget their contents */
+	mad_frame_mute(&dec->frame);
+	mad_synth_mute(&dec->synth);
+
+	dec->stream.buffer     = 0;
+	dec->stream.bufend     = 0;
+	dec->stream.skiplen    = 0;
+	dec->stream.sync       = 0;
+	dec->stream.freerate   = 0;
+	dec->stream.this_frame = 0;
+	dec->stream.next_frame = 0;
+	dec->stream.md_len     = 0;
+	dec->stream.error      = MAD_ERROR_NONE;
+}
+
 double eq_decibels(int value)
 {
 	/* 0-63, 0 == +20 dB, 31 == 0 dB, 63 == -20 dB */
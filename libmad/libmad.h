@@ -50,6 +50,8 @@ LIBMAD_EXPORT void* mad_init();
 LIBMAD_EXPORT int mad_decode(void* hMad, char *inmemory,int inmemsize, char *outmemory,
 							 int outmemsize, int* read, int *done, int resolution, int halfsamplerate);
 LIBMAD_EXPORT void mad_uninit(void* hMad);
+/* Drop all decoder history (bit reservoir, overlap, filterbank) without reallocating - for seek */
+LIBMAD_EXPORT void mad_reset(void* hMad);
 LIBMAD_EXPORT void mad_seteq(void* hMad, equalizer_value* eq);
 /* Get audio info after first decode (returns 0 if not yet decoded, 1 on success) */
 LIBMAD_EXPORT int mad_get_info(void* hMad, int* samplerate, int* channels);
@@ -20,14 +20,28 @@
 #include <strings.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <math.h>
+#ifdef HAVE_PREAD
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /* Debug logging for SF2000 */
 extern void xlog(const char *fmt, ...);
 
+/* Hot-path tracing. Every xlog is a formatted write to the firmware log, so
+ * per-block/per-frame traces are compiled out unless built with
+ * -DPMP_TRACE=<level> (1 = per call, 2 = per block). */
+#ifndef PMP_TRACE
+#define PMP_TRACE 0
+#endif
+#define trace(level, ...) do { if (PMP_TRACE >= (level)) xlog(__VA_ARGS__); } while (0)
+
 /* Xvid includes for MPEG-4 decoding */
 #include "xvid/xvid.h"
+#include "xvid/utils/smp_pool.h"
 
 /* libmad includes for MP3 decoding */
 #include "libmad/libmad.h"
@@ -36,6 +50,7 @@ extern void xlog(const char *fmt, ...);
 #define CODEC_TYPE_UNKNOWN  0
 #define CODEC_TYPE_MJPEG    1
 #define CODEC_TYPE_MPEG4    2
+#define CODEC_TYPE_TILE     3  /* PMPT, written by pmp-remux -t */
 static int video_codec_type = CODEC_TYPE_UNKNOWN;
 static char video_fourcc[5] = {0};  /* For debug display */
 static int mpeg4_error_shown = 0;   /* For "not supported" message */
@@ -44,6 +59,27 @@ static int mpeg4_error_shown = 0;   /* For "not supported" message */
 static void *xvid_handle = NULL;
 static int xvid_initialized = 0;
 
+/* Xvid frame scheduling: which chunk goes in next and which picture is out.
+   With unpacked B-frames the decoder holds one reference back, so picture N
+   comes out while chunk N+1 goes in (xvid_delay = 1). */
+static int xvid_delay = 0;        /* pictures the output lags the chunks */
+static int xvid_next_chunk = 0;   /* next AVI chunk the decoder expects */
+static int xvid_shown = -1;       /* display index held in the YUV planes */
+static int xvid_ref_pending = 0;  /* packed: reference decoded, not shown yet */
+
+/* Opt-in (xvid_fast_mc=1 in the settings file): halfpel instead of qpel and
+   translational GMC. Watchable qpel/GMC files at the price of drift that
+   builds up until the next keyframe */
+static int xvid_fast_mc = 0;
+
+/* Worker threads for the decoder's deblocking and for the colour
+   conversion (xvid_threads=N in the settings file, 0 = one per core).
+   Only the unix build has threads; on the SF2000 both pools stay NULL */
+#define XVID_MAX_THREADS 8
+#define CONVERT_MAX_BANDS XVID_MAX_THREADS
+static int xvid_threads = 0;
+static SMP_POOL *convert_pool = NULL;
+
 /* YUV frame buffer for MPEG-4 (Xvid outputs YUV420P) */
 #define MAX_VIDEO_WIDTH 480
 #define MAX_VIDEO_HEIGHT 320
@@ -57,7 +93,7 @@ static uint8_t *yuv_v = NULL;
 
 /* MPEG-4 extradata (VOL header from AVI strf chunk) */
 #define MAX_EXTRADATA_SIZE 256
-static uint8_t mpeg4_extradata[MAX_EXTRADATA_SIZE];
+static uint8_t mpeg4_extradata[MAX_EXTRADATA_SIZE + XVID_BS_PADDING];
 static int mpeg4_extradata_size = 0;
 static int mpeg4_extradata_sent = 0;  /* Flag: was extradata sent to decoder? */
 
@@ -84,16 +120,142 @@ extern int fs_closedir(int fd);
 extern ssize_t fs_readdir(int fd, void *buffer);
 
 /* S_ISREG and S_ISDIR macros for fs_readdir type field */
+#ifndef S_IFMT
 #define S_IFMT   0170000
 #define S_IFREG  0100000
 #define S_IFDIR  0040000
+#endif
 #define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
 #define S_ISDIR(m) (((m) & S_IFMT) == S_IFDIR)
 
+/* Video file access - a thin layer over fs_* (pread on the unix build).
+ * Reads are served from a cluster aligned window, so the small interleaved
+ * audio/video chunks of an AVI cost one device read per cluster; reads of a
+ * window or more go straight into the caller's buffer. The descriptor
+ * position is tracked so that sequential reads never issue a seek.
+ * Offsets are 32-bit, which covers every file FAT32 can hold. */
+#define PF_WINDOW 32768   /* one cluster on a typical SD card */
+
+typedef struct {
+    int fd;
+    uint32_t pos;        /* logical read position */
+    uint32_t fd_pos;     /* where the descriptor is (fs_* backend) */
+    uint32_t win_start;  /* file offset of win[0] */
+    uint32_t win_len;    /* valid bytes in win */
+    uint8_t win[PF_WINDOW];
+} pfile_t;
+
+static pfile_t *pf_open(const char *path) {
+    pfile_t *f = (pfile_t *)malloc(sizeof(pfile_t));
+    if (!f) return NULL;
+#ifdef HAVE_PREAD
+    f->fd = open(path, O_RDONLY);
+#else
+    f->fd = fs_open(path, FS_O_RDONLY, 0);
+#endif
+    if (f->fd < 0) {
+        free(f);
+        return NULL;
+    }
+    f->pos = 0;
+    f->fd_pos = 0;
+    f->win_start = 0;
+    f->win_len = 0;
+    return f;
+}
+
+static void pf_close(pfile_t *f) {
+#ifdef HAVE_PREAD
+    close(f->fd);
+#else
+    fs_close(f->fd);
+#endif
+    free(f);
+}
+
+/* Read len bytes at off from the device, returns bytes read or -1 */
+static int pf_raw(pfile_t *f, uint32_t off, void *dst, uint32_t len) {
+#ifdef HAVE_PREAD
+    ssize_t got = pread(f->fd, dst, len, (off_t)off);
+#else
+    ssize_t got;
+    if (f->fd_pos != off) {
+        if (fs_lseek(f->fd, off, SEEK_SET) != (int64_t)off) {
+            f->fd_pos = 0xFFFFFFFF;  /* unknown - seek next time */
+            return -1;
+        }
+        f->fd_pos = off;
+    }
+    got = fs_read(f->fd, dst, len);
+    if (got > 0) f->fd_pos += got;
+    else f->fd_pos = 0xFFFFFFFF;
+#endif
+    return got < 0 ? -1 : (int)got;
+}
+
+/* Only moves the logical position - the device is touched on the next read */
+static int pf_seek(pfile_t *f, int64_t off, int whence) {
+    if (whence == SEEK_CUR) off += f->pos;
+    if (off < 0 || off > 0xFFFFFFFF) return -1;
+    f->pos = (uint32_t)off;
+    return 0;
+}
+
+static uint32_t pf_tell(pfile_t *f) {
+    return f->pos;
+}
+
+/* Current length of the file (it may still be growing), 0 on error */
+static uint32_t pf_size(pfile_t *f) {
+#ifdef HAVE_PREAD
+    off_t size = lseek(f->fd, 0, SEEK_END);
+#else
+    int64_t size = fs_lseek(f->fd, 0, SEEK_END);
+    f->fd_pos = size < 0 ? 0xFFFFFFFF : (uint32_t)size;
+#endif
+    if (size < 0) return 0;
+    return size > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)size;
+}
+
+static uint32_t pf_read(pfile_t *f, void *dst, uint32_t n) {
+    uint8_t *out = (uint8_t *)dst;
+    uint32_t got = 0;
+
+    while (got < n) {
+        uint32_t want = n - got;
+        int r;
+
+        if (f->pos >= f->win_start && f->pos < f->win_start + f->win_len) {
+            uint32_t avail = f->win_start + f->win_len - f->pos;
+            if (avail > want) avail = want;
+            memcpy(out + got, f->win + (f->pos - f->win_start), avail);
+            f->pos += avail;
+            got += avail;
+            continue;
+        }
+        if (want >= PF_WINDOW) {
+            /* Large read: directly into the caller's buffer, up to a cluster boundary */
+            want = ((f->pos + want) & ~(uint32_t)(PF_WINDOW - 1)) - f->pos;
+            r = pf_raw(f, f->pos, out + got, want);
+            if (r <= 0) break;
+            f->pos += r;
+            got += r;
+            if ((uint32_t)r < want) break;  /* end of file */
+            continue;
+        }
+        f->win_start = f->pos & ~(uint32_t)(PF_WINDOW - 1);
+        r = pf_raw(f, f->win_start, f->win, PF_WINDOW);
+        f->win_len = r > 0 ? r : 0;
+        if (f->pos >= f->win_start + f->win_len) break;  /* end of file */
+    }
+    return got;
+}
+
 #define SCREEN_WIDTH  320
 #define SCREEN_HEIGHT 240
 #define FRAME_PIXELS  (SCREEN_WIDTH * SCREEN_HEIGHT)
-#define MAX_JPEG_SIZE (64 * 1024)
+#define FRAME_BUF_MIN (16 * 1024)
+#define FRAME_BUF_MAX (512 * 1024)  /* beyond: MJPEG streams from the file, Xvid skips the frame */
 #define TJPGD_WORKSPACE_SIZE 4096
 
 /* Audio settings - support 11025, 22050, 44100 Hz */
@@ -102,21 +264,45 @@ extern ssize_t fs_readdir(int fd, void *buffer);
 
 /* Audio ring buffer: ~1 second at max rate (44100 * 2 channels * 2 bytes) */
 #define AUDIO_RING_SIZE (44100 * 4)
-#define AUDIO_REFILL_THRESHOLD (AUDIO_RING_SIZE / 2)
+
+/* Audio decode-ahead scheduler (see audio_decode_ahead) */
+#define DISPLAY_FPS 30                 /* retro_run rate reported in av_info */
+#define AUDIO_SLICE_BYTES 4096         /* PCM bytes decoded per scheduling step */
+#define AUDIO_LOW_WATER_TICKS 6        /* always keep this many ticks of audio buffered */
+#define AUDIO_HIGH_WATER (AUDIO_RING_SIZE - 8192)  /* room for one more slice + MP3 frame */
+#define AUDIO_TICK_RESERVE_PCT 25      /* part of each tick left to blit, OSD and frontend */
 
 typedef uint16_t pixel_t;
 
 /* Display framebuffer - decode directly here */
 static pixel_t framebuffer[FRAME_PIXELS];
 
-static uint8_t jpeg_buffer[MAX_JPEG_SIZE + 2];
+/* Compressed frame buffer, sized per file from the largest chunk in the
+   index. The padding leaves room for an appended EOI or the Xvid reader's
+   overread */
+static uint8_t *frame_buf = NULL;
+static uint32_t frame_buf_size = 0;
 static uint8_t tjpgd_work[TJPGD_WORKSPACE_SIZE];
 
 /* Audio output buffer */
 static int16_t audio_out_buffer[MAX_AUDIO_BUFFER * 2];
 
+/* A/V sync controller and resampler (see play_audio_for_frame) */
+#define AUDIO_DRIFT_PPM 5000  /* max sample-rate correction: +/-0.5% */
+#define RS_MAX_SRC (MAX_AUDIO_BUFFER + MAX_AUDIO_BUFFER / 64 + 4)  /* source frames per tick at +0.5% */
+static int16_t rs_src[(RS_MAX_SRC + 1) * 2];    /* [0] = history frame, then source frames (stereo) */
+static uint8_t audio_raw_buf[RS_MAX_SRC * 4] __attribute__((aligned(4)));  /* ring bytes before conversion */
+static uint32_t rs_phase = 1 << 16;  /* Q16 position of the next output, relative to rs_src[0] */
+static int16_t rs_prev[2] = {0, 0};
+static int rs_ratio_ppm = 0;         /* current correction, for the debug panel */
+static int sync_last_frame = 0;      /* video position audio was last produced for */
+static int sync_last_sub = 0;
+static int audio_underruns = 0;      /* ring could not cover a tick */
+static int audio_overruns = 0;       /* frontend refused samples */
+static int audio_resyncs = 0;        /* gross errors fixed by drop/pad */
+
 /* Audio ring buffer */
-static uint8_t audio_ring[AUDIO_RING_SIZE];
+static uint8_t audio_ring[AUDIO_RING_SIZE] __attribute__((aligned(4)));  /* ADPCM decodes into it as int16 */
 static int aring_read = 0;
 static int aring_write = 0;
 static int aring_count = 0;
@@ -126,8 +312,52 @@ static retro_environment_t environ_cb;
 static retro_input_poll_t input_poll_cb;
 static retro_input_state_t input_state_cb;
 static retro_audio_sample_batch_t audio_batch_cb = NULL;
-
-static FILE *video_file = NULL;
+static retro_perf_get_time_usec_t perf_get_time_usec = NULL;  /* NULL if frontend has no perf interface */
+
+/* Scheduler measurements for the current tick */
+static retro_time_t sched_tick_start = 0;   /* retro_run entry time */
+static int sched_video_us = 0;              /* video decode time this tick (0 = repeat tick) */
+static int sched_video_avg_us = 0;          /* running average over decoding ticks */
+static int sched_video_bytes = 0;           /* compressed size of the frame decoded this tick */
+static int sched_video_avg_bytes = 0;       /* running average over decoding ticks */
+static int sched_slice_us = 1000;           /* running average cost of one audio slice */
+static int sched_slice_counter = 0;
+
+/* Xvid auto deblocking: switched on while frames decode with time to spare,
+ * off as soon as one frame gets tight. Filtering runs in place on the output
+ * planes and skips finely quantized macroblocks */
+#define DEBLOCK_MIN_QUANT 4      /* macroblocks at or below this quant are not filtered */
+#define DEBLOCK_ON_FRAMES 30     /* frames in a row with slack before switching on */
+#define DEBLOCK_SLACK_PCT 60     /* slack = decode used at most this much of the frame budget */
+#define DEBLOCK_TIGHT_PCT 85     /* switch off when a frame uses more than this */
+static int deblock_active = 0;
+static int deblock_calm_frames = 0;
+static int deblock_last_underruns = 0;
+
+/* Xvid degradation when frames decode late: first XVID_DEC_FAST (no
+ * postprocessing, halfpel B-frame MC), then XVID_DEC_DROP as well (B-frames
+ * skipped). One step per run of late frames, back down after a calm spell */
+#define DEGRADE_LATE_PCT 100     /* a frame over its whole budget is late */
+#define DEGRADE_LATE_FRAMES 3    /* late frames in a row before stepping up */
+#define DEGRADE_CALM_PCT 50      /* calm = decode used at most this much of the budget */
+#define DEGRADE_CALM_FRAMES 90   /* calm frames in a row before stepping down */
+#define DEGRADE_FAST 1
+#define DEGRADE_DROP 2
+static int xvid_degrade = 0;     /* 0 = full quality, DEGRADE_FAST, DEGRADE_DROP */
+static int degrade_late_frames = 0;
+static int degrade_calm_frames = 0;
+static int degrade_last_underruns = 0;
+
+/* Xvid stage profile from xvid_dec_stats_t.prof: ticks summed over one
+ * second, shown as a share of total decode time in the debug panel */
+enum { XPROF_VLC, XPROF_PRED, XPROF_IQ, XPROF_IDCT, XPROF_XFER, XPROF_MC, XPROF_EDGE, XPROF_OUT, XPROF_STAGES };
+static uint32_t xprof_ticks[XPROF_STAGES];
+static uint32_t xprof_overall = 0;
+static int xprof_pct[XPROF_STAGES];
+static int xprof_valid = 0;        /* xprof_pct is from a profiled second */
+static int xprof_vops[5];          /* I, P, B, S, N VOPs since open */
+
+static pfile_t *video_file = NULL;
 static int is_playing = 0;
 static uint32_t clip_fps = 30;
 static uint32_t us_per_frame = 33333;
@@ -135,13 +365,76 @@ static uint32_t us_per_frame = 33333;
 /* 360000 frames = 6.6 hours at 15fps, 3.3 hours at 30fps */
 #define MAX_FRAMES 360000
 static uint32_t frame_offsets[MAX_FRAMES];
-static uint32_t frame_sizes[MAX_FRAMES];
+static uint32_t frame_sizes[MAX_FRAMES];   /* | FRAME_DELTA, read through frame_size() */
+#define FRAME_DELTA 0x80000000u            /* the index says: not a keyframe */
+#define AVIIF_KEYFRAME 0x10
 static int total_frames = 0;
+static int index_has_keys = 0;             /* some real frame is not FRAME_DELTA: the flags mean something */
 
 #define MAX_AUDIO_CHUNKS 360000
 static uint32_t audio_offsets[MAX_AUDIO_CHUNKS];
 static uint32_t audio_sizes[MAX_AUDIO_CHUNKS];
 static int total_audio_chunks = 0;
+static uint32_t max_frame_bytes = 0;  /* largest video chunk seen by the index */
+static uint32_t frame_hint_bytes = 0; /* strh dwSuggestedBufferSize, for chunks not indexed yet */
+static int header_frames = 0;         /* strh dwLength (or avih dwTotalFrames), for frames not indexed yet */
+
+/* Scratch for reading idx1 and ix## entries */
+static uint8_t index_buf[4096];
+
+/* Progressive indexing: idx1 entries or movi chunk headers are added a step
+ * at a time - the first seconds at open, the rest in the slack of retro_run
+ * ticks, or right away when a seek or playback gets ahead of it.
+ * The movi walk also plays damaged and partial files: a chunk header that
+ * makes no sense is skipped by searching for the next ##dc/##wb one, and a
+ * file that ends before its movi list does (a copy cut short, a download
+ * in progress) is polled for more chunks until its size stops growing */
+#define INDEX_DONE 0
+#define INDEX_IDX1 1              /* reading idx1 entries */
+#define INDEX_MOVI 2              /* walking the chunk headers of a movi list */
+#define INDEX_AVIX 3              /* looking for the next RIFF AVIX extension */
+#define INDEX_TAIL 4              /* movi walk at the end of the file, waiting for it to grow */
+#define INDEX_STEP 256            /* idx1 entries per step, a movi chunk counts 8 */
+#define INDEX_PRELOAD_SECONDS 10
+#define INDEX_TAIL_TICKS 30       /* retro_run ticks between polls of a short file */
+#define INDEX_CHUNK_MAX (16u << 20)  /* larger movi chunk sizes are taken as damage */
+#define INDEX_OPEN_END 0xFFFFFFFFu   /* movi size not written yet */
+static int index_mode = INDEX_DONE;
+static uint32_t index_pos = 0;    /* next idx1 entry / movi chunk header */
+static uint32_t index_end = 0;    /* end of the movi list */
+static uint32_t index_file_size = 0;  /* file length when the movi walk last asked */
+static int index_tail_wait = 0;   /* ticks to the next poll */
+static int index_resyncs = 0;     /* damaged spots skipped by the movi walk */
+static uint32_t index_left = 0;   /* idx1 entries not read yet */
+static uint32_t index_riff = 0;   /* where a RIFF AVIX extension would start */
+static uint32_t idx1_base = 0;    /* added to idx1 offsets to get the chunk data */
+static pfile_t *index_file = NULL;  /* own handle, so indexing doesn't evict the playback window */
+
+/* OpenDML (AVI 2.0) index: the indx super index in each strl lists one
+ * ix## standard index per RIFF segment. Only the segment headers are read
+ * at open; the entries land in the flat arrays above when first touched.
+ * For audio the indx durations also give each segment's length in bytes,
+ * so a seek only loads the segment it lands in. */
+#define ODML_MAX_SEGMENTS 256
+typedef struct {
+    uint64_t offset;   /* ix## chunk in the file */
+    uint64_t bytes;    /* stream bytes in it, from the indx duration */
+    uint64_t before;   /* stream bytes in the segments ahead of it */
+    int first;         /* its first entry in the flat arrays */
+    int count;
+    int loaded;
+} odml_seg_t;
+
+typedef struct {
+    odml_seg_t seg[ODML_MAX_SEGMENTS];
+    int segs;          /* 0 = stream not indexed through OpenDML */
+    int last;          /* segment of the previous lookup */
+    uint32_t sample_size;  /* strh dwSampleSize: bytes per indx duration tick, 0 = none */
+    int sized;         /* bytes/before hold: no loaded segment disagreed */
+} odml_index_t;
+
+static odml_index_t odml_video;
+static odml_index_t odml_audio;
 
 /* Frame index - single index, no buffering */
 static int current_frame_idx = 0;
@@ -156,6 +449,7 @@ static uint32_t total_audio_bytes = 0;
 #define AUDIO_FMT_PCM    1
 #define AUDIO_FMT_ADPCM  2
 #define AUDIO_FMT_MP3    3
+#define AUDIO_FMT_IMA    4  /* IMA/DVI ADPCM (0x11) */
 static int audio_format = 0;
 static int audio_channels = 0;
 static int audio_sample_rate = 0;
@@ -177,13 +471,30 @@ static const int adpcm_adapt_table[16] = {
 static const int adpcm_coef1[7] = { 256, 512, 0, 192, 240, 460, 392 };
 static const int adpcm_coef2[7] = { 0, -256, 0, 64, 0, -208, -232 };
 
-/* ADPCM decoder state (per channel) */
-static int adpcm_sample1[2] = {0, 0};
-static int adpcm_sample2[2] = {0, 0};
-static int adpcm_delta[2] = {0, 0};
-static int adpcm_coef_idx[2] = {0, 0};
+/* Sign-extended value of each 4-bit ADPCM nibble */
+static const int adpcm_nibble_signed[16] = {
+    0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1
+};
+
+/* IMA ADPCM step size table (89 entries) */
+static const int16_t ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/* IMA ADPCM step index adjustment per nibble */
+static const int8_t ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
 
-/* Decode buffer for ADPCM */
+/* Decode buffer for ADPCM - only used for blocks that straddle the ring wrap */
 #define ADPCM_DECODE_BUF_SIZE 16384  /* Large enough for 44kHz stereo blocks */
 static int16_t adpcm_decode_buf[ADPCM_DECODE_BUF_SIZE];
 
@@ -204,6 +515,28 @@ static int mp3_input_remaining = 0; /* Bytes not yet consumed */
 #define MP3_DECODE_BUF_SIZE 8192
 static int16_t mp3_decode_buf[MP3_DECODE_BUF_SIZE];
 
+/* MP3 seek index: cumulative sample count at the start of every audio chunk.
+ * Built lazily by walking Layer III frame headers (nothing is decoded), so it
+ * stays exact for VBR and for muxers that pack several frames per chunk.
+ * If the first chunks all hold exactly one whole frame, the file is treated
+ * as "chunk N starts at sample N*spf" and the table is dropped again. */
+#define MP3_INDEX_PROBE_CHUNKS 64
+#define MP3_INDEX_STEP 256             /* chunks indexed per extension step */
+#define MP3_INDEX_NO_FRAME 0xFFFF
+static uint32_t *mp3_index_samples = NULL; /* [chunk] = samples of frames starting before chunk */
+static uint16_t *mp3_index_first = NULL;   /* [chunk] = offset of first frame header in chunk */
+static int mp3_index_chunks = 0;           /* chunks indexed so far */
+static int mp3_index_cap = 0;              /* chunks the tables have room for */
+static uint32_t mp3_index_total = 0;       /* samples of all frames indexed so far */
+static uint32_t mp3_index_carry = 0;       /* bytes of last frame spilling into next chunk */
+static int mp3_index_spf = 0;              /* samples per frame: 1152 (MPEG-1) or 576 */
+static int mp3_index_probed = 0;
+static int mp3_index_one_per_chunk = 0;    /* probed layout: one whole frame per chunk */
+static int mp3_index_failed = 0;           /* no usable headers - fall back to estimate */
+
+/* Decoded samples to throw away after a seek (reservoir frame + offset into target frame) */
+static uint32_t mp3_skip_samples = 0;
+
 /* MP3 debug counters */
 static int mp3_debug_frames = 0;      /* Frames decoded */
 static int mp3_debug_errors = 0;      /* Decode errors */
@@ -225,97 +558,152 @@ static inline int16_t clamp16(int v) {
     return (int16_t)v;
 }
 
-/* Decode one MS ADPCM sample - nibble is unsigned 0-15 */
-static inline int16_t decode_adpcm_sample(int nibble, int ch) {
-    /* Save unsigned nibble for adaptation table lookup */
-    int unsigned_nibble = nibble & 0xF;
-
-    /* Calculate predictor from previous samples */
-    int pred = ((adpcm_sample1[ch] * adpcm_coef1[adpcm_coef_idx[ch]]) +
-                (adpcm_sample2[ch] * adpcm_coef2[adpcm_coef_idx[ch]])) >> 8;
-
-    /* Sign extend nibble: 0-7 stays, 8-15 becomes -8 to -1 */
-    int signed_nibble = (nibble & 0x8) ? (nibble - 16) : nibble;
-
-    /* Calculate sample */
-    int sample = pred + signed_nibble * adpcm_delta[ch];
-    sample = clamp16(sample);
-
-    /* Update sample history */
-    adpcm_sample2[ch] = adpcm_sample1[ch];
-    adpcm_sample1[ch] = sample;
-
-    /* Adapt delta using UNSIGNED nibble for table lookup */
-    adpcm_delta[ch] = (adpcm_adapt_table[unsigned_nibble] * adpcm_delta[ch]) >> 8;
-    if (adpcm_delta[ch] < 16) adpcm_delta[ch] = 16;
-
-    return sample;
-}
-
-/* Decode one MS ADPCM block (mono) */
-static int decode_adpcm_block_mono(uint8_t *src, int src_size, int16_t *dst, int max_samples) {
+/* One MS ADPCM step on register-held predictor state: decode nibble n,
+ * write the sample to out and adapt delta through the table */
+#define ADPCM_STEP(n, s1, s2, delta, c1, c2, out) do {                 \
+    int smp_ = (((s1) * (c1) + (s2) * (c2)) >> 8) +                    \
+               adpcm_nibble_signed[n] * (delta);                       \
+    if ((unsigned)(smp_ + 32768) > 65535) smp_ = (smp_ < 0) ? -32768 : 32767; \
+    (s2) = (s1);                                                       \
+    (s1) = smp_;                                                       \
+    (out) = (int16_t)smp_;                                             \
+    (delta) = (adpcm_adapt_table[n] * (delta)) >> 8;                   \
+    if ((delta) < 16) (delta) = 16;                                    \
+} while (0)
+
+/* Decode one MS ADPCM block (mono). dst must hold 2 + 2 * (src_size - 7) samples */
+static int decode_adpcm_block_mono(const uint8_t *src, int src_size, int16_t *dst) {
     if (src_size < 7) return 0;  /* Minimum block header */
 
     /* Block header: predictor(1) + delta(2) + sample1(2) + sample2(2) = 7 bytes */
-    adpcm_coef_idx[0] = src[0];
-    if (adpcm_coef_idx[0] > 6) adpcm_coef_idx[0] = 0;
-
-    adpcm_delta[0] = (int16_t)(src[1] | (src[2] << 8));
-    adpcm_sample1[0] = (int16_t)(src[3] | (src[4] << 8));
-    adpcm_sample2[0] = (int16_t)(src[5] | (src[6] << 8));
-
-    int out_idx = 0;
+    int ci = (src[0] > 6) ? 0 : src[0];
+    int c1 = adpcm_coef1[ci];
+    int c2 = adpcm_coef2[ci];
+    int delta = (int16_t)(src[1] | (src[2] << 8));
+    int s1 = (int16_t)(src[3] | (src[4] << 8));
+    int s2 = (int16_t)(src[5] | (src[6] << 8));
 
     /* First two samples from header (in reverse order) */
-    if (out_idx < max_samples) dst[out_idx++] = adpcm_sample2[0];
-    if (out_idx < max_samples) dst[out_idx++] = adpcm_sample1[0];
-
-    /* Decode nibbles */
-    for (int i = 7; i < src_size && out_idx < max_samples; i++) {
-        dst[out_idx++] = decode_adpcm_sample((src[i] >> 4) & 0xF, 0);
-        if (out_idx < max_samples)
-            dst[out_idx++] = decode_adpcm_sample(src[i] & 0xF, 0);
+    dst[0] = s2;
+    dst[1] = s1;
+    int16_t *out = dst + 2;
+
+    /* Two samples per byte, high nibble first */
+    const uint8_t *p = src + 7;
+    const uint8_t *end = src + src_size;
+    while (p < end) {
+        int b = *p++;
+        ADPCM_STEP(b >> 4, s1, s2, delta, c1, c2, out[0]);
+        ADPCM_STEP(b & 0xF, s1, s2, delta, c1, c2, out[1]);
+        out += 2;
     }
 
-    return out_idx;
+    return out - dst;
 }
 
-/* Decode one MS ADPCM block (stereo) */
-static int decode_adpcm_block_stereo(uint8_t *src, int src_size, int16_t *dst, int max_samples) {
+/* Decode one MS ADPCM block (stereo). dst must hold 4 + 2 * (src_size - 14) samples */
+static int decode_adpcm_block_stereo(const uint8_t *src, int src_size, int16_t *dst) {
     if (src_size < 14) return 0;  /* Minimum stereo block header */
 
     /* Block header for stereo: pred0, pred1, delta0(2), delta1(2), s1_0(2), s1_1(2), s2_0(2), s2_1(2) = 14 bytes */
-    adpcm_coef_idx[0] = src[0];
-    adpcm_coef_idx[1] = src[1];
-    if (adpcm_coef_idx[0] > 6) adpcm_coef_idx[0] = 0;
-    if (adpcm_coef_idx[1] > 6) adpcm_coef_idx[1] = 0;
-
-    adpcm_delta[0] = (int16_t)(src[2] | (src[3] << 8));
-    adpcm_delta[1] = (int16_t)(src[4] | (src[5] << 8));
-    adpcm_sample1[0] = (int16_t)(src[6] | (src[7] << 8));
-    adpcm_sample1[1] = (int16_t)(src[8] | (src[9] << 8));
-    adpcm_sample2[0] = (int16_t)(src[10] | (src[11] << 8));
-    adpcm_sample2[1] = (int16_t)(src[12] | (src[13] << 8));
-
-    int out_idx = 0;
+    int ci_l = (src[0] > 6) ? 0 : src[0];
+    int ci_r = (src[1] > 6) ? 0 : src[1];
+    int c1_l = adpcm_coef1[ci_l], c2_l = adpcm_coef2[ci_l];
+    int c1_r = adpcm_coef1[ci_r], c2_r = adpcm_coef2[ci_r];
+    int delta_l = (int16_t)(src[2] | (src[3] << 8));
+    int delta_r = (int16_t)(src[4] | (src[5] << 8));
+    int s1_l = (int16_t)(src[6] | (src[7] << 8));
+    int s1_r = (int16_t)(src[8] | (src[9] << 8));
+    int s2_l = (int16_t)(src[10] | (src[11] << 8));
+    int s2_r = (int16_t)(src[12] | (src[13] << 8));
 
     /* First two sample pairs from header */
-    if (out_idx + 1 < max_samples) {
-        dst[out_idx++] = adpcm_sample2[0];
-        dst[out_idx++] = adpcm_sample2[1];
+    dst[0] = s2_l;
+    dst[1] = s2_r;
+    dst[2] = s1_l;
+    dst[3] = s1_r;
+    int16_t *out = dst + 4;
+
+    /* Decode nibble pairs (L in high nibble, R in low nibble) */
+    const uint8_t *p = src + 14;
+    const uint8_t *end = src + src_size;
+    while (p < end) {
+        int b = *p++;
+        ADPCM_STEP(b >> 4, s1_l, s2_l, delta_l, c1_l, c2_l, out[0]);
+        ADPCM_STEP(b & 0xF, s1_r, s2_r, delta_r, c1_r, c2_r, out[1]);
+        out += 2;
     }
-    if (out_idx + 1 < max_samples) {
-        dst[out_idx++] = adpcm_sample1[0];
-        dst[out_idx++] = adpcm_sample1[1];
+
+    return out - dst;
+}
+
+/* One IMA ADPCM step: predictor += (magnitude + 0.5) * step / 4, sign in bit 3.
+ * Single multiply instead of the reference shift-add chain, rounding the same
+ * way as the ffmpeg encoder's model of the decoder */
+#define IMA_STEP(n, pred, idx, out) do {                               \
+    int diff_ = ((2 * ((n) & 7) + 1) * ima_step_table[idx]) >> 3;      \
+    (pred) += ((n) & 8) ? -diff_ : diff_;                              \
+    if ((unsigned)((pred) + 32768) > 65535) (pred) = ((pred) < 0) ? -32768 : 32767; \
+    (out) = (int16_t)(pred);                                           \
+    (idx) += ima_index_table[n];                                       \
+    if ((idx) < 0) (idx) = 0; else if ((idx) > 88) (idx) = 88;         \
+} while (0)
+
+/* Decode one IMA ADPCM block (mono). dst must hold 1 + 2 * (src_size - 4) samples */
+static int decode_ima_block_mono(const uint8_t *src, int src_size, int16_t *dst) {
+    if (src_size < 4) return 0;  /* Minimum block header */
+
+    /* Block header: sample(2) + step index(1) + reserved(1) = 4 bytes */
+    int pred = (int16_t)(src[0] | (src[1] << 8));
+    int idx = (src[2] > 88) ? 88 : src[2];
+
+    dst[0] = pred;
+    int16_t *out = dst + 1;
+
+    /* Two samples per byte, low nibble first */
+    const uint8_t *p = src + 4;
+    const uint8_t *end = src + src_size;
+    while (p < end) {
+        int b = *p++;
+        IMA_STEP(b & 0xF, pred, idx, out[0]);
+        IMA_STEP(b >> 4, pred, idx, out[1]);
+        out += 2;
     }
 
-    /* Decode nibble pairs (L in high nibble, R in low nibble) */
-    for (int i = 14; i < src_size && out_idx + 1 < max_samples; i++) {
-        dst[out_idx++] = decode_adpcm_sample((src[i] >> 4) & 0xF, 0);
-        dst[out_idx++] = decode_adpcm_sample(src[i] & 0xF, 1);
+    return out - dst;
+}
+
+/* Decode one IMA ADPCM block (stereo). dst must hold 2 + 2 * (src_size - 8) samples */
+static int decode_ima_block_stereo(const uint8_t *src, int src_size, int16_t *dst) {
+    if (src_size < 8) return 0;  /* Minimum stereo block header */
+
+    /* One 4-byte header per channel (L then R) */
+    int pred_l = (int16_t)(src[0] | (src[1] << 8));
+    int idx_l = (src[2] > 88) ? 88 : src[2];
+    int pred_r = (int16_t)(src[4] | (src[5] << 8));
+    int idx_r = (src[6] > 88) ? 88 : src[6];
+
+    dst[0] = pred_l;
+    dst[1] = pred_r;
+    int16_t *out = dst + 2;
+
+    /* Data comes in 8-byte groups: 4 bytes (8 samples) L, then 4 bytes R */
+    const uint8_t *p = src + 8;
+    const uint8_t *end = src + 8 + ((src_size - 8) & ~7);
+    while (p < end) {
+        for (int i = 0; i < 4; i++) {
+            int l = p[i];
+            int r = p[i + 4];
+            IMA_STEP(l & 0xF, pred_l, idx_l, out[0]);
+            IMA_STEP(r & 0xF, pred_r, idx_r, out[1]);
+            IMA_STEP(l >> 4, pred_l, idx_l, out[2]);
+            IMA_STEP(r >> 4, pred_r, idx_r, out[3]);
+            out += 4;
+        }
+        p += 8;
     }
 
-    return out_idx;
+    return out - dst;
 }
 
 /* Repeat timing (15fps content on 30fps display) */
@@ -404,6 +792,7 @@ static int prev_down = 0;
 static int show_time = 1;     /* time display visible (ON by default) */
 static int show_debug = 0;    /* debug panel visible (OFF by default) */
 static int seek_position = 0;  /* 0-20 (0%, 5%, 10%, ... 100%) */
+static int seek_pending = 0;   /* slider moved on a preview, seek not done yet */
 static int was_paused_before_menu = 0;  /* remember pause state */
 static int submenu_active = 0;  /* 0=none, 1=instructions, 2=greetings, 3=file browser */
 static int save_feedback_timer = 0;  /* frames to show "Settings Saved" message */
@@ -423,7 +812,6 @@ static const char *menu_labels[MENU_ITEMS] = {
 };
 
 /* File browser */
-#define FB_MAX_FILES 64
 #define FB_MAX_PATH 256
 #define FB_MAX_NAME 128
 #define FB_VISIBLE_ITEMS 15
@@ -433,8 +821,30 @@ static const char *menu_labels[MENU_ITEMS] = {
 static int file_browser_active = 0;
 static char fb_current_path[FB_MAX_PATH] = FB_START_PATH;
 static char system_directory[FB_MAX_PATH] = "";
-static char fb_files[FB_MAX_FILES][FB_MAX_NAME];
-static int fb_is_dir[FB_MAX_FILES];  /* 1 = directory, 0 = file */
+
+/* What a header-only parse of an AVI tells the browser */
+#define FB_META_NONE 0   /* not probed yet */
+#define FB_META_OK   1
+#define FB_META_BAD  2   /* not an AVI we could read, not cached */
+typedef struct {
+    uint8_t state;
+    char fourcc[5];
+    uint16_t width, height;
+    uint16_t audio_tag;       /* WAVE format tag, 0 = no audio */
+    uint32_t audio_rate;
+    uint32_t frames;          /* dmlh total for OpenDML files, else avih */
+    uint32_t us_per_frame;
+} fb_meta_t;
+
+typedef struct {
+    char name[FB_MAX_NAME];
+    uint8_t is_dir;
+    fb_meta_t meta;
+} fb_entry_t;
+
+/* Directory listing, grown as needed (no entry cap) */
+static fb_entry_t *fb_entries = NULL;
+static int fb_entries_cap = 0;
 static int fb_file_count = 0;
 static int fb_selection = 0;
 static int fb_scroll = 0;
@@ -448,6 +858,53 @@ static int fb_last_selection = -1;   /* to reset scroll on selection change */
 #define FB_NAME_SCROLL_DELAY 8       /* frames between scroll steps */
 static char loaded_file_path[FB_MAX_PATH] = "";
 
+/* Seek preview: one small picture per Go to Position step, built from
+ * keyframes while paused and kept next to the video in <file>.thm.
+ * MJPEG is decoded at 1/8 scale (DC only), Xvid from the nearest I-VOP
+ * at or before the step on a second decoder that only lives while the
+ * strip is built. */
+#define THUMB_W 40
+#define THUMB_H 30
+#define THUMB_COUNT 21            /* seek_position 0..20 */
+#define THUMB_KEY_SEARCH 900      /* chunks searched back for an I-VOP */
+#define THUMB_MAGIC 0x48543041    /* "A0TH" */
+#define THUMB_VERSION 1
+typedef struct {
+    uint32_t magic;
+    uint16_t version, count;
+    uint16_t width, height;
+    uint32_t frames;              /* the file it was made for: frame count */
+    uint32_t last_offset;         /* and where its last chunk is */
+    uint32_t last_size;
+    int32_t frame[THUMB_COUNT];   /* frame each preview shows, THUMB_NONE if none */
+} thumb_header_t;                 /* followed by THUMB_COUNT pictures, host byte order */
+#define THUMB_NONE (-1)
+#define THUMB_TODO (-2)
+static pixel_t thumb_pixels[THUMB_COUNT][THUMB_W * THUMB_H];
+static int thumb_frame[THUMB_COUNT];  /* frame shown, THUMB_NONE or THUMB_TODO */
+static int thumb_next = THUMB_COUNT;  /* every step before it has been tried */
+static int thumb_built = 0;           /* steps decoded since the file was opened */
+static int thumb_checked = 0;         /* sidecar looked at */
+static char thumb_path[FB_MAX_PATH];
+static void *thumb_xvid = NULL;       /* preview decoder (Xvid files only) */
+static uint8_t *thumb_yuv = NULL;     /* its output planes */
+
+/* Frames the Go to Position slider spans: the header's length while the
+   index is still growing, so 100% is the end of the file and not of the
+   part indexed so far */
+static int slider_total(void) {
+    if (index_mode != INDEX_DONE && header_frames > total_frames) return header_frames;
+    return total_frames;
+}
+
+/* Frame the Go to Position slider points at: the keyframe of its preview
+   when there is one */
+static int slider_frame(void) {
+    int total = slider_total();
+    if (thumb_frame[seek_position] >= 0) return thumb_frame[seek_position];
+    return (total > 0) ? (int)((int64_t)seek_position * total / 20) : 0;
+}
+
 /* Visual feedback icons */
 #define ICON_NONE 0
 #define ICON_SKIP_LEFT 1
@@ -462,12 +919,32 @@ static char loaded_file_path[FB_MAX_PATH] = "";
 static int icon_type = ICON_NONE;
 static int icon_timer = 0;
 
+/* Scrubbing: holding Left/Right moves a cursor through the index and shows
+   only frames that decode on their own. Audio waits for the one seek on
+   release. Speed is a multiple of real time, doubled as the hold goes on */
+#define SCRUB_HOLD_TICKS 10       /* held this long after the 15 s skip */
+#define SCRUB_ACCEL_TICKS 15      /* speed doubles every half second */
+#define SCRUB_START_SPEED 4
+#define SCRUB_MAX_SPEED 256       /* two hours pass in under half a minute */
+#define SCRUB_KEY_SEARCH 300      /* chunks searched back for a keyframe */
+#define SCRUB_KEY_READS 16        /* chunks read per tick in that search (no keyframe flags) */
+static int scrub_dir = 0;         /* direction held: -1, 0 or 1 */
+static int scrub_ticks = 0;
+static int scrub_active = 0;
+static int scrub_cursor = 0;
+static int scrub_shown = -1;      /* frame on screen */
+static int scrub_key_pos = -1;    /* keyframe search: next chunk to look at, -1 = none running */
+static int scrub_key_end = 0;     /* and where it stops */
+static int scrub_speed = 0;
+static uint32_t scrub_acc = 0;    /* frames * DISPLAY_FPS not moved yet */
+
 /* Debug stats */
 static int run_counter = 0;
 static int decode_counter = 0;
 static int runs_per_sec = 0;
 static int decodes_per_sec = 0;
 static int sec_counter = 0;
+static int slices_per_sec = 0;
 
 /* Video scaling (for small videos) */
 static int video_width = 320;   /* detected from first frame */
@@ -476,7 +953,7 @@ static int scale_factor = 1;    /* 1, 2, or 3 */
 static int offset_x = 0;        /* centering offset */
 static int offset_y = 0;
 
-typedef struct { uint8_t *data; uint32_t size; uint32_t pos; } jpeg_io_t;
+typedef struct { uint8_t *data; uint32_t size; uint32_t pos; uint32_t file_off; } jpeg_io_t;  /* data NULL: stream from file_off */
 static jpeg_io_t jpeg_io;
 
 /* Font 5x7 */
@@ -946,8 +1423,10 @@ static void draw_icon(int type) {
 
 /* Forward declarations */
 static int decode_single_frame(int idx);
+static int avi_probe(const char *path, fb_meta_t *m);
 static int load_avi_file(const char *path);
 static void update_av_info(void);
+static int keyframe_before(int idx, int limit);
 
 /* ========== Settings save/load ========== */
 static void save_settings(void) {
@@ -974,8 +1453,11 @@ static void save_settings(void) {
         "xvid_black=%d\n"
         "show_time=%d\n"
         "show_debug=%d\n"
+        "xvid_fast_mc=%d\n"
+        "xvid_threads=%d\n"
         "last_dir=%s\n",
-        color_mode, xvid_black_level, show_time, show_debug, fb_current_path);
+        color_mode, xvid_black_level, show_time, show_debug, xvid_fast_mc, xvid_threads,
+        fb_current_path);
 
     fs_write(fd, buf, len);
     fs_close(fd);
@@ -1032,6 +1514,14 @@ static void load_settings(void) {
             else if (strcmp(key, "show_debug") == 0) {
                 show_debug = (val[0] == '1') ? 1 : 0;
             }
+            else if (strcmp(key, "xvid_fast_mc") == 0) {
+                xvid_fast_mc = (val[0] == '1') ? 1 : 0;
+            }
+            else if (strcmp(key, "xvid_threads") == 0) {
+                int v = 0;
+                while (*val >= '0' && *val <= '9') v = v * 10 + (*val++ - '0');
+                xvid_threads = v > XVID_MAX_THREADS ? XVID_MAX_THREADS : v;
+            }
             else if (strcmp(key, "last_dir") == 0) {
                 strncpy(fb_current_path, val, FB_MAX_PATH - 1);
                 fb_current_path[FB_MAX_PATH - 1] = '\0';
@@ -1120,6 +1610,207 @@ static void polish_to_latin(const char *src, char *dst, int max_len) {
     dst[j] = '\0';
 }
 
+/* ========== Directory cache ==========
+ * Each directory gets a small text file with the AVI metadata the browser
+ * shows (duration, codecs, resolution, fps), so files are header-parsed
+ * once, not on every visit. fs_readdir gives no mtime or size, so the
+ * listing itself is the validator: names that appeared get probed in the
+ * slack of browser ticks, names that disappeared are dropped, and the file
+ * is rewritten when anything changed. */
+#define FB_CACHE_NAME "a0player.dir"
+#define FB_CACHE_HEADER "# A ZERO Player directory cache 1\n"
+
+static char fb_listed_path[FB_MAX_PATH] = "";  /* directory fb_entries belong to */
+static int fb_cache_dirty = 0;    /* fb_entries differ from the cache file */
+static int fb_probe_next = 0;     /* first entry that may still need probing */
+
+static int fb_name_cmp(const char *a, const char *b) {
+    int c = strcasecmp(a, b);
+    return c ? c : strcmp(a, b);
+}
+
+/* ".." first, then directories, then files, each by name */
+static int fb_entry_cmp(const void *pa, const void *pb) {
+    const fb_entry_t *a = (const fb_entry_t *)pa, *b = (const fb_entry_t *)pb;
+    if (strcmp(a->name, "..") == 0) return -1;
+    if (strcmp(b->name, "..") == 0) return 1;
+    if (a->is_dir != b->is_dir) return a->is_dir ? -1 : 1;
+    return fb_name_cmp(a->name, b->name);
+}
+
+static fb_entry_t *fb_add_entry(const char *name, int is_dir) {
+    if (fb_file_count == fb_entries_cap) {
+        int cap = fb_entries_cap ? fb_entries_cap * 2 : 64;
+        fb_entry_t *p = (fb_entry_t *)realloc(fb_entries, cap * sizeof(fb_entry_t));
+        if (!p) return NULL;
+        fb_entries = p;
+        fb_entries_cap = cap;
+    }
+    fb_entry_t *e = &fb_entries[fb_file_count++];
+    memset(e, 0, sizeof(*e));
+    strncpy(e->name, name, FB_MAX_NAME - 1);
+    e->is_dir = is_dir;
+    return e;
+}
+
+static fb_entry_t *fb_find_file(const char *name) {
+    int lo = 0, hi = fb_file_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        fb_entry_t *e = &fb_entries[mid];
+        int c = e->is_dir ? 1 : fb_name_cmp(name, e->name);  /* files sort after directories */
+        if (c == 0) return e;
+        if (c < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return NULL;
+}
+
+/* Returns 0 if the path does not fit */
+static int fb_cache_path(char *out, const char *dir) {
+    return snprintf(out, FB_MAX_PATH, "%s/%s", dir, FB_CACHE_NAME) < FB_MAX_PATH;
+}
+
+/* Fill in metadata from the directory's cache file. Marks the cache dirty
+   if it lists files that are gone (or there is none) */
+static void fb_cache_load(void) {
+    char path[FB_MAX_PATH];
+    int64_t size;
+    char *buf;
+    int fd, records = 0, matched = 0;
+
+    if (!fb_cache_path(path, fb_current_path)) return;
+    fd = fs_open(path, FS_O_RDONLY, 0);
+    if (fd < 0) {
+        fb_cache_dirty = 1;
+        return;
+    }
+    size = fs_lseek(fd, 0, SEEK_END);
+    fs_lseek(fd, 0, SEEK_SET);
+    buf = (size > 0 && size < 4 * 1024 * 1024) ? (char *)malloc(size + 1) : NULL;
+    if (!buf || fs_read(fd, buf, size) != size) {
+        free(buf);
+        fs_close(fd);
+        fb_cache_dirty = 1;
+        return;
+    }
+    fs_close(fd);
+    buf[size] = '\0';
+
+    if (strncmp(buf, FB_CACHE_HEADER, strlen(FB_CACHE_HEADER)) != 0) {
+        free(buf);
+        fb_cache_dirty = 1;  /* other version - rebuild */
+        return;
+    }
+
+    /* name TAB state frames us_per_frame fourcc width height audio_tag audio_rate */
+    char *line = buf + strlen(FB_CACHE_HEADER);
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        char *tab = strchr(line, '\t');
+        if (tab) {
+            *tab = '\0';
+            records++;
+            fb_entry_t *e = fb_find_file(line);
+            if (e) {
+                char fourcc[8] = "";
+                unsigned state = 0, frames = 0, usf = 0, w = 0, h = 0, tag = 0, rate = 0;
+                if (sscanf(tab + 1, "%u %u %u %7s %u %u %u %u", &state, &frames, &usf, fourcc,
+                           &w, &h, &tag, &rate) == 8 && state == FB_META_OK) {
+                    e->meta.state = state;
+                    e->meta.frames = frames;
+                    e->meta.us_per_frame = usf;
+                    memcpy(e->meta.fourcc, fourcc, 4);
+                    e->meta.fourcc[4] = '\0';
+                    e->meta.width = w;
+                    e->meta.height = h;
+                    e->meta.audio_tag = tag;
+                    e->meta.audio_rate = rate;
+                    matched++;
+                }
+            }
+        }
+        line = next;
+    }
+    free(buf);
+
+    if (matched != records) fb_cache_dirty = 1;
+}
+
+/* Write the probed entries of the listed directory back to its cache file.
+   Directories without videos (the SD root, ROM folders) get none. Files
+   that failed the probe are left out: one still being copied is probed
+   again the next time the directory is listed */
+static void fb_cache_flush(void) {
+    char path[FB_MAX_PATH];
+    char *buf, *p;
+    int fd, records = 0;
+
+    if (!fb_cache_dirty || !fb_listed_path[0]) return;
+    fb_cache_dirty = 0;
+    if (!fb_cache_path(path, fb_listed_path)) return;
+
+    buf = (char *)malloc(strlen(FB_CACHE_HEADER) + fb_file_count * (FB_MAX_NAME + 80) + 1);
+    if (!buf) return;
+    p = buf + sprintf(buf, "%s", FB_CACHE_HEADER);
+    for (int i = 0; i < fb_file_count; i++) {
+        fb_entry_t *e = &fb_entries[i];
+        if (e->is_dir || e->meta.state != FB_META_OK) continue;
+        p += sprintf(p, "%s\t%u %u %u %s %u %u %u %u\n", e->name, (unsigned)e->meta.state,
+                     (unsigned)e->meta.frames, (unsigned)e->meta.us_per_frame,
+                     e->meta.fourcc[0] ? e->meta.fourcc : "-", (unsigned)e->meta.width,
+                     (unsigned)e->meta.height, (unsigned)e->meta.audio_tag, (unsigned)e->meta.audio_rate);
+        records++;
+    }
+
+    fd = records ? fs_open(path, FS_O_WRONLY | FS_O_CREAT | FS_O_TRUNC, 0666) : -1;
+    if (fd >= 0) {
+        fs_write(fd, buf, p - buf);
+        fs_close(fd);
+    }
+    free(buf);
+}
+
+/* Probe files that have no metadata yet - the selected one first - in what
+   is left of the tick (one file without a clock). Flushes when all done */
+static void fb_meta_step(void) {
+    retro_time_t deadline = sched_tick_start +
+                            (1000000 / DISPLAY_FPS) * (100 - AUDIO_TICK_RESERVE_PCT) / 100;
+    int more;
+
+    while (fb_probe_next < fb_file_count &&
+           (fb_entries[fb_probe_next].is_dir || fb_entries[fb_probe_next].meta.state != FB_META_NONE)) {
+        fb_probe_next++;
+    }
+    if (fb_probe_next >= fb_file_count) {
+        fb_cache_flush();
+        return;
+    }
+
+    do {
+        fb_entry_t *e = NULL;
+        char full_path[FB_MAX_PATH];
+
+        if (fb_selection < fb_file_count && !fb_entries[fb_selection].is_dir &&
+            fb_entries[fb_selection].meta.state == FB_META_NONE) {
+            e = &fb_entries[fb_selection];
+        } else {
+            while (fb_probe_next < fb_file_count &&
+                   (fb_entries[fb_probe_next].is_dir || fb_entries[fb_probe_next].meta.state != FB_META_NONE)) {
+                fb_probe_next++;
+            }
+            if (fb_probe_next >= fb_file_count) break;
+            e = &fb_entries[fb_probe_next];
+        }
+
+        if (snprintf(full_path, FB_MAX_PATH, "%s/%s", fb_listed_path, e->name) >= FB_MAX_PATH ||
+            !avi_probe(full_path, &e->meta)) e->meta.state = FB_META_BAD;
+        if (e->meta.state == FB_META_OK) fb_cache_dirty = 1;
+        more = perf_get_time_usec && perf_get_time_usec() < deadline;
+    } while (more);
+}
+
 static void fb_scan_directory(void) {
     /* fs_readdir buffer structure */
     union {
@@ -1134,9 +1825,15 @@ static void fb_scan_directory(void) {
         uint8_t __[0x428];
     } buffer;
 
+    /* Keep what was probed in the directory we are leaving */
+    fb_cache_flush();
+
     fb_file_count = 0;
     fb_selection = 0;
     fb_scroll = 0;
+    fb_probe_next = 0;
+    fb_cache_dirty = 0;
+    fb_listed_path[0] = '\0';
 
     int dir_fd = fs_opendir(fb_current_path);
     if (dir_fd < 0) {
@@ -1148,13 +1845,11 @@ static void fb_scan_directory(void) {
 
     /* First add ".." entry if not at root */
     if (strcmp(fb_current_path, "/mnt/sda1") != 0) {
-        strcpy(fb_files[fb_file_count], "..");
-        fb_is_dir[fb_file_count] = 1;
-        fb_file_count++;
+        fb_add_entry("..", 1);
     }
 
     /* Read directory entries */
-    while (fb_file_count < FB_MAX_FILES) {
+    while (1) {
         memset(&buffer, 0, sizeof(buffer));
         if (fs_readdir(dir_fd, &buffer) < 0) break;
 
@@ -1171,22 +1866,23 @@ static void fb_scan_directory(void) {
         /* Only show directories and .avi files */
         if (!is_dir && !is_avi) continue;
 
-        /* Copy filename (truncate if needed) */
-        strncpy(fb_files[fb_file_count], buffer.d_name, FB_MAX_NAME - 1);
-        fb_files[fb_file_count][FB_MAX_NAME - 1] = '\0';
-        fb_is_dir[fb_file_count] = is_dir;
-        fb_file_count++;
+        /* Copy filename (truncated if needed) */
+        if (!fb_add_entry(buffer.d_name, is_dir)) break;
     }
 
     fs_closedir(dir_fd);
+
+    if (fb_file_count > 1) qsort(fb_entries, fb_file_count, sizeof(fb_entry_t), fb_entry_cmp);
+    strcpy(fb_listed_path, fb_current_path);
+    fb_cache_load();
 }
 
 static void fb_enter_selected(void) {
     if (fb_file_count == 0) return;
 
-    if (fb_is_dir[fb_selection]) {
+    if (fb_entries[fb_selection].is_dir) {
         /* Enter directory */
-        if (strcmp(fb_files[fb_selection], "..") == 0) {
+        if (strcmp(fb_entries[fb_selection].name, "..") == 0) {
             /* Go up - find last / */
             char *last_slash = strrchr(fb_current_path, '/');
             if (last_slash && last_slash != fb_current_path) {
@@ -1195,17 +1891,19 @@ static void fb_enter_selected(void) {
         } else {
             /* Enter subdirectory */
             int len = strlen(fb_current_path);
-            if (len + 1 + strlen(fb_files[fb_selection]) < FB_MAX_PATH) {
+            if (len + 1 + strlen(fb_entries[fb_selection].name) < FB_MAX_PATH) {
                 strcat(fb_current_path, "/");
-                strcat(fb_current_path, fb_files[fb_selection]);
+                strcat(fb_current_path, fb_entries[fb_selection].name);
             }
         }
         fb_scan_directory();
     } else {
         /* Load file */
         char full_path[FB_MAX_PATH];
-        snprintf(full_path, FB_MAX_PATH, "%s/%s", fb_current_path, fb_files[fb_selection]);
+        if (snprintf(full_path, FB_MAX_PATH, "%s/%s", fb_current_path, fb_entries[fb_selection].name) >= FB_MAX_PATH)
+            return;  /* path too long to open */
 
+        fb_cache_flush();
         if (load_avi_file(full_path) == 0) {
             /* Success - close file browser and menu */
             strcpy(loaded_file_path, full_path);
@@ -1217,6 +1915,35 @@ static void fb_enter_selected(void) {
     }
 }
 
+/* One line for the browser: "1:23:45 XVID 320x240 15fps MP3 22k" */
+static void fb_meta_format(const fb_meta_t *m, char *out, int size) {
+    const char *audio;
+    uint32_t secs, fps;
+
+    if (m->state == FB_META_NONE) { snprintf(out, size, "..."); return; }
+    if (m->state == FB_META_BAD) { snprintf(out, size, "Not a readable AVI"); return; }
+
+    secs = m->us_per_frame ? (uint32_t)((uint64_t)m->frames * m->us_per_frame / 1000000) : 0;
+    fps = m->us_per_frame ? (1000000 + m->us_per_frame / 2) / m->us_per_frame : 0;
+    switch (m->audio_tag) {
+        case 0:    audio = "no audio"; break;
+        case 1:    audio = "PCM"; break;
+        case 2:    audio = "ADPCM"; break;
+        case 0x11: audio = "IMA"; break;
+        case 0x55: audio = "MP3"; break;
+        default:   audio = "audio?"; break;
+    }
+
+    int n = (secs >= 3600) ?
+        snprintf(out, size, "%u:%02u:%02u", secs / 3600, (secs / 60) % 60, secs % 60) :
+        snprintf(out, size, "%u:%02u", secs / 60, secs % 60);
+    if (n < size) {
+        n += snprintf(out + n, size - n, " %s %ux%u %ufps %s", m->fourcc[0] ? m->fourcc : "?",
+                      (unsigned)m->width, (unsigned)m->height, (unsigned)fps, audio);
+    }
+    if (n < size && m->audio_tag) snprintf(out + n, size - n, " %uk", (unsigned)(m->audio_rate / 1000));
+}
+
 static void draw_file_browser(void) {
     int fb_x = 30;
     int fb_y = 15;
@@ -1276,15 +2003,15 @@ static void draw_file_browser(void) {
         }
 
         /* Icon and filename (convert Polish chars for display) */
-        pixel_t col = fb_is_dir[idx] ? col_dir : col_file;
+        pixel_t col = fb_entries[idx].is_dir ? col_dir : col_file;
         char full_name[FB_MAX_NAME + 3];  /* +3 for brackets */
         char display_name[FB_NAME_VISIBLE_CHARS + 1];
         char display_latin[FB_NAME_VISIBLE_CHARS + 1];
 
-        if (fb_is_dir[idx]) {
-            snprintf(full_name, sizeof(full_name), "[%s]", fb_files[idx]);
+        if (fb_entries[idx].is_dir) {
+            snprintf(full_name, sizeof(full_name), "[%s]", fb_entries[idx].name);
         } else {
-            strncpy(full_name, fb_files[idx], FB_MAX_NAME);
+            strncpy(full_name, fb_entries[idx].name, FB_MAX_NAME);
             full_name[FB_MAX_NAME - 1] = '\0';
         }
 
@@ -1332,6 +2059,13 @@ static void draw_file_browser(void) {
     char count_str[20];
     snprintf(count_str, 20, "%d files", fb_file_count);
     draw_str(fb_x + fb_w - 60, fb_y + fb_h - 20, count_str, 0x7BEF);
+
+    /* Selected video: what its headers say */
+    if (fb_selection < fb_file_count && !fb_entries[fb_selection].is_dir) {
+        char info[FB_NAME_VISIBLE_CHARS + 1];
+        fb_meta_format(&fb_entries[fb_selection].meta, info, sizeof(info));
+        draw_str(fb_x + 8, fb_y + fb_h - 10, info, 0x7BEF);
+    }
 }
 
 /* Draw menu overlay - Amiga style */
@@ -1428,15 +2162,28 @@ static void draw_menu(void) {
     draw_fill_rect(pos_x - 4, slider_y - 3, pos_x + 4, slider_y + 11, col_sel);
     draw_fill_rect(pos_x - 2, slider_y - 1, pos_x + 2, slider_y + 9, col_title);
 
+    /* Preview of the step, above the handle */
+    if (menu_selection == 1 && thumb_frame[seek_position] >= 0) {
+        int tx = pos_x - THUMB_W / 2;
+        int ty = slider_y - THUMB_H - 6;
+        if (tx < menu_x + 4) tx = menu_x + 4;
+        if (tx > menu_x + menu_w - 4 - THUMB_W) tx = menu_x + menu_w - 4 - THUMB_W;
+        draw_fill_rect(tx - 1, ty - 1, tx + THUMB_W, ty + THUMB_H, col_border);
+        for (int y = 0; y < THUMB_H; y++) {
+            memcpy(&framebuffer[(ty + y) * SCREEN_WIDTH + tx], &thumb_pixels[seek_position][y * THUMB_W],
+                   THUMB_W * sizeof(pixel_t));
+        }
+    }
+
     /* Position info */
     int pct = seek_position * 5;
-    int target_frame = (total_frames > 0) ? (seek_position * total_frames / 20) : 0;
+    int target_frame = slider_frame();
     draw_num(slider_x, slider_y + 14, pct, col_hint);
     draw_str(slider_x + 18, slider_y + 14, "%", col_hint);
     draw_str(slider_x + 50, slider_y + 14, "Fr:", col_text);
     draw_num(slider_x + 70, slider_y + 14, target_frame, col_value);
     draw_str(slider_x + 110, slider_y + 14, "/", col_text);
-    draw_num(slider_x + 118, slider_y + 14, total_frames, col_value);
+    draw_num(slider_x + 118, slider_y + 14, slider_total(), col_value);
 
     /* Hint when slider selected */
     if (menu_selection == 1) {
@@ -1572,25 +2319,25 @@ static uint32_t read_u32_le(const uint8_t *p) {
 static uint16_t read_u16_le(const uint8_t *p) {
     return p[0] | (p[1] << 8);
 }
-static int read32(FILE *f, uint32_t *out) {
+static int read32(pfile_t *f, uint32_t *out) {
     uint8_t buf[4];
-    if (fread(buf, 1, 4, f) != 4) return -1;
+    if (pf_read(f, buf, 4) != 4) return -1;
     *out = read_u32_le(buf);
     return 0;
 }
-static int check4(FILE *f, const char *tag) {
+static int check4(pfile_t *f, const char *tag) {
     uint8_t buf[4];
-    if (fread(buf, 1, 4, f) != 4) return 0;
+    if (pf_read(f, buf, 4) != 4) return 0;
     return (buf[0]==tag[0] && buf[1]==tag[1] && buf[2]==tag[2] && buf[3]==tag[3]);
 }
 
 /* Check if data at offset starts with JPEG magic */
 static int check_jpeg_magic(long offset) {
     uint8_t magic[2];
-    long saved = ftell(video_file);
-    fseek(video_file, offset, SEEK_SET);
-    int ok = (fread(magic, 1, 2, video_file) == 2 && magic[0] == 0xFF && magic[1] == 0xD8);
-    fseek(video_file, saved, SEEK_SET);
+    long saved = pf_tell(video_file);
+    pf_seek(video_file, offset, SEEK_SET);
+    int ok = (pf_read(video_file, magic, 2) == 2 && magic[0] == 0xFF && magic[1] == 0xD8);
+    pf_seek(video_file, saved, SEEK_SET);
     return ok;
 }
 
@@ -1598,10 +2345,10 @@ static int check_jpeg_magic(long offset) {
 static int check_chunk_header(long offset) {
     if (offset < 0) return 0;
     uint8_t header[4];
-    long saved = ftell(video_file);
-    fseek(video_file, offset, SEEK_SET);
+    long saved = pf_tell(video_file);
+    pf_seek(video_file, offset, SEEK_SET);
     int ok = 0;
-    if (fread(header, 1, 4, video_file) == 4) {
+    if (pf_read(video_file, header, 4) == 4) {
         /* Check for valid stream chunk: ##dc (video) or ##wb (audio) */
         /* ## is stream number 00-99 */
         if (header[0] >= '0' && header[0] <= '9' &&
@@ -1614,7 +2361,7 @@ static int check_chunk_header(long offset) {
             }
         }
     }
-    fseek(video_file, saved, SEEK_SET);
+    pf_seek(video_file, saved, SEEK_SET);
     return ok;
 }
 
@@ -1624,15 +2371,14 @@ static int parse_idx1(long movi_data_start) {
     uint32_t chunk_size;
 
     /* Look for idx1 chunk after current position */
-    while (fread(tag, 1, 4, video_file) == 4) {
+    while (pf_read(video_file, tag, 4) == 4) {
         if (read32(video_file, &chunk_size) != 0) break;
 
         if (tag[0]=='i' && tag[1]=='d' && tag[2]=='x' && tag[3]=='1') {
             /* Found idx1! */
             int num_entries = chunk_size / 16;
-            int entries_per_block = MAX_JPEG_SIZE / 16;
 
-            long idx_start = ftell(video_file);
+            long idx_start = pf_tell(video_file);
 
             /* Find first video entry to detect offset format */
             uint8_t entry[16];
@@ -1641,7 +2387,7 @@ static int parse_idx1(long movi_data_start) {
             int found_video = 0;
 
             for (int i = 0; i < num_entries && i < 100; i++) {
-                if (fread(entry, 1, 16, video_file) != 16) break;
+                if (pf_read(video_file, entry, 16) != 16) break;
                 if ((entry[2]=='d' || entry[2]=='D') && (entry[3]=='c' || entry[3]=='C')) {
                     first_video_offset = read_u32_le(entry + 8);
                     first_video_size = read_u32_le(entry + 12);
@@ -1651,7 +2397,7 @@ static int parse_idx1(long movi_data_start) {
             }
 
             if (!found_video) {
-                fseek(video_file, idx_start, SEEK_SET);
+                pf_seek(video_file, idx_start, SEEK_SET);
                 return 0;  /* No video in idx1 */
             }
 
@@ -1716,81 +2462,381 @@ static int parse_idx1(long movi_data_start) {
 
             if (!format_found) {
                 /* None worked - fall back to scan */
-                fseek(video_file, idx_start, SEEK_SET);
+                pf_seek(video_file, idx_start, SEEK_SET);
                 return 0;
             }
 
-            /* Go back and parse all entries with detected format */
-            fseek(video_file, idx_start, SEEK_SET);
-            int entries_done = 0;
-
-            while (entries_done < num_entries) {
-                int to_read = num_entries - entries_done;
-                if (to_read > entries_per_block) to_read = entries_per_block;
+            /* The entries themselves are added by index_step */
+            index_mode = INDEX_IDX1;
+            index_pos = idx_start;
+            index_left = num_entries;
+            idx1_base = offset_base + add_header;
+            return 1;
+        }
 
-                size_t got = fread(jpeg_buffer, 16, to_read, video_file);
-                if (got == 0) break;
+        pf_seek(video_file, chunk_size + (chunk_size & 1), SEEK_CUR);
+    }
 
-                for (size_t i = 0; i < got; i++) {
-                    uint8_t *e = jpeg_buffer + i * 16;
-                    uint32_t offset = read_u32_le(e + 8);
-                    uint32_t size = read_u32_le(e + 12);
-                    uint32_t abs_data_offset = offset_base + offset + add_header;
+    return 0;
+}
 
-                    if ((e[2]=='d' || e[2]=='D') && (e[3]=='c' || e[3]=='C')) {
-                        if (total_frames < MAX_FRAMES) {
-                            frame_offsets[total_frames] = abs_data_offset;
-                            frame_sizes[total_frames] = size;
-                            total_frames++;
-                        }
-                    }
-                    else if ((e[2]=='w' || e[2]=='W') && (e[3]=='b' || e[3]=='B')) {
-                        if (total_audio_chunks < MAX_AUDIO_CHUNKS) {
-                            audio_offsets[total_audio_chunks] = abs_data_offset;
-                            audio_sizes[total_audio_chunks] = size;
-                            total_audio_bytes += size;
-                            total_audio_chunks++;
-                        }
-                    }
-                }
-                entries_done += got;
-            }
-            return 1;
+/* Add one idx1 entry or movi chunk to the frame/audio index */
+static void index_add(const uint8_t *tag, uint32_t offset, uint32_t size, int delta) {
+    if ((tag[2]=='d' || tag[2]=='D') && (tag[3]=='c' || tag[3]=='C')) {
+        if (total_frames < MAX_FRAMES) {
+            frame_offsets[total_frames] = offset;
+            frame_sizes[total_frames] = size | (delta ? FRAME_DELTA : 0);
+            if (!delta && size > 1) index_has_keys = 1;
+            if (size > max_frame_bytes) max_frame_bytes = size;
+            total_frames++;
         }
+    }
+    else if ((tag[2]=='w' || tag[2]=='W') && (tag[3]=='b' || tag[3]=='B')) {
+        if (total_audio_chunks < MAX_AUDIO_CHUNKS) {
+            audio_offsets[total_audio_chunks] = offset;
+            audio_sizes[total_audio_chunks] = size;
+            total_audio_bytes += size;
+            total_audio_chunks++;
+        }
+    }
+}
 
-        fseek(video_file, chunk_size + (chunk_size & 1), SEEK_CUR);
+/* idx1 only covers the first RIFF: find the movi list of the RIFF AVIX
+   extension at index_riff, if there is one */
+static void index_next_riff(pfile_t *f) {
+    uint8_t hdr[12];
+    uint32_t size, riff_end, pos;
+
+    index_mode = INDEX_DONE;
+    if (total_frames >= MAX_FRAMES) return;
+    pf_seek(f, index_riff, SEEK_SET);
+    if (pf_read(f, hdr, 12) != 12) return;
+    if (memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "AVIX", 4) != 0) return;
+    size = read_u32_le(hdr + 4);
+    riff_end = index_riff + 8 + size + (size & 1);
+    if (riff_end <= index_riff) return;  /* past 4 GB */
+
+    pos = index_riff + 12;
+    index_riff = riff_end;
+    while (pos < riff_end) {
+        pf_seek(f, pos, SEEK_SET);
+        if (pf_read(f, hdr, 12) != 12) return;
+        size = read_u32_le(hdr + 4);
+        if (memcmp(hdr, "LIST", 4) == 0 && memcmp(hdr + 8, "movi", 4) == 0) {
+            index_mode = INDEX_MOVI;
+            index_pos = pos + 12;
+            index_end = pos + 8 + size;
+            return;
+        }
+        pos += 8 + size + (size & 1);
     }
+}
+
+/* A movi chunk header the walk can follow from pos: a stream chunk
+   (##dc, ##db, ##wb, ##pc, ##tx), an OpenDML ix##, JUNK or a LIST, with a
+   size that fits the movi list */
+static int index_header_ok(const uint8_t *h, uint32_t pos) {
+    uint32_t size = read_u32_le(h + 4);
+    char c2, c3;
+
+    if (size > INDEX_CHUNK_MAX) return 0;
+    if (index_end != INDEX_OPEN_END && (pos + 8 > index_end || size > index_end - pos - 8)) return 0;
+    if (memcmp(h, "JUNK", 4) == 0 || (h[0] == 'i' && h[1] == 'x')) return 1;
+    if (memcmp(h, "LIST", 4) == 0) return size >= 4;
+    if (h[0] < '0' || h[0] > '9' || h[1] < '0' || h[1] > '9') return 0;
+    c2 = h[2] | 0x20;
+    c3 = h[3] | 0x20;
+    return (c2 == 'd' && (c3 == 'c' || c3 == 'b')) || (c2 == 'w' && c3 == 'b') ||
+           (c2 == 'p' && c3 == 'c') || (c2 == 't' && c3 == 'x');
+}
 
+/* The header at index_pos is damaged: search the next block of the file
+   for a stream chunk header whose following header checks out too
+   (compressed data can hold a lookalike). Returns 1 with index_pos on it,
+   0 if the block had none (index_pos moves on), -1 at the end of the file */
+static int index_resync(pfile_t *f) {
+    uint32_t from = index_pos + 1, got;
+
+    pf_seek(f, from, SEEK_SET);
+    got = pf_read(f, index_buf, sizeof(index_buf));
+    if (got < 8) return -1;
+    for (uint32_t i = 0; i + 8 <= got; i++) {
+        const uint8_t *h = index_buf + i;
+        uint8_t next[8];
+        uint32_t size, after;
+
+        if (h[0] < '0' || h[0] > '9' || !index_header_ok(h, from + i)) continue;
+        size = read_u32_le(h + 4);
+        after = from + i + 8 + size + (size & 1);
+        pf_seek(f, after, SEEK_SET);
+        if (after != index_end && pf_read(f, next, 8) == 8 && !index_header_ok(next, after) &&
+            memcmp(next, "idx1", 4) != 0) continue;
+        trace(1, "index: damaged chunk at %u, resync at %u\n", (unsigned)index_pos, (unsigned)(from + i));
+        index_pos = from + i;
+        index_resyncs++;
+        return 1;
+    }
+    index_pos = from + got - 8;  /* the next search starts where this one stopped */
+    if (index_end != INDEX_OPEN_END && index_pos >= index_end) index_pos = index_end;
     return 0;
 }
 
-/* Fallback: scan movi chunk with buffered I/O (faster than byte-by-byte) */
-static void scan_movi_buffered(long movi_start, long movi_end) {
-    fseek(video_file, movi_start, SEEK_SET);
+/* The file holds every byte before end. Checked against the length the
+   walk already knows; the file is only asked again for an end past it */
+static int index_have(pfile_t *f, uint64_t end) {
+    if (end > index_file_size) index_file_size = pf_size(f);
+    return end <= index_file_size;
+}
+
+/* Add up to `budget` idx1 entries (a movi chunk header counts 8) */
+static void index_step(int budget) {
+    pfile_t *f = index_file ? index_file : video_file;
+    uint32_t saved = pf_tell(f);
+    uint8_t hdr[8];
+
+    while (budget > 0 && index_mode != INDEX_DONE) {
+        if (index_mode == INDEX_IDX1) {
+            uint32_t n = index_left, got;
+            if (n > sizeof(index_buf) / 16) n = sizeof(index_buf) / 16;
+            if (n > (uint32_t)budget) n = budget;
+            pf_seek(f, index_pos, SEEK_SET);
+            got = pf_read(f, index_buf, n * 16) / 16;
+            for (uint32_t i = 0; i < got; i++) {
+                uint8_t *e = index_buf + i * 16;
+                index_add(e, idx1_base + read_u32_le(e + 8), read_u32_le(e + 12),
+                          !(read_u32_le(e + 4) & AVIIF_KEYFRAME));
+            }
+            index_pos += got * 16;
+            index_left -= got;
+            budget -= got;
+            if (got < n || index_left == 0) index_mode = INDEX_AVIX;
+        }
+        else if (index_mode == INDEX_TAIL) {
+            /* A poll of a short file: walk on if it grew since the walk ran
+               out, else take it as it is */
+            uint32_t size = pf_size(f);
+            budget -= 8;
+            if (size == index_file_size) {
+                trace(1, "index: file ends at %u, inside movi\n", (unsigned)index_pos);
+                index_mode = INDEX_AVIX;
+            } else {
+                index_file_size = size;
+                index_mode = INDEX_MOVI;
+            }
+        }
+        else if (index_mode == INDEX_MOVI) {
+            /* No idx1 (or an AVIX extension): walk the chunk headers */
+            uint32_t size, next;
+            budget -= 8;
+            if (index_pos >= index_end || total_frames >= MAX_FRAMES) {
+                index_mode = INDEX_AVIX;
+                continue;
+            }
+            pf_seek(f, index_pos, SEEK_SET);
+            if (!index_have(f, (uint64_t)index_pos + 8) || pf_read(f, hdr, 8) != 8) {
+                index_mode = INDEX_TAIL;  /* ran out of file */
+                break;
+            }
+            size = read_u32_le(hdr + 4);
+            if (!index_header_ok(hdr, index_pos)) {
+                if (index_end == INDEX_OPEN_END && (memcmp(hdr, "idx1", 4) == 0 || memcmp(hdr, "RIFF", 4) == 0)) {
+                    index_mode = INDEX_AVIX;  /* the movi list ended after all */
+                    continue;
+                }
+                budget -= 64;
+                if (index_resync(f) < 0) {
+                    index_file_size = pf_size(f);
+                    index_mode = INDEX_TAIL;
+                    break;
+                }
+                continue;
+            }
+            /* Only whole chunks: the last one of a short file may be cut */
+            if (!index_have(f, (uint64_t)index_pos + 8 + size)) {
+                index_mode = INDEX_TAIL;
+                break;
+            }
+            if (memcmp(hdr, "LIST", 4) == 0) {
+                index_pos += 12;  /* rec lists: their chunks are walked like the rest */
+                continue;
+            }
+            index_add(hdr, index_pos + 8, size, 0);  /* no flags: may be a keyframe */
+            next = index_pos + 8 + size + (size & 1);
+            if (next <= index_pos) index_mode = INDEX_DONE;  /* past 4 GB */
+            index_pos = next;
+        }
+        else {
+            budget -= 8;
+            index_next_riff(f);
+        }
+    }
+    pf_seek(f, saved, SEEK_SET);
+}
+
+/* Index right away until frame is covered, with a margin for the audio
+   chunks the ring reads ahead */
+static void index_until(int frame) {
+    while (index_mode != INDEX_DONE && index_mode != INDEX_TAIL && total_frames <= frame + 2 * (int)clip_fps) {
+        index_step(INDEX_STEP);
+    }
+}
 
-    while (ftell(video_file) < movi_end && total_frames < MAX_FRAMES) {
-        uint8_t header[8];
-        if (fread(header, 1, 8, video_file) != 8) break;
+static void index_close(void) {
+    if (index_file) pf_close(index_file);
+    index_file = NULL;
+    index_mode = INDEX_DONE;
+}
 
-        uint32_t fsize = read_u32_le(header + 4);
-        long data_pos = ftell(video_file);
+/* Read an indx super index chunk (file positioned at its data) */
+static void odml_read_indx(odml_index_t *ix, uint32_t size) {
+    uint32_t end = pf_tell(video_file) + size + (size & 1);
+    uint8_t hdr[24], e[16];
+
+    ix->segs = 0;
+    ix->last = 0;
+    if (size >= 24 && pf_read(video_file, hdr, 24) == 24 &&
+        read_u16_le(hdr) == 4 && hdr[3] == 0) {   /* AVI_INDEX_OF_INDEXES */
+        uint32_t n = read_u32_le(hdr + 4);
+        if (n > (size - 24) / 16) n = (size - 24) / 16;
+        if (n > ODML_MAX_SEGMENTS) n = ODML_MAX_SEGMENTS;
+        for (uint32_t i = 0; i < n; i++) {
+            if (pf_read(video_file, e, 16) != 16) break;
+            ix->seg[ix->segs].offset = read_u32_le(e) | ((uint64_t)read_u32_le(e + 4) << 32);
+            ix->seg[ix->segs].bytes = (uint64_t)read_u32_le(e + 12) * ix->sample_size;
+            ix->seg[ix->segs].loaded = 0;
+            ix->segs++;
+        }
+    }
+    pf_seek(video_file, end, SEEK_SET);
+}
 
-        if ((header[2]=='d' || header[2]=='D') && (header[3]=='c' || header[3]=='C')) {
-            frame_offsets[total_frames] = data_pos;
-            frame_sizes[total_frames] = fsize;
-            total_frames++;
+/* Read the ix## header of every segment to lay out the flat arrays.
+ * Returns the total entry count, 0 if any segment is unusable. */
+static int odml_layout(odml_index_t *ix, int max) {
+    uint8_t hdr[32];
+    int total = 0;
+    uint64_t bytes = 0;
+
+    ix->sized = ix->sample_size != 0;
+    for (int s = 0; s < ix->segs; s++) {
+        odml_seg_t *seg = &ix->seg[s];
+        if (pf_seek(video_file, seg->offset, SEEK_SET) != 0) return 0;
+        if (pf_read(video_file, hdr, 32) != 32) return 0;
+        /* ix## with 2 dwords per entry, AVI_INDEX_OF_CHUNKS */
+        if (hdr[0] != 'i' || hdr[1] != 'x' || read_u16_le(hdr + 8) != 2 || hdr[11] != 1) return 0;
+        uint32_t n = read_u32_le(hdr + 12);
+        if (n > (uint32_t)(max - total)) {
+            n = max - total;
+            ix->sized = 0;
         }
-        else if ((header[2]=='w' || header[2]=='W') && (header[3]=='b' || header[3]=='B')) {
-            if (total_audio_chunks < MAX_AUDIO_CHUNKS) {
-                audio_offsets[total_audio_chunks] = data_pos;
-                audio_sizes[total_audio_chunks] = fsize;
-                total_audio_bytes += fsize;
-                total_audio_chunks++;
+        seg->first = total;
+        seg->count = n;
+        seg->before = bytes;
+        total += n;
+        bytes += seg->bytes;
+    }
+    return total;
+}
+
+/* Load the entries of one ix## segment into offsets/sizes. Returns the
+ * bytes they add up to */
+static uint64_t odml_load(odml_seg_t *seg, uint32_t *offsets, uint32_t *sizes) {
+    uint32_t saved = pf_tell(video_file);
+    uint8_t hdr[32];
+    uint64_t bytes = 0;
+    int done = 0;
+
+    /* Whatever happens, don't retry on every access */
+    seg->loaded = 1;
+    memset(sizes + seg->first, 0, seg->count * sizeof(uint32_t));
+    memset(offsets + seg->first, 0, seg->count * sizeof(uint32_t));
+
+    pf_seek(video_file, seg->offset, SEEK_SET);
+    if (pf_read(video_file, hdr, 32) == 32) {
+        uint64_t base = read_u32_le(hdr + 20) | ((uint64_t)read_u32_le(hdr + 24) << 32);
+        while (done < seg->count) {
+            int n = seg->count - done;
+            if (n > (int)(sizeof(index_buf) / 8)) n = sizeof(index_buf) / 8;
+            if (pf_read(video_file, index_buf, n * 8) != (uint32_t)n * 8) break;
+            for (int i = 0; i < n; i++) {
+                uint64_t off = base + read_u32_le(index_buf + i * 8);
+                uint32_t size = read_u32_le(index_buf + i * 8 + 4);  /* bit 31 = FRAME_DELTA */
+                if (off + (size & ~FRAME_DELTA) > 0xFFFFFFFF) continue;  /* beyond FAT32 - leave empty */
+                offsets[seg->first + done + i] = (uint32_t)off;
+                sizes[seg->first + done + i] = size;
+                bytes += size & ~FRAME_DELTA;
+                if (sizes == frame_sizes && size > 1 && !(size & FRAME_DELTA)) index_has_keys = 1;
             }
+            done += n;
         }
+    }
+    trace(1, "odml: segment at %u, %d entries\n", (unsigned)seg->offset, seg->count);
+    pf_seek(video_file, saved, SEEK_SET);
+    return bytes;
+}
 
-        fseek(video_file, fsize + (fsize & 1), SEEK_CUR);
+/* Make sure entry i of an OpenDML indexed stream is loaded */
+static void odml_need(odml_index_t *ix, int i, uint32_t *offsets, uint32_t *sizes) {
+    odml_seg_t *seg = &ix->seg[ix->last];
+    if (i < seg->first || i >= seg->first + seg->count) {
+        int lo = 0, hi = ix->segs - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (ix->seg[mid].first <= i) lo = mid;
+            else hi = mid - 1;
+        }
+        ix->last = lo;
+        seg = &ix->seg[lo];
     }
+    if (!seg->loaded && odml_load(seg, offsets, sizes) != seg->bytes) ix->sized = 0;
+}
+
+static inline uint32_t frame_offset(int i) {
+    if (odml_video.segs) odml_need(&odml_video, i, frame_offsets, frame_sizes);
+    return frame_offsets[i];
+}
+
+static inline uint32_t frame_size(int i) {
+    if (odml_video.segs) odml_need(&odml_video, i, frame_offsets, frame_sizes);
+    return frame_sizes[i] & ~FRAME_DELTA;
+}
+
+/* Chunk i is a delta frame by the index (idx1 or ix## flags). Chunks
+   found by walking movi carry no flag, and neither does any chunk of an
+   index that flags no frame at all as a keyframe (some muxers leave the
+   flags at 0) */
+static inline int frame_is_delta(int i) {
+    if (odml_video.segs) odml_need(&odml_video, i, frame_offsets, frame_sizes);
+    return index_has_keys && (frame_sizes[i] & FRAME_DELTA) != 0;
+}
+
+static inline uint32_t audio_offset(int i) {
+    if (odml_audio.segs) odml_need(&odml_audio, i, audio_offsets, audio_sizes);
+    return audio_offsets[i];
+}
+
+static inline uint32_t audio_size(int i) {
+    if (odml_audio.segs) odml_need(&odml_audio, i, audio_offsets, audio_sizes);
+    return audio_sizes[i] & ~FRAME_DELTA;
+}
+
+/* Use the OpenDML indexes if every stream we play has one */
+static int odml_open(void) {
+    int frames, chunks = 0;
+
+    if (!odml_video.segs) return 0;
+    if (has_audio && !odml_audio.segs) return 0;
+
+    frames = odml_layout(&odml_video, MAX_FRAMES);
+    if (frames > 0 && has_audio) chunks = odml_layout(&odml_audio, MAX_AUDIO_CHUNKS);
+    if (frames <= 0 || (has_audio && chunks <= 0)) return 0;
+
+    if (!has_audio) odml_audio.segs = 0;
+    total_frames = frames;
+    total_audio_chunks = chunks;
+    xlog("OpenDML index: %d video segments, %d frames, %d audio chunks\n",
+         odml_video.segs, frames, chunks);
+    return 1;
 }
 
 static int parse_avi(void) {
@@ -1799,15 +2845,25 @@ static int parse_avi(void) {
     long hdrl_end, strl_end;
     long movi_start = 0, movi_end = 0;
     uint8_t buf[64];
-    int found_idx1 = 0;
 
     if (!check4(video_file, "RIFF")) return 0;
     if (read32(video_file, &riff_size) != 0) return 0;
     if (!check4(video_file, "AVI ")) return 0;
 
     total_frames = 0;
+    index_has_keys = 0;
     total_audio_chunks = 0;
     total_audio_bytes = 0;
+    max_frame_bytes = 0;
+    frame_hint_bytes = 0;
+    header_frames = 0;
+    index_close();
+    index_resyncs = 0;
+    index_file_size = 0;
+    index_tail_wait = 0;
+    odml_video.segs = 0;
+    odml_audio.segs = 0;
+    odml_audio.sample_size = 0;
     clip_fps = 30;
     us_per_frame = 33333;
     repeat_count = 1;
@@ -1825,49 +2881,56 @@ static int parse_avi(void) {
     debug_first_frame_saved = 0;
     memset(debug_first_frame, 0, sizeof(debug_first_frame));
 
-    while (fread(tag, 1, 4, video_file) == 4) {
+    while (pf_read(video_file, tag, 4) == 4) {
         if (read32(video_file, &chunk_size) != 0) break;
 
         if (tag[0]=='L' && tag[1]=='I' && tag[2]=='S' && tag[3]=='T') {
-            if (fread(list_type, 1, 4, video_file) != 4) break;
+            if (pf_read(video_file, list_type, 4) != 4) break;
 
             if (list_type[0]=='h' && list_type[1]=='d' && list_type[2]=='r' && list_type[3]=='l') {
                 /* Parse header list for fps and audio info */
-                hdrl_end = ftell(video_file) + chunk_size - 4;
-                while (ftell(video_file) < hdrl_end) {
-                    if (fread(htag, 1, 4, video_file) != 4) break;
+                hdrl_end = pf_tell(video_file) + chunk_size - 4;
+                while (pf_tell(video_file) < hdrl_end) {
+                    if (pf_read(video_file, htag, 4) != 4) break;
                     if (read32(video_file, &hsize) != 0) break;
 
                     if (htag[0]=='a' && htag[1]=='v' && htag[2]=='i' && htag[3]=='h') {
-                        if (hsize >= 4 && fread(buf, 1, (hsize < 56 ? hsize : 56), video_file) >= 4) {
+                        if (hsize >= 4 && pf_read(video_file, buf, (hsize < 56 ? hsize : 56)) >= 4) {
                             us_per_frame = read_u32_le(buf);
+                            if (hsize >= 20 && !header_frames) header_frames = (int)read_u32_le(buf + 16);
                             if (us_per_frame > 0) {
-                                clip_fps = 1000000 / us_per_frame;
+                                clip_fps = (1000000 + us_per_frame / 2) / us_per_frame;  /* 29.97 -> 30 */
                                 if (clip_fps == 0) clip_fps = 1;
                             }
                             if (clip_fps >= 25) repeat_count = 1;
                             else if (clip_fps >= 12) repeat_count = 2;
                             else repeat_count = 3;
-                            if (hsize > 56) fseek(video_file, hsize - 56, SEEK_CUR);
-                        } else fseek(video_file, hsize, SEEK_CUR);
+                            if (hsize > 56) pf_seek(video_file, hsize - 56, SEEK_CUR);
+                        } else pf_seek(video_file, hsize, SEEK_CUR);
                     }
                     else if (htag[0]=='L' && htag[1]=='I' && htag[2]=='S' && htag[3]=='T') {
-                        if (fread(buf, 1, 4, video_file) != 4) break;
+                        if (pf_read(video_file, buf, 4) != 4) break;
                         if (buf[0]=='s' && buf[1]=='t' && buf[2]=='r' && buf[3]=='l') {
-                            strl_end = ftell(video_file) + hsize - 4;
+                            strl_end = pf_tell(video_file) + hsize - 4;
                             int strl_type = 0;  /* 0=unknown, 1=video, 2=audio */
-                            while (ftell(video_file) < strl_end) {
-                                if (fread(htag, 1, 4, video_file) != 4) break;
+                            while (pf_tell(video_file) < strl_end) {
+                                if (pf_read(video_file, htag, 4) != 4) break;
                                 uint32_t shsize;
                                 if (read32(video_file, &shsize) != 0) break;
 
                                 if (htag[0]=='s' && htag[1]=='t' && htag[2]=='r' && htag[3]=='h') {
-                                    if (shsize >= 8 && fread(buf, 1, (shsize < 64 ? shsize : 64), video_file) >= 8) {
+                                    if (shsize >= 8 && pf_read(video_file, buf, (shsize < 64 ? shsize : 64)) >= 8) {
                                         if (buf[0]=='a' && buf[1]=='u' && buf[2]=='d' && buf[3]=='s') {
                                             strl_type = 2;  /* audio */
+                                            /* dwSampleSize: the unit of the indx durations that follows */
+                                            odml_audio.sample_size = shsize >= 48 ? read_u32_le(buf + 44) : 0;
                                         }
                                         else if (buf[0]=='v' && buf[1]=='i' && buf[2]=='d' && buf[3]=='s') {
                                             strl_type = 1;  /* video */
+                                            /* dwSuggestedBufferSize: the only size hint before lazy OpenDML segments load */
+                                            if (shsize >= 40) frame_hint_bytes = read_u32_le(buf + 36);
+                                            /* dwLength: every RIFF, where avih counts the first */
+                                            if (shsize >= 36 && read_u32_le(buf + 32) > 0) header_frames = (int)read_u32_le(buf + 32);
                                             /* strh bytes 4-7 = fccHandler (codec fourcc) */
                                             video_fourcc[0] = buf[4];
                                             video_fourcc[1] = buf[5];
@@ -1875,13 +2938,13 @@ static int parse_avi(void) {
                                             video_fourcc[3] = buf[7];
                                             video_fourcc[4] = 0;
                                         }
-                                        if (shsize > 64) fseek(video_file, shsize - 64, SEEK_CUR);
-                                    } else fseek(video_file, shsize, SEEK_CUR);
+                                        if (shsize > 64) pf_seek(video_file, shsize - 64, SEEK_CUR);
+                                    } else pf_seek(video_file, shsize, SEEK_CUR);
                                 }
                                 else if (htag[0]=='s' && htag[1]=='t' && htag[2]=='r' && htag[3]=='f') {
                                     if (strl_type == 2 && shsize >= 16) {
                                         /* Audio format (WAVEFORMATEX) */
-                                        if (fread(buf, 1, (shsize < 64 ? shsize : 64), video_file) >= 16) {
+                                        if (pf_read(video_file, buf, (shsize < 64 ? shsize : 64)) >= 16) {
                                             uint16_t fmt = read_u16_le(buf);
                                             audio_channels = read_u16_le(buf + 2);
                                             audio_sample_rate = read_u32_le(buf + 4);
@@ -1908,6 +2971,14 @@ static int parse_avi(void) {
                                                     adpcm_samples_per_block = 2 + (adpcm_block_align - header) * 2 / audio_channels;
                                                 }
                                             }
+                                            else if (fmt == 0x11 && audio_bits == 4 && (audio_channels == 1 || audio_channels == 2) && audio_sample_rate > 0) {
+                                                /* IMA/DVI ADPCM audio (4-bit only) */
+                                                has_audio = 1;
+                                                audio_format = AUDIO_FMT_IMA;
+                                                audio_bytes_per_sample = 2 * audio_channels;  /* Output is 16-bit PCM */
+                                                /* Header sample + 2 per data byte (all channels) */
+                                                adpcm_samples_per_block = 1 + (adpcm_block_align - 4 * audio_channels) * 2 / audio_channels;
+                                            }
                                             else if (fmt == 0x55 && audio_channels > 0 && audio_sample_rate > 0) {
                                                 /* MP3 audio (MPEG Layer III = 0x55) */
                                                 has_audio = 1;
@@ -1920,13 +2991,13 @@ static int parse_avi(void) {
                                                 has_audio = 0;
                                                 audio_format = 0;
                                             }
-                                            if (shsize > 64) fseek(video_file, shsize - 64, SEEK_CUR);
+                                            if (shsize > 64) pf_seek(video_file, shsize - 64, SEEK_CUR);
                                         }
                                     }
                                     else if (strl_type == 1 && shsize >= 40) {
                                         /* Video format (BITMAPINFOHEADER = 40 bytes) */
                                         debug_strf_size = shsize;  /* Save for debug */
-                                        if (fread(buf, 1, 40, video_file) == 40) {
+                                        if (pf_read(video_file, buf, 40) == 40) {
                                             /* biWidth at offset 4, biHeight at offset 8 */
                                             xvid_width = read_u32_le(buf + 4);
                                             xvid_height = read_u32_le(buf + 8);
@@ -1941,17 +3012,18 @@ static int parse_avi(void) {
                                             /* MPEG-4 extradata: bytes after BITMAPINFOHEADER (VOL header!) */
                                             int extradata_len = shsize - 40;
                                             if (extradata_len > 0 && extradata_len <= MAX_EXTRADATA_SIZE) {
-                                                if (fread(mpeg4_extradata, 1, extradata_len, video_file) == (size_t)extradata_len) {
+                                                if (pf_read(video_file, mpeg4_extradata, extradata_len) == (size_t)extradata_len) {
                                                     mpeg4_extradata_size = extradata_len;
+                                                    memset(mpeg4_extradata + extradata_len, 0, XVID_BS_PADDING);
                                                 }
                                             } else if (extradata_len > MAX_EXTRADATA_SIZE) {
-                                                fseek(video_file, extradata_len, SEEK_CUR);
+                                                pf_seek(video_file, extradata_len, SEEK_CUR);
                                             }
                                         }
                                     }
                                     else if (strl_type == 1 && shsize >= 20) {
                                         /* Shorter BITMAPINFOHEADER (no extradata) */
-                                        if (fread(buf, 1, 20, video_file) == 20) {
+                                        if (pf_read(video_file, buf, 20) == 20) {
                                             xvid_width = read_u32_le(buf + 4);
                                             xvid_height = read_u32_le(buf + 8);
                                             if (video_fourcc[0] == 0 || video_fourcc[0] == ' ') {
@@ -1961,38 +3033,60 @@ static int parse_avi(void) {
                                                 video_fourcc[3] = buf[19];
                                                 video_fourcc[4] = 0;
                                             }
-                                            if (shsize > 20) fseek(video_file, shsize - 20, SEEK_CUR);
+                                            if (shsize > 20) pf_seek(video_file, shsize - 20, SEEK_CUR);
                                         }
                                     }
-                                    else fseek(video_file, shsize, SEEK_CUR);
+                                    else pf_seek(video_file, shsize, SEEK_CUR);
                                 }
-                                else fseek(video_file, shsize + (shsize & 1), SEEK_CUR);
+                                else if (htag[0]=='i' && htag[1]=='n' && htag[2]=='d' && htag[3]=='x' && strl_type) {
+                                    /* OpenDML super index - last stream of each type wins, like strf */
+                                    odml_read_indx(strl_type == 1 ? &odml_video : &odml_audio, shsize);
+                                }
+                                else pf_seek(video_file, shsize + (shsize & 1), SEEK_CUR);
                             }
-                        } else fseek(video_file, hsize - 4, SEEK_CUR);
+                        } else pf_seek(video_file, hsize - 4, SEEK_CUR);
                     }
-                    else fseek(video_file, hsize + (hsize & 1), SEEK_CUR);
+                    else pf_seek(video_file, hsize + (hsize & 1), SEEK_CUR);
                 }
             }
             else if (list_type[0]=='m' && list_type[1]=='o' && list_type[2]=='v' && list_type[3]=='i') {
                 /* Found movi - save position but DON'T scan it yet */
-                movi_start = ftell(video_file);
+                movi_start = pf_tell(video_file);
                 movi_end = movi_start + chunk_size - 4;
 
-                /* Skip to end of movi to look for idx1 */
-                fseek(video_file, movi_end, SEEK_SET);
-
-                /* Try to parse idx1 (instant loading!) */
-                found_idx1 = parse_idx1(movi_start);
-
-                if (!found_idx1) {
-                    /* No idx1 - fall back to scanning movi */
-                    scan_movi_buffered(movi_start, movi_end);
+                /* OpenDML indexes cover every RIFF segment (instant loading of multi-GB files) */
+                if (odml_open()) break;
+                odml_video.segs = 0;
+                odml_audio.segs = 0;
+
+                if (chunk_size < 4) {
+                    /* Sizes not written yet (still recording or copying):
+                       walk movi to wherever the file ends */
+                    index_mode = INDEX_MOVI;
+                    index_pos = movi_start;
+                    index_end = INDEX_OPEN_END;
+                } else {
+                    /* Skip to end of movi to look for idx1 */
+                    pf_seek(video_file, movi_end, SEEK_SET);
+
+                    /* Try to parse idx1 (instant loading!) */
+                    if (!parse_idx1(movi_start)) {
+                        /* No idx1 - fall back to scanning movi */
+                        index_mode = INDEX_MOVI;
+                        index_pos = movi_start;
+                        index_end = movi_end;
+                    }
                 }
+                /* Either way, any RIFF AVIX extensions follow the first RIFF */
+                index_riff = 8 + riff_size + (riff_size & 1);
+
+                /* Only the first seconds now - the rest while playing */
+                index_until(clip_fps * INDEX_PRELOAD_SECONDS);
                 break;
             }
-            else fseek(video_file, chunk_size - 4, SEEK_CUR);
+            else pf_seek(video_file, chunk_size - 4, SEEK_CUR);
         }
-        else fseek(video_file, chunk_size + (chunk_size & 1), SEEK_CUR);
+        else pf_seek(video_file, chunk_size + (chunk_size & 1), SEEK_CUR);
     }
 
     /* Classify video codec based on fourcc */
@@ -2005,8 +3099,12 @@ static int parse_avi(void) {
         }
         fc[4] = 0;
 
+        /* Tile codec from pmp-remux */
+        if (fc[0]=='P' && fc[1]=='M' && fc[2]=='P' && fc[3]=='T') {
+            video_codec_type = CODEC_TYPE_TILE;
+        }
         /* Check for MJPEG variants */
-        if ((fc[0]=='M' && fc[1]=='J' && fc[2]=='P' && fc[3]=='G') ||
+        else if ((fc[0]=='M' && fc[1]=='J' && fc[2]=='P' && fc[3]=='G') ||
             (fc[0]=='J' && fc[1]=='P' && fc[2]=='E' && fc[3]=='G') ||
             (fc[0]=='A' && fc[1]=='V' && fc[2]=='R' && fc[3]=='N') ||
             (fc[0]=='D' && fc[1]=='M' && fc[2]=='B' && fc[3]=='1') ||
@@ -2037,16 +3135,177 @@ static int parse_avi(void) {
     return (total_frames > 0);
 }
 
+/* Header-only parse for the file browser: walks hdrl (and the odml list in
+   it) up to movi. Leaves the playback state alone. Returns 0 if the file is
+   not a RIFF AVI */
+static int avi_probe(const char *path, fb_meta_t *m) {
+    pfile_t *f = pf_open(path);
+    uint8_t buf[64];
+    uint32_t pos, end, size, n, dmlh_frames = 0;
+    int strl_type = 0, ok = 0, steps = 0;
+
+    memset(m, 0, sizeof(*m));
+    if (!f) return 0;
+
+    if (pf_read(f, buf, 12) == 12 && memcmp(buf, "RIFF", 4) == 0 && memcmp(buf + 8, "AVI ", 4) == 0) {
+        ok = 1;
+        pos = 12;
+        end = 8 + read_u32_le(buf + 4);
+        /* Lists we care about are entered, everything else is skipped whole */
+        while (pos + 8 <= end && steps++ < 256) {
+            pf_seek(f, pos, SEEK_SET);
+            if (pf_read(f, buf, 8) != 8) break;
+            size = read_u32_le(buf + 4);
+            if (memcmp(buf, "LIST", 4) == 0) {
+                if (pf_read(f, buf, 4) != 4 || memcmp(buf, "movi", 4) == 0) break;
+                if (memcmp(buf, "hdrl", 4) == 0 || memcmp(buf, "strl", 4) == 0 || memcmp(buf, "odml", 4) == 0) {
+                    strl_type = 0;
+                    pos += 12;
+                    continue;
+                }
+            } else {
+                n = size < sizeof(buf) - 8 ? size : sizeof(buf) - 8;
+                if (pf_read(f, buf + 8, n) != n) break;
+                if (memcmp(buf, "avih", 4) == 0 && n >= 40) {
+                    m->us_per_frame = read_u32_le(buf + 8);
+                    m->frames = read_u32_le(buf + 8 + 16);
+                    m->width = read_u32_le(buf + 8 + 32);
+                    m->height = read_u32_le(buf + 8 + 36);
+                }
+                else if (memcmp(buf, "strh", 4) == 0 && n >= 8) {
+                    strl_type = memcmp(buf + 8, "vids", 4) == 0 ? 1 : memcmp(buf + 8, "auds", 4) == 0 ? 2 : 0;
+                    if (strl_type == 1 && !m->fourcc[0]) memcpy(m->fourcc, buf + 12, 4);
+                }
+                else if (memcmp(buf, "strf", 4) == 0 && strl_type == 1 && n >= 20) {
+                    int32_t h = (int32_t)read_u32_le(buf + 8 + 8);
+                    m->width = read_u32_le(buf + 8 + 4);
+                    m->height = h < 0 ? -h : h;  /* negative = top-down */
+                    if (m->fourcc[0] == 0 || m->fourcc[0] == ' ') memcpy(m->fourcc, buf + 8 + 16, 4);
+                }
+                else if (memcmp(buf, "strf", 4) == 0 && strl_type == 2 && n >= 8 && !m->audio_tag) {
+                    m->audio_tag = read_u16_le(buf + 8);
+                    m->audio_rate = read_u32_le(buf + 8 + 4);
+                }
+                else if (memcmp(buf, "dmlh", 4) == 0 && n >= 4) {
+                    dmlh_frames = read_u32_le(buf + 8);  /* all RIFFs, avih only counts the first */
+                }
+            }
+            pos += 8 + size + (size & 1);
+        }
+    }
+    pf_close(f);
+
+    if (dmlh_frames) m->frames = dmlh_frames;
+    /* The cache file is space separated: keep the fourcc printable */
+    for (int i = 0; i < 4; i++) {
+        if (m->fourcc[0] && (m->fourcc[i] <= ' ' || m->fourcc[i] > '~')) m->fourcc[i] = '_';
+    }
+    m->state = ok ? FB_META_OK : FB_META_BAD;
+    return ok;
+}
+
 /* JPEG decode into framebuffer */
+/* Frame too large for frame_buf: read it piecewise from the file, EOI appended */
+static void jpeg_stream_read(jpeg_io_t *io, uint8_t *buff, size_t nbyte) {
+    uint32_t len = io->size - 2;
+    size_t n = 0;
+    if (io->pos < len) {
+        n = len - io->pos;
+        if (n > nbyte) n = nbyte;
+        pf_seek(video_file, io->file_off + io->pos, SEEK_SET);
+        if (pf_read(video_file, buff, n) != n) memset(buff, 0, n);
+    }
+    for (; n < nbyte; n++) buff[n] = (io->pos + n == len) ? 0xFF : 0xD9;
+}
+
 static size_t tjpgd_input(JDEC *jd, uint8_t *buff, size_t nbyte) {
     jpeg_io_t *io = (jpeg_io_t *)jd->device;
     size_t remain = io->size - io->pos;
     if (nbyte > remain) nbyte = remain;
-    if (buff) memcpy(buff, io->data + io->pos, nbyte);
+    if (buff) {
+        if (io->data) memcpy(buff, io->data + io->pos, nbyte);
+        else jpeg_stream_read(io, buff, nbyte);
+    }
     io->pos += nbyte;
     return nbyte;
 }
 
+/* Colour mode for one RGB565 pixel at (src_x, src_y) of the video */
+static inline uint16_t color_pixel(uint16_t pixel, int src_x, int src_y) {
+    int r5 = (pixel >> 11) & 0x1F;
+    int g6 = (pixel >> 5) & 0x3F;
+    int b5 = pixel & 0x1F;
+
+    if (color_mode == COLOR_MODE_DITHERED) {
+        /* Skip dithering for pure black - keep it solid */
+        if (pixel != 0) {
+            /* Ordered dithering with 4x4 Bayer matrix */
+            int dither = bayer4x4[src_y & 3][src_x & 3];
+            r5 = r5 + (dither >> 2);
+            g6 = g6 + (dither >> 1);
+            b5 = b5 + (dither >> 2);
+            if (r5 < 0) r5 = 0;
+            if (r5 > 31) r5 = 31;
+            if (g6 < 0) g6 = 0;
+            if (g6 > 63) g6 = 63;
+            if (b5 < 0) b5 = 0;
+            if (b5 > 31) b5 = 31;
+        }
+    } else if (color_mode == COLOR_MODE_DITHER2) {
+        /* Dither2: dither everything including black */
+        int dither = bayer4x4[src_y & 3][src_x & 3];
+        r5 = r5 + (dither >> 2);
+        g6 = g6 + (dither >> 1);
+        b5 = b5 + (dither >> 2);
+        if (r5 < 0) r5 = 0;
+        if (r5 > 31) r5 = 31;
+        if (g6 < 0) g6 = 0;
+        if (g6 > 63) g6 = 63;
+        if (b5 < 0) b5 = 0;
+        if (b5 > 31) b5 = 31;
+    } else if (color_mode == COLOR_MODE_NIGHT_DITHER) {
+        /* Night+Dither: apply gamma first, then dither */
+        r5 = gamma_r5[color_mode][r5];
+        g6 = gamma_g6[color_mode][g6];
+        b5 = gamma_b5[color_mode][b5];
+        /* Then apply dithering (skip for pure black) */
+        if (r5 != 0 || g6 != 0 || b5 != 0) {
+            int dither = bayer4x4[src_y & 3][src_x & 3];
+            r5 = r5 + (dither >> 2);
+            g6 = g6 + (dither >> 1);
+            b5 = b5 + (dither >> 2);
+            if (r5 < 0) r5 = 0;
+            if (r5 > 31) r5 = 31;
+            if (g6 < 0) g6 = 0;
+            if (g6 > 63) g6 = 63;
+            if (b5 < 0) b5 = 0;
+            if (b5 > 31) b5 = 31;
+        }
+    } else if (color_mode == COLOR_MODE_NIGHT_DITHER2) {
+        /* Night+Dither2: apply gamma first, then dither everything */
+        r5 = gamma_r5[color_mode][r5];
+        g6 = gamma_g6[color_mode][g6];
+        b5 = gamma_b5[color_mode][b5];
+        /* Dither including black for smoother transitions */
+        int dither = bayer4x4[src_y & 3][src_x & 3];
+        r5 = r5 + (dither >> 2);
+        g6 = g6 + (dither >> 1);
+        b5 = b5 + (dither >> 2);
+        if (r5 < 0) r5 = 0;
+        if (r5 > 31) r5 = 31;
+        if (g6 < 0) g6 = 0;
+        if (g6 > 63) g6 = 63;
+        if (b5 < 0) b5 = 0;
+        if (b5 > 31) b5 = 31;
+    } else {
+        /* Apply gamma/lifted blacks via lookup table */
+        r5 = gamma_r5[color_mode][r5];
+        g6 = gamma_g6[color_mode][g6];
+        b5 = gamma_b5[color_mode][b5];
+    }
+    return (r5 << 11) | (g6 << 5) | b5;
+}
+
 static int tjpgd_output(JDEC *jd, void *bitmap, JRECT *rect) {
     (void)jd;
     uint16_t *src = (uint16_t *)bitmap;
@@ -2059,68 +3318,7 @@ static int tjpgd_output(JDEC *jd, void *bitmap, JRECT *rect) {
             int src_y = rect->top + y;
 
             /* Apply color transformation if not unchanged */
-            if (color_mode != COLOR_MODE_UNCHANGED) {
-                int r5 = (pixel >> 11) & 0x1F;
-                int g6 = (pixel >> 5) & 0x3F;
-                int b5 = pixel & 0x1F;
-
-                if (color_mode == COLOR_MODE_DITHERED) {
-                    /* Skip dithering for pure black - keep it solid */
-                    if (pixel != 0) {
-                        /* Ordered dithering with 4x4 Bayer matrix */
-                        int dither = bayer4x4[src_y & 3][src_x & 3];
-                        r5 = r5 + (dither >> 2);
-                        g6 = g6 + (dither >> 1);
-                        b5 = b5 + (dither >> 2);
-                        if (r5 < 0) r5 = 0; if (r5 > 31) r5 = 31;
-                        if (g6 < 0) g6 = 0; if (g6 > 63) g6 = 63;
-                        if (b5 < 0) b5 = 0; if (b5 > 31) b5 = 31;
-                    }
-                } else if (color_mode == COLOR_MODE_DITHER2) {
-                    /* Dither2: dither everything including black */
-                    int dither = bayer4x4[src_y & 3][src_x & 3];
-                    r5 = r5 + (dither >> 2);
-                    g6 = g6 + (dither >> 1);
-                    b5 = b5 + (dither >> 2);
-                    if (r5 < 0) r5 = 0; if (r5 > 31) r5 = 31;
-                    if (g6 < 0) g6 = 0; if (g6 > 63) g6 = 63;
-                    if (b5 < 0) b5 = 0; if (b5 > 31) b5 = 31;
-                } else if (color_mode == COLOR_MODE_NIGHT_DITHER) {
-                    /* Night+Dither: apply gamma first, then dither */
-                    r5 = gamma_r5[color_mode][r5];
-                    g6 = gamma_g6[color_mode][g6];
-                    b5 = gamma_b5[color_mode][b5];
-                    /* Then apply dithering (skip for pure black) */
-                    if (r5 != 0 || g6 != 0 || b5 != 0) {
-                        int dither = bayer4x4[src_y & 3][src_x & 3];
-                        r5 = r5 + (dither >> 2);
-                        g6 = g6 + (dither >> 1);
-                        b5 = b5 + (dither >> 2);
-                        if (r5 < 0) r5 = 0; if (r5 > 31) r5 = 31;
-                        if (g6 < 0) g6 = 0; if (g6 > 63) g6 = 63;
-                        if (b5 < 0) b5 = 0; if (b5 > 31) b5 = 31;
-                    }
-                } else if (color_mode == COLOR_MODE_NIGHT_DITHER2) {
-                    /* Night+Dither2: apply gamma first, then dither everything */
-                    r5 = gamma_r5[color_mode][r5];
-                    g6 = gamma_g6[color_mode][g6];
-                    b5 = gamma_b5[color_mode][b5];
-                    /* Dither including black for smoother transitions */
-                    int dither = bayer4x4[src_y & 3][src_x & 3];
-                    r5 = r5 + (dither >> 2);
-                    g6 = g6 + (dither >> 1);
-                    b5 = b5 + (dither >> 2);
-                    if (r5 < 0) r5 = 0; if (r5 > 31) r5 = 31;
-                    if (g6 < 0) g6 = 0; if (g6 > 63) g6 = 63;
-                    if (b5 < 0) b5 = 0; if (b5 > 31) b5 = 31;
-                } else {
-                    /* Apply gamma/lifted blacks via lookup table */
-                    r5 = gamma_r5[color_mode][r5];
-                    g6 = gamma_g6[color_mode][g6];
-                    b5 = gamma_b5[color_mode][b5];
-                }
-                pixel = (r5 << 11) | (g6 << 5) | b5;
-            }
+            if (color_mode != COLOR_MODE_UNCHANGED) pixel = color_pixel(pixel, src_x, src_y);
 
             /* Apply scaling and offset */
             for (int sy = 0; sy < scale_factor; sy++) {
@@ -2167,35 +3365,31 @@ static void calculate_scaling(int width, int height) {
 
 /* ========== MPEG-4 Xvid Support ========== */
 
-/* YUV420P to RGB565 conversion with optional scaling
- * Uses lookup tables for speed (no per-pixel multiplication!)
- * BT.601 coefficients, supports TV (16-235) and PC (0-255) range */
-static void yuv420p_to_rgb565(uint8_t *y_plane, uint8_t *u_plane, uint8_t *v_plane,
-                               int y_stride, int uv_stride, int width, int height) {
-    /* Ensure YUV tables are initialized */
-    if (!yuv_tables_initialized) init_yuv_tables();
-
-    /* Get pointer to the Y table we need (TV or PC range) */
-    const int16_t *y_table = yuv_y_table[xvid_black_level];
-
-    /* Calculate scaling/centering for this frame */
-    if (width != video_width || height != video_height) {
-        calculate_scaling(width, height);
-        memset(framebuffer, 0, sizeof(framebuffer));
-    }
-
-    for (int j = 0; j < height && (offset_y + j * scale_factor) < SCREEN_HEIGHT; j++) {
-        uint8_t *y_row = y_plane + j * y_stride;
-        uint8_t *u_row = u_plane + (j >> 1) * uv_stride;
-        uint8_t *v_row = v_plane + (j >> 1) * uv_stride;
-
-        for (int i = 0; i < width && (offset_x + i * scale_factor) < SCREEN_WIDTH; i++) {
+/* One horizontal band of yuv420p_to_rgb565, source rows j0..j1-1 */
+typedef struct {
+    const uint8_t *y_plane, *u_plane, *v_plane;
+    int y_stride, uv_stride, width;
+    const int16_t *y_table;
+    int j0, j1;
+} yuv_band_t;
+
+/* Rows of a band land in their own framebuffer rows, and the colour mode,
+   tables and scaling are only read, so bands can run on any thread */
+static void yuv420p_to_rgb565_band(void *arg) {
+    const yuv_band_t *band = (const yuv_band_t *)arg;
+
+    for (int j = band->j0; j < band->j1 && (offset_y + j * scale_factor) < SCREEN_HEIGHT; j++) {
+        const uint8_t *y_row = band->y_plane + j * band->y_stride;
+        const uint8_t *u_row = band->u_plane + (j >> 1) * band->uv_stride;
+        const uint8_t *v_row = band->v_plane + (j >> 1) * band->uv_stride;
+
+        for (int i = 0; i < band->width && (offset_x + i * scale_factor) < SCREEN_WIDTH; i++) {
             /* Fast lookup-based YUV to RGB conversion */
             int y_idx = y_row[i];
             int u_idx = u_row[i >> 1];
             int v_idx = v_row[i >> 1];
 
-            int y = y_table[y_idx];  /* Y with TV/PC range correction */
+            int y = band->y_table[y_idx];  /* Y with TV/PC range correction */
             int r = y + yuv_rv_table[v_idx];
             int g = y + yuv_gu_table[u_idx] + yuv_gv_table[v_idx];
             int b = y + yuv_bu_table[u_idx];
@@ -2285,6 +3479,41 @@ static void yuv420p_to_rgb565(uint8_t *y_plane, uint8_t *u_plane, uint8_t *v_pla
     }
 }
 
+/* YUV420P to RGB565 conversion with optional scaling
+ * Uses lookup tables for speed (no per-pixel multiplication!)
+ * BT.601 coefficients, supports TV (16-235) and PC (0-255) range.
+ * Split into bands over convert_pool when there are worker threads */
+static void yuv420p_to_rgb565(uint8_t *y_plane, uint8_t *u_plane, uint8_t *v_plane,
+                               int y_stride, int uv_stride, int width, int height) {
+    yuv_band_t bands[CONVERT_MAX_BANDS];
+    int n = smp_pool_threads(convert_pool);
+
+    /* Ensure YUV tables are initialized */
+    if (!yuv_tables_initialized) init_yuv_tables();
+
+    /* Calculate scaling/centering for this frame */
+    if (width != video_width || height != video_height) {
+        calculate_scaling(width, height);
+        memset(framebuffer, 0, sizeof(framebuffer));
+    }
+
+    /* Bands of whole source rows */
+    if (n > CONVERT_MAX_BANDS) n = CONVERT_MAX_BANDS;
+    for (int k = 0; k < n; k++) {
+        bands[k].y_plane = y_plane;
+        bands[k].u_plane = u_plane;
+        bands[k].v_plane = v_plane;
+        bands[k].y_stride = y_stride;
+        bands[k].uv_stride = uv_stride;
+        bands[k].width = width;
+        /* Get pointer to the Y table we need (TV or PC range) */
+        bands[k].y_table = yuv_y_table[xvid_black_level];
+        bands[k].j0 = (k * (height / 2) / n) * 2;
+        bands[k].j1 = (k == n - 1) ? height : ((k + 1) * (height / 2) / n) * 2;
+    }
+    smp_pool_run(convert_pool, yuv420p_to_rgb565_band, bands, sizeof(yuv_band_t), n);
+}
+
 /* Debug: fill top of screen with color to show init progress AND display it */
 static void debug_init_progress(uint16_t color, int step) {
     /* Fill a horizontal bar at top showing progress */
@@ -2312,7 +3541,7 @@ static int init_xvid_mpeg4(void) {
     xvid_gbl_init_t xinit;
     memset(&xinit, 0, sizeof(xinit));
     xinit.version = XVID_VERSION;
-    xinit.cpu_flags = 0;  /* Auto-detect disabled, use C code */
+    xinit.cpu_flags = 0;  /* Auto-detect: MIPS32, SSE2 or NEON kernels */
 
     int ret = xvid_global(NULL, XVID_GBL_INIT, &xinit, NULL);
     if (ret < 0) {
@@ -2330,12 +3559,26 @@ static int init_xvid_mpeg4(void) {
     xcreate.width = xvid_width > 0 ? xvid_width : 320;
     xcreate.height = xvid_height > 0 ? xvid_height : 240;
 
+    /* Threads as configured, else one per core (1 on the SF2000) */
+    int threads = xvid_threads;
+    if (threads <= 0) {
+        xvid_gbl_info_t xinfo;
+        memset(&xinfo, 0, sizeof(xinfo));
+        xinfo.version = XVID_VERSION;
+        threads = xvid_global(NULL, XVID_GBL_INFO, &xinfo, NULL) >= 0 ? xinfo.num_threads : 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > XVID_MAX_THREADS) threads = XVID_MAX_THREADS;
+    xcreate.num_threads = threads;
+
     ret = xvid_decore(NULL, XVID_DEC_CREATE, &xcreate, NULL);
     if (ret < 0) {
         debug_init_progress(0xF800, 10); /* Red = create failed */
         return 0;
     }
     xvid_handle = xcreate.handle;
+    convert_pool = smp_pool_create(threads);
+    trace(1, "xvid: %d thread(s)\n", smp_pool_threads(convert_pool));
 
     /* Step 3: Cyan bar - decoder created */
     debug_init_progress(0x07FF, 3);
@@ -2350,6 +3593,8 @@ static int init_xvid_mpeg4(void) {
     if (!yuv_buffer) {
         xvid_decore(xvid_handle, XVID_DEC_DESTROY, NULL, NULL);
         xvid_handle = NULL;
+        smp_pool_destroy(convert_pool);
+        convert_pool = NULL;
         debug_init_progress(0xF800, 10); /* Red = alloc failed */
         return 0;
     }
@@ -2372,6 +3617,8 @@ static void close_xvid(void) {
         xvid_decore(xvid_handle, XVID_DEC_DESTROY, NULL, NULL);
         xvid_handle = NULL;
     }
+    smp_pool_destroy(convert_pool);
+    convert_pool = NULL;
     if (yuv_buffer) {
         free(yuv_buffer);
         yuv_buffer = NULL;
@@ -2380,6 +3627,10 @@ static void close_xvid(void) {
         yuv_v = NULL;
     }
     xvid_initialized = 0;
+    xvid_delay = 0;
+    xvid_next_chunk = 0;
+    xvid_shown = -1;
+    xvid_ref_pending = 0;
 }
 
 /* Debug: fill screen with solid color */
@@ -2434,8 +3685,46 @@ static void debug_show_hex(uint8_t *data, int size, int type, int ret) {
     /* ADPCM debug moved to show_debug panel (line y=32) which draws after video */
 }
 
-/* Decode MPEG-4 frame using Xvid */
-static int decode_mpeg4_frame(uint8_t *data, int size) {
+/* Fold one xvid_decore call's profile into the running second */
+static void xvid_profile_add(const xvid_dec_stats_t *s) {
+    xprof_overall += s->prof.overall;
+    xprof_ticks[XPROF_VLC] += s->prof.coding;
+    xprof_ticks[XPROF_PRED] += s->prof.prediction;
+    xprof_ticks[XPROF_IQ] += s->prof.iquant;
+    xprof_ticks[XPROF_IDCT] += s->prof.idct;
+    xprof_ticks[XPROF_XFER] += s->prof.transfer;
+    xprof_ticks[XPROF_MC] += s->prof.comp;
+    xprof_ticks[XPROF_EDGE] += s->prof.edges;
+    xprof_ticks[XPROF_OUT] += s->prof.conv;
+    memcpy(xprof_vops, s->prof.vops, sizeof(xprof_vops));
+}
+
+/* Once a second: turn the summed ticks into percentages and start over */
+static void xvid_profile_second(void) {
+    int i;
+    for (i = 0; i < XPROF_STAGES; i++) {
+        xprof_pct[i] = xprof_overall ? (int)(((uint64_t)xprof_ticks[i] * 100) / xprof_overall) : 0;
+        xprof_ticks[i] = 0;
+    }
+    xprof_valid = xprof_overall != 0;
+    trace(1, "xvid prof: vlc %d pred %d iq %d idct %d xfer %d mc %d edge %d out %d %% of %u ticks, I%d P%d B%d S%d N%d\n",
+          xprof_pct[XPROF_VLC], xprof_pct[XPROF_PRED], xprof_pct[XPROF_IQ], xprof_pct[XPROF_IDCT],
+          xprof_pct[XPROF_XFER], xprof_pct[XPROF_MC], xprof_pct[XPROF_EDGE], xprof_pct[XPROF_OUT],
+          (unsigned)xprof_overall, xprof_vops[0], xprof_vops[1], xprof_vops[2], xprof_vops[3], xprof_vops[4]);
+    xprof_overall = 0;
+}
+
+/* Convert the picture in the Xvid planes to the framebuffer */
+static void xvid_present(void) {
+    int w = xvid_width > 0 ? xvid_width : 320;
+    int h = xvid_height > 0 ? xvid_height : 240;
+    yuv420p_to_rgb565(yuv_y, yuv_u, yuv_v, w, w / 2, w, h);
+}
+
+/* Decode MPEG-4 frame using Xvid; size < 0 flushes the held-back picture.
+   Only converts to the framebuffer when present is set.
+   Returns 1 when a picture came out, 0 when none did, -1 on error */
+static int decode_mpeg4_frame(uint8_t *data, int size, int present) {
     /* Save first 20 bytes for debug (only first frame) */
     if (!debug_first_frame_saved && size >= 20) {
         memcpy(debug_first_frame, data, 20);
@@ -2446,7 +3735,7 @@ static int decode_mpeg4_frame(uint8_t *data, int size) {
         if (!init_xvid_mpeg4()) {
             /* Red screen = Xvid init failed */
             debug_fill_screen(0xF800);
-            return 0;
+            return -1;
         }
     }
 
@@ -2458,6 +3747,7 @@ static int decode_mpeg4_frame(uint8_t *data, int size) {
         memset(&svol, 0, sizeof(svol));
         xvol.version = XVID_VERSION;
         svol.version = XVID_VERSION;
+        xvol.general = XVID_LOWDELAY;
         xvol.bitstream = mpeg4_extradata;
         xvol.length = mpeg4_extradata_size;
         xvol.output.csp = XVID_CSP_NULL;  /* Don't output, just parse VOL */
@@ -2470,12 +3760,13 @@ static int decode_mpeg4_frame(uint8_t *data, int size) {
     xvid_dec_stats_t xstats;
 
     int w = xvid_width > 0 ? xvid_width : 320;
-    int h = xvid_height > 0 ? xvid_height : 240;
 
     uint8_t *bitstream = data;
     int remaining = size;
     int ret = 0;
     int loops = 0;
+    int bvop = 0;
+    int shown;
 
     /* Loop to consume VOS/VO/VOL headers until we get actual frame data */
     do {
@@ -2485,28 +3776,49 @@ static int decode_mpeg4_frame(uint8_t *data, int size) {
         xframe.version = XVID_VERSION;
         xstats.version = XVID_VERSION;
 
+        /* One picture out per chunk: packed B-frames are unpacked across
+           the following 0x7f placeholder instead of being dropped */
+        xframe.general = XVID_LOWDELAY;
+        if (xvid_fast_mc) xframe.general |= XVID_DEC_FASTMC;
         xframe.bitstream = bitstream;
         xframe.length = remaining;
 
-        /* Output to our YUV buffer - use PLANAR which respects separate plane pointers */
-        xframe.output.csp = XVID_CSP_PLANAR;
-        xframe.output.plane[0] = yuv_y;
-        xframe.output.plane[1] = yuv_u;
-        xframe.output.plane[2] = yuv_v;
-        xframe.output.stride[0] = w;
-        xframe.output.stride[1] = w / 2;
-        xframe.output.stride[2] = w / 2;
+        if (present) {
+            if (xvid_degrade >= DEGRADE_FAST) xframe.general |= XVID_DEC_FAST;
+            if (xvid_degrade >= DEGRADE_DROP) xframe.general |= XVID_DEC_DROP;
+
+            /* Deblock in place on our planes while there is time for it */
+            if (deblock_active) {
+                xframe.general |= XVID_DEBLOCKY | XVID_DEBLOCKUV;
+                xframe.deblock_quant = DEBLOCK_MIN_QUANT;
+            }
+
+            /* Output to our YUV buffer - use PLANAR which respects separate plane pointers */
+            xframe.output.csp = XVID_CSP_PLANAR;
+            xframe.output.plane[0] = yuv_y;
+            xframe.output.plane[1] = yuv_u;
+            xframe.output.plane[2] = yuv_v;
+            xframe.output.stride[0] = w;
+            xframe.output.stride[1] = w / 2;
+            xframe.output.stride[2] = w / 2;
+        } else {
+            /* Catching up after a seek: decode for the references only */
+            xframe.general |= XVID_DEC_PREROLL;
+            xframe.output.csp = XVID_CSP_NULL;
+        }
 
         /* Decode! */
         ret = xvid_decore(xvid_handle, XVID_DEC_DECODE, &xframe, &xstats);
+        xvid_profile_add(&xstats);
 
         /* If VOL decoded, update dimensions */
         if (xstats.type == XVID_TYPE_VOL) {
             if (xstats.data.vol.width > 0) xvid_width = xstats.data.vol.width;
             if (xstats.data.vol.height > 0) xvid_height = xstats.data.vol.height;
             w = xvid_width;
-            h = xvid_height;
         }
+        xvid_delay = xstats.delay;
+        bvop |= xstats.bvop;
 
         /* Advance bitstream pointer for next iteration */
         if (ret > 0) {
@@ -2515,69 +3827,388 @@ static int decode_mpeg4_frame(uint8_t *data, int size) {
         }
 
         loops++;
-    } while (xstats.type <= 0 && ret > 0 && remaining > 4 && loops < 10);
+    } while (xstats.type == XVID_TYPE_VOL && ret > 0 && remaining > 4 && loops < 10);
+
+    /* Flushing with nothing held back is not an error */
+    if (size < 0 && ret == XVID_ERR_END) ret = 0;
 
     /* DEBUG: Show first 8 bytes + type + ret + loops at top of screen */
-    debug_show_hex(data, size, xstats.type, ret);
+    if (present && data) debug_show_hex(data, size, xstats.type, ret);
 
     if (ret < 0) {
         /* Orange screen = decode error */
-        debug_fill_screen(0xFD20);
-        return 0;
+        if (present) debug_fill_screen(0xFD20);
+        return -1;
     }
 
-    /* Check if we got a frame */
-    if (xstats.type <= 0) {
-        /* No frame decoded yet (maybe needs more data) */
-        return 1;  /* Return success to avoid breaking playback */
-    }
+    /* A 0x7f placeholder hands out the reference held back by a packed
+       B-frame but reports no type */
+    shown = xstats.type > 0 || (size == 1 && ret == 1 && data[0] == 0x7f);
+
+    /* Any B-VOP, shown or dropped, leaves its packed reference pending */
+    if (shown || bvop) xvid_ref_pending = bvop;
+    if (!shown) return 0;
 
     /* Convert YUV420P to RGB565 and write to framebuffer */
-    yuv420p_to_rgb565(yuv_y, yuv_u, yuv_v, w, w / 2, w, h);
+    if (present) xvid_present();
 
     return 1;
 }
 
-/* Decode frame at index directly into framebuffer, return success */
-static int decode_single_frame(int idx) {
-    if (!video_file || idx >= total_frames) return 0;
+/* frame_buf size for a largest chunk of `size` bytes */
+static uint32_t frame_buf_bytes(uint32_t size) {
+    if (size < FRAME_BUF_MIN) size = FRAME_BUF_MIN;
+    if (size > FRAME_BUF_MAX) size = FRAME_BUF_MAX;
+    return (size + 4095) & ~4095u;
+}
 
-    uint32_t offset = frame_offsets[idx];
-    uint32_t size = frame_sizes[idx];
+/* Allocate frame_buf for a newly opened file: just big enough for its
+   largest chunk, so low-bitrate files don't pay for the worst case. The
+   strh hint only counts where the index has not seen every chunk yet
+   (OpenDML segments load lazily, idx1 and movi are read progressively) -
+   muxers often write a generous one */
+
+static void frame_buf_alloc(void) {
+    uint32_t size = max_frame_bytes;
+    if ((index_mode != INDEX_DONE || odml_video.segs > 0) && frame_hint_bytes > size) size = frame_hint_bytes;
+    size = frame_buf_bytes(size);
+
+    free(frame_buf);
+    frame_buf = (uint8_t *)malloc(size + XVID_BS_PADDING);
+    frame_buf_size = frame_buf ? size : 0;
+    xlog("Frame buffer: %u bytes (largest chunk %u)\n", (unsigned)frame_buf_size, (unsigned)max_frame_bytes);
+}
+
+/* The index is complete: fit frame_buf to its largest chunk, once, in
+   place of the strh hint and the growth since open */
+static void frame_buf_fit(void) {
+    uint32_t size = frame_buf_bytes(max_frame_bytes);
+    uint8_t *p;
+
+    if (!frame_buf || odml_video.segs > 0 || size == frame_buf_size) return;
+    p = (uint8_t *)realloc(frame_buf, size + XVID_BS_PADDING);
+    if (!p) return;
+    frame_buf = p;
+    frame_buf_size = size;
+    xlog("Frame buffer: %u bytes (largest chunk %u)\n", (unsigned)frame_buf_size, (unsigned)max_frame_bytes);
+}
+
+static void frame_buf_free(void) {
+    free(frame_buf);
+    frame_buf = NULL;
+    frame_buf_size = 0;
+}
+
+/* Make room for a chunk of `size` bytes, for chunks the index had not
+   reached when frame_buf was sized: a lazily loaded OpenDML segment, or
+   the part of idx1/movi indexed while playing, above the strh hint */
+static int frame_buf_reserve(uint32_t size) {
+    uint8_t *p;
+    if (size <= frame_buf_size) return 1;
+    if (size > FRAME_BUF_MAX) return 0;
+    size = (size + 4095) & ~4095u;
+    p = (uint8_t *)realloc(frame_buf, size + XVID_BS_PADDING);
+    if (!p) return 0;
+    frame_buf = p;
+    frame_buf_size = size;
+    return 1;
+}
+
+/* Feed AVI chunk `chunk` to Xvid; past the last chunk this flushes the
+   picture the decoder still holds. Returns as decode_mpeg4_frame */
+static int xvid_feed_chunk(int chunk, int present) {
+    if (chunk >= total_frames) return decode_mpeg4_frame(NULL, -1, present);
+
+    uint32_t size = frame_size(chunk);
+
+    /* Placeholder chunks (empty, or the 1-byte 0x7f of packed and dropped
+       frames) repeat the previous picture: no I/O, no decoder call. Except
+       right after a packed B-frame, where either is the held-back reference */
+    if (size <= 1 && !(xvid_ref_pending && !xvid_delay)) return 0;
+    if (size == 0) {
+        static uint8_t n_vop[1 + XVID_BS_PADDING] = { 0x7f };
+        decode_counter++;
+        return decode_mpeg4_frame(n_vop, 1, present);
+    }
+
+    /* The decoder needs the whole VOP; a truncated one only decodes to
+       garbage, so an oversized chunk is treated like a placeholder too */
+    if (!frame_buf_reserve(size)) {
+        trace(1, "xvid: chunk %d too large (%u bytes), skipped\n", chunk, (unsigned)size);
+        return 0;
+    }
+
+    if (pf_seek(video_file, frame_offset(chunk), SEEK_SET) != 0) return -1;
+    if (pf_read(video_file, frame_buf, size) != size) return -1;
+
+    /* It peeks past the end in whole words */
+    memset(frame_buf + size, 0, XVID_BS_PADDING);
+    decode_counter++;
+    return decode_mpeg4_frame(frame_buf, size, present);
+}
+
+/* Bring display index idx into the framebuffer, feeding chunks in order */
+static int xvid_show_frame(int idx) {
+    int fed = 0;
+
+    /* Refresh (menu, colour mode, after a seek): the planes already hold it */
+    if (idx == xvid_shown) {
+        xvid_present();
+        return 1;
+    }
+
+    /* Anything but the next picture in order (seek, loop) restarts at its
+       own chunk, and a reference held back before it is stale. No flush
+       or discontinuity here: without a keyframe index that would blank
+       everything up to the next I-frame */
+    if (xvid_next_chunk != idx + xvid_delay) {
+        xvid_next_chunk = idx;
+        xvid_ref_pending = 0;
+    }
+
+    /* The delay is only known once the first VOP is in, so it may take
+       one more chunk than expected */
+    while (xvid_next_chunk <= idx + xvid_delay && fed < 3) {
+        int chunk = xvid_next_chunk++;
+        if (xvid_feed_chunk(chunk, chunk >= idx + xvid_delay) < 0) {
+            xvid_shown = -1;
+            return 0;
+        }
+        fed++;
+    }
+
+    xvid_shown = idx;
+    return 1;
+}
+
+/* Set io up for MJPEG frame idx: read into frame_buf, or streamed from
+   the file when it is too large for it */
+static int jpeg_io_load(jpeg_io_t *io, int idx) {
+    uint32_t offset = frame_offset(idx);
+    uint32_t size = frame_size(idx);
 
-    if (size > MAX_JPEG_SIZE) size = MAX_JPEG_SIZE;
     if (size == 0) return 0;
 
-    if (fseek(video_file, offset, SEEK_SET) != 0) return 0;
-    if (fread(jpeg_buffer, 1, size, video_file) != size) return 0;
+    if (pf_seek(video_file, offset, SEEK_SET) != 0) return 0;
 
-    /* Branch based on video codec type */
-    if (video_codec_type == CODEC_TYPE_MPEG4) {
-        /* Decode MPEG-4 using Xvid */
-        int result = decode_mpeg4_frame(jpeg_buffer, size);
-        if (result) {
-            decode_counter++;
+    if (frame_buf_reserve(size)) {
+        if (pf_read(video_file, frame_buf, size) != size) return 0;
+        if (frame_buf[0] != 0xFF || frame_buf[1] != 0xD8) return 0;
+
+        /* Find/add EOI marker */
+        int eoi_pos = -1;
+        for (int i = size - 2; i >= 0; i--) {
+            if (frame_buf[i] == 0xFF && frame_buf[i+1] == 0xD9) {
+                eoi_pos = i;
+                break;
+            }
         }
-        return result;
+        if (eoi_pos >= 0) size = eoi_pos + 2;
+        else { frame_buf[size] = 0xFF; frame_buf[size+1] = 0xD9; size += 2; }
+
+        io->data = frame_buf;
+        io->size = size;
+    } else {
+        /* Oversized frame: TJpgDec pulls it from the file as it decodes */
+        uint8_t soi[2];
+        if (pf_read(video_file, soi, 2) != 2 || soi[0] != 0xFF || soi[1] != 0xD8) return 0;
+        io->data = NULL;
+        io->file_off = offset;
+        io->size = size + 2;
     }
+    io->pos = 0;
+    return 1;
+}
 
-    /* Default: MJPEG decoding via TJpgDec */
-    if (jpeg_buffer[0] != 0xFF || jpeg_buffer[1] != 0xD8) return 0;
+/* ========== PMPT tile codec ========== */
+/* RGB565 codec for the lowest CPU use, written by pmp-remux -t. Width and
+ * height are multiples of 8. A frame is a flags byte (TILE_FRAME_KEY: no
+ * skips, it decodes on its own), then runs over the 8x8 tiles in raster
+ * order. A run is an op byte, type in the top 3 bits and tiles - 1 in the
+ * low 5, and its data:
+ *   TILE_SKIP    none                          tiles stay as they were
+ *   TILE_FILL    1 colour                      all tiles that colour
+ *   TILE_PAL2    per tile 2 colours, 8 bytes of 1 bit indices
+ *   TILE_PAL4    per tile 4 colours, 16 bytes of 2 bit indices
+ *   TILE_PAL16   per tile 16 colours, 32 bytes of 4 bit indices
+ *   TILE_RAW     per tile 64 pixels
+ * Colours are little-endian RGB565, indices MSB first, rows top down */
+#define TILE_FRAME_KEY 0x01
+#define TILE_SKIP  0
+#define TILE_FILL  1
+#define TILE_PAL2  2
+#define TILE_PAL4  3
+#define TILE_PAL16 4
+#define TILE_RAW   5
+#define TILE_RUN_MAX 32
+#define TILE_KEY_SEARCH 900       /* chunks searched back for a keyframe on a seek */
+
+static const uint8_t tile_data_size[TILE_RAW + 1] = { 0, 2, 4 + 8, 8 + 16, 32 + 32, 128 };
+
+static uint16_t *tile_plane = NULL;  /* last frame decoded, before colour mode and scaling */
+static int tile_w = 0, tile_h = 0;
+static int tile_shown = -1;          /* frame in tile_plane */
+
+/* Decode a frame over plane (w x h). Returns 0 if it is malformed - the
+   tiles before the error are updated */
+static int tile_decode(const uint8_t *src, uint32_t size, uint16_t *plane, int w, int h) {
+    const uint8_t *end = src + size;
+    int cols = w >> 3, total = cols * (h >> 3), t = 0;
+    uint16_t pal[16];
+
+    if (size < 1) return 0;
+    src++;  /* flags */
+    while (t < total) {
+        if (src >= end) return 0;
+        int type = *src >> 5, n = (*src & 31) + 1;
+        src++;
+        if (type > TILE_RAW || n > total - t) return 0;
+        if (type == TILE_SKIP) {
+            t += n;
+            continue;
+        }
+        if (end - src < (type == TILE_FILL ? 2 : n * tile_data_size[type])) return 0;
+
+        for (; n > 0; n--, t++) {
+            uint16_t *dst = plane + (t / cols) * 8 * w + (t % cols) * 8;
+            switch (type) {
+            case TILE_FILL:
+                pal[0] = read_u16_le(src);
+                for (int y = 0; y < 8; y++, dst += w) {
+                    for (int x = 0; x < 8; x++) dst[x] = pal[0];
+                }
+                break;
+            case TILE_PAL2:
+                pal[0] = read_u16_le(src);
+                pal[1] = read_u16_le(src + 2);
+                for (int y = 0; y < 8; y++, dst += w) {
+                    uint8_t b = src[4 + y];
+                    for (int x = 0; x < 8; x++) dst[x] = pal[(b >> (7 - x)) & 1];
+                }
+                break;
+            case TILE_PAL4:
+                for (int i = 0; i < 4; i++) pal[i] = read_u16_le(src + i * 2);
+                for (int y = 0; y < 8; y++, dst += w) {
+                    const uint8_t *ix = src + 8 + y * 2;
+                    for (int x = 0; x < 8; x++) dst[x] = pal[(ix[x >> 2] >> (6 - (x & 3) * 2)) & 3];
+                }
+                break;
+            case TILE_PAL16:
+                for (int i = 0; i < 16; i++) pal[i] = read_u16_le(src + i * 2);
+                for (int y = 0; y < 8; y++, dst += w) {
+                    const uint8_t *ix = src + 32 + y * 4;
+                    for (int x = 0; x < 8; x += 2) {
+                        dst[x] = pal[ix[x >> 1] >> 4];
+                        dst[x + 1] = pal[ix[x >> 1] & 15];
+                    }
+                }
+                break;
+            default:  /* TILE_RAW: the SF2000 is little-endian like the data */
+                for (int y = 0; y < 8; y++, dst += w) memcpy(dst, src + y * 16, 16);
+                break;
+            }
+            if (type != TILE_FILL) src += tile_data_size[type];
+        }
+        if (type == TILE_FILL) src += 2;
+    }
+    return 1;
+}
 
-    /* Find/add EOI marker */
-    int eoi_pos = -1;
-    for (int i = size - 2; i >= 0; i--) {
-        if (jpeg_buffer[i] == 0xFF && jpeg_buffer[i+1] == 0xD9) {
-            eoi_pos = i;
-            break;
+/* Chunk idx starts a tile keyframe */
+static int tile_chunk_key(int idx) {
+    uint8_t flags;
+
+    if (frame_size(idx) < 1) return 0;
+    if (pf_seek(video_file, frame_offset(idx), SEEK_SET) != 0) return 0;
+    return pf_read(video_file, &flags, 1) == 1 && (flags & TILE_FRAME_KEY);
+}
+
+static void tile_close(void) {
+    free(tile_plane);
+    tile_plane = NULL;
+    tile_w = tile_h = 0;
+    tile_shown = -1;
+}
+
+/* tile_plane to the framebuffer: row copies unless scaled or colour mode */
+static void tile_present(void) {
+    int cols, rows;
+
+    if (tile_w != video_width || tile_h != video_height) {
+        calculate_scaling(tile_w, tile_h);
+        memset(framebuffer, 0, sizeof(framebuffer));
+    }
+    cols = (SCREEN_WIDTH - offset_x) / scale_factor;
+    rows = (SCREEN_HEIGHT - offset_y) / scale_factor;
+    if (cols > tile_w) cols = tile_w;
+    if (rows > tile_h) rows = tile_h;
+
+    if (scale_factor == 1 && color_mode == COLOR_MODE_UNCHANGED) {
+        for (int y = 0; y < rows; y++) {
+            memcpy(&framebuffer[(offset_y + y) * SCREEN_WIDTH + offset_x], tile_plane + y * tile_w, cols * sizeof(pixel_t));
+        }
+        return;
+    }
+    for (int y = 0; y < rows; y++) {
+        const uint16_t *src = tile_plane + y * tile_w;
+        for (int x = 0; x < cols; x++) {
+            uint16_t pixel = src[x];
+            if (color_mode != COLOR_MODE_UNCHANGED) pixel = color_pixel(pixel, x, y);
+            pixel_t *dst = &framebuffer[(offset_y + y * scale_factor) * SCREEN_WIDTH + offset_x + x * scale_factor];
+            for (int sy = 0; sy < scale_factor; sy++, dst += SCREEN_WIDTH) {
+                for (int sx = 0; sx < scale_factor; sx++) dst[sx] = pixel;
+            }
+        }
+    }
+}
+
+/* Show frame idx. The next frame in order only updates what changed,
+   anything else decodes forward from the keyframe before it */
+static int tile_show_frame(int idx) {
+    int start = idx;
+
+    if (idx == tile_shown) {
+        tile_present();
+        return 1;
+    }
+    if (!tile_plane) {
+        if (xvid_width <= 0 || xvid_height <= 0 || (xvid_width & 7) || (xvid_height & 7)) return 0;
+        tile_plane = (uint16_t *)calloc(xvid_width * xvid_height, sizeof(uint16_t));
+        if (!tile_plane) return 0;
+        tile_w = xvid_width;
+        tile_h = xvid_height;
+    }
+    if (idx != tile_shown + 1) {
+        start = keyframe_before(idx, TILE_KEY_SEARCH);
+        if (start < 0) start = idx;
+    }
+
+    for (int i = start; i <= idx; i++) {
+        uint32_t size = frame_size(i);
+        if (size <= 1) continue;  /* dropped frame: the picture stays */
+        if (!frame_buf_reserve(size) || pf_seek(video_file, frame_offset(i), SEEK_SET) != 0 ||
+            pf_read(video_file, frame_buf, size) != size) {
+            tile_shown = -1;
+            return 0;
         }
+        if (!tile_decode(frame_buf, size, tile_plane, tile_w, tile_h)) trace(1, "tile: frame %d malformed\n", i);
     }
-    if (eoi_pos >= 0) size = eoi_pos + 2;
-    else { jpeg_buffer[size] = 0xFF; jpeg_buffer[size+1] = 0xD9; size += 2; }
+    tile_shown = idx;
+    tile_present();
+    decode_counter++;
+    return 1;
+}
 
-    jpeg_io.data = jpeg_buffer;
-    jpeg_io.size = size;
-    jpeg_io.pos = 0;
+/* Decode frame at index directly into framebuffer, return success */
+static int decode_single_frame(int idx) {
+    if (!video_file || idx >= total_frames) return 0;
+
+    /* Xvid reads its own chunks: B-frame delay and placeholders */
+    if (video_codec_type == CODEC_TYPE_MPEG4) return xvid_show_frame(idx);
+    if (video_codec_type == CODEC_TYPE_TILE) return tile_show_frame(idx);
+
+    /* Default: MJPEG decoding via TJpgDec */
+    if (!jpeg_io_load(&jpeg_io, idx)) return 0;
 
     JDEC jdec;
     if (jd_prepare(&jdec, tjpgd_input, tjpgd_work, TJPGD_WORKSPACE_SIZE, &jpeg_io) != JDR_OK)
@@ -2598,11 +4229,40 @@ static int decode_single_frame(int idx) {
 }
 
 /* Forward declaration */
-static void refill_audio_ring(void);
+static int refill_audio_ring(int max_bytes);
 static void mp3_reset(void);
+static void mp3_index_clear(void);
+static uint64_t mp3_seek_to_sample(uint64_t target, int effective_rate);
+static int audio_effective_rate(void);
+static uint64_t frame_to_samples(int frame, int sub, int subs, int rate);
+static void audio_sync_reset(void);
+
+/* First audio chunk to sum sizes from to reach stream byte target: with
+   OpenDML segment lengths, the first of the segment that holds it, else
+   chunk 0. *before gets the bytes ahead of that chunk */
+static int audio_sum_start(uint64_t target, uint64_t *before) {
+    odml_index_t *ix = &odml_audio;
+    int lo = 0, hi = ix->segs - 1;
+
+    *before = 0;
+    if (!ix->segs || !ix->sized) return 0;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (ix->seg[mid].before <= target) lo = mid;
+        else hi = mid - 1;
+    }
+    /* Loading it checks its length against the indx */
+    if (ix->seg[lo].count > 0) audio_size(ix->seg[lo].first);
+    if (!ix->sized) return 0;
+    *before = ix->seg[lo].before;
+    return ix->seg[lo].first;
+}
 
 /* Seek to specific frame */
 static void seek_to_frame(int target_frame) {
+    /* Past the indexed region: wait only for the part that is needed */
+    index_until(target_frame);
+
     if (target_frame < 0) target_frame = 0;
     if (target_frame >= total_frames) target_frame = total_frames - 1;
 
@@ -2613,82 +4273,71 @@ static void seek_to_frame(int target_frame) {
     /* Estimate audio position based on time */
     if (has_audio && audio_bytes_per_sample > 0) {
         /* For MP3: use detected sample rate if different from AVI header */
-        int effective_rate = audio_sample_rate;
-        if (audio_format == AUDIO_FMT_MP3 && mp3_detected_samplerate > 0) {
-            effective_rate = mp3_detected_samplerate;
-        }
-        uint64_t time_samples = (uint64_t)target_frame * effective_rate / clip_fps;
+        int effective_rate = audio_effective_rate();
+        uint64_t time_samples = frame_to_samples(target_frame, 0, 1, effective_rate);
 
         /* Calculate audio chunk position */
         audio_chunk_idx = 0;
         audio_chunk_pos = 0;
 
         if (audio_format == AUDIO_FMT_MP3) {
-            /* MP3: each AVI chunk = one MP3 frame = fixed samples
-             * MPEG-1 Layer III (>=32kHz): 1152 samples/frame
-             * MPEG-2 Layer III (<32kHz):  576 samples/frame
-             */
-            int samples_per_mp3_frame = (effective_rate >= 32000) ? 1152 : 576;
-            audio_chunk_idx = time_samples / samples_per_mp3_frame;
-            if (audio_chunk_idx >= total_audio_chunks) {
-                audio_chunk_idx = total_audio_chunks - 1;
-            }
-            audio_chunk_pos = 0;
-            /* Align audio_samples_sent to chunk boundary */
-            time_samples = (uint64_t)audio_chunk_idx * samples_per_mp3_frame;
-        } else if (audio_format == AUDIO_FMT_ADPCM && adpcm_samples_per_block > 0 && adpcm_block_align > 0) {
-            /* ADPCM: calculate compressed bytes then find chunk */
+            /* MP3: frame-header index gives the exact chunk, decoder state is
+             * muted (not reallocated) and the pre-roll is dropped after decode */
+            mp3_reset();
+            time_samples = mp3_seek_to_sample(time_samples, effective_rate);
+        } else if ((audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_IMA) &&
+                   adpcm_samples_per_block > 0 && adpcm_block_align > 0) {
+            /* ADPCM (MS or IMA): calculate compressed bytes then find chunk */
             uint64_t target_blocks = time_samples / adpcm_samples_per_block;
             uint64_t target_bytes = target_blocks * adpcm_block_align;
-            uint64_t bytes_so_far = 0;
+            uint64_t bytes_so_far;
 
+            audio_chunk_idx = audio_sum_start(target_bytes, &bytes_so_far);
             while (audio_chunk_idx < total_audio_chunks) {
-                if (bytes_so_far + audio_sizes[audio_chunk_idx] > target_bytes) {
+                if (bytes_so_far + audio_size(audio_chunk_idx) > target_bytes) {
                     uint32_t pos_in_chunk = target_bytes - bytes_so_far;
                     pos_in_chunk = (pos_in_chunk / adpcm_block_align) * adpcm_block_align;
                     audio_chunk_pos = pos_in_chunk;
                     break;
                 }
-                bytes_so_far += audio_sizes[audio_chunk_idx];
+                bytes_so_far += audio_size(audio_chunk_idx);
                 audio_chunk_idx++;
             }
         } else {
             /* PCM: samples * bytes_per_sample = file position */
             uint64_t target_bytes = time_samples * audio_bytes_per_sample;
-            uint64_t bytes_so_far = 0;
+            uint64_t bytes_so_far;
 
+            audio_chunk_idx = audio_sum_start(target_bytes, &bytes_so_far);
             while (audio_chunk_idx < total_audio_chunks) {
-                if (bytes_so_far + audio_sizes[audio_chunk_idx] > target_bytes) {
+                if (bytes_so_far + audio_size(audio_chunk_idx) > target_bytes) {
                     audio_chunk_pos = target_bytes - bytes_so_far;
                     break;
                 }
-                bytes_so_far += audio_sizes[audio_chunk_idx];
+                bytes_so_far += audio_size(audio_chunk_idx);
                 audio_chunk_idx++;
             }
         }
 
         audio_samples_sent = time_samples;
+        audio_sync_reset();
         aring_read = 0;
         aring_write = 0;
         aring_count = 0;
 
         /* Debug: log seek values */
         if (audio_format == AUDIO_FMT_MP3) {
-            int spf = (effective_rate >= 32000) ? 1152 : 576;
-            xlog("SEEK MP3: vfr=%d chunk=%d/%d spf=%d sent=%llu\n",
-                 target_frame, audio_chunk_idx, total_audio_chunks, spf,
-                 (unsigned long long)audio_samples_sent);
-        } else if (audio_format == AUDIO_FMT_ADPCM) {
+            xlog("SEEK MP3: vfr=%d chunk=%d/%d pos=%u skip=%u sent=%llu\n",
+                 target_frame, audio_chunk_idx, total_audio_chunks, audio_chunk_pos,
+                 mp3_skip_samples, (unsigned long long)audio_samples_sent);
+        } else if (audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_IMA) {
             xlog("SEEK ADPCM: frame=%d chunk=%d/%d pos=%u blk=%d\n",
                  target_frame, audio_chunk_idx, total_audio_chunks, audio_chunk_pos, adpcm_block_align);
         }
 
-        /* For MP3: skip refill during seek (decoder is experimental and may hang) */
-        if (audio_format == AUDIO_FMT_MP3) {
-            mp3_reset();
-            /* Don't call refill_audio_ring() - let normal playback handle it */
-        } else {
-            refill_audio_ring();
+        /* For MP3: skip refill during seek - let normal playback decode the pre-roll */
+        if (audio_format != AUDIO_FMT_MP3) {
+            refill_audio_ring(AUDIO_SLICE_BYTES);
         }
     }
 
@@ -2696,19 +4345,482 @@ static void seek_to_frame(int target_frame) {
     decode_single_frame(target_frame);
 }
 
+/* ========== Seek preview thumbnails ========== */
+
+/* Where a sw x sh picture goes in a preview: fitted, aspect kept */
+static void thumb_fit(int sw, int sh, int *x0, int *y0, int *tw, int *th) {
+    *tw = THUMB_W;
+    *th = THUMB_W * sh / sw;
+    if (*th > THUMB_H) {
+        *th = THUMB_H;
+        *tw = THUMB_H * sw / sh;
+    }
+    if (*tw < 1) *tw = 1;
+    if (*th < 1) *th = 1;
+    *x0 = (THUMB_W - *tw) / 2;
+    *y0 = (THUMB_H - *th) / 2;
+}
+
+/* MJPEG at 1/8 scale lands here before it is fitted */
+static uint16_t *thumb_rgb = NULL;
+static int thumb_rgb_w = 0, thumb_rgb_h = 0;
+
+static int thumb_jpeg_output(JDEC *jd, void *bitmap, JRECT *rect) {
+    (void)jd;
+    uint16_t *src = (uint16_t *)bitmap;
+    int w = rect->right - rect->left + 1;
+
+    for (int y = rect->top; y <= rect->bottom && y < thumb_rgb_h; y++) {
+        for (int x = rect->left; x <= rect->right && x < thumb_rgb_w; x++) {
+            thumb_rgb[y * thumb_rgb_w + x] = src[(y - rect->top) * w + (x - rect->left)];
+        }
+    }
+    return 1;
+}
+
+/* thumb_rgb fitted into a preview */
+static void thumb_from_rgb(pixel_t *dst) {
+    int x0, y0, tw, th;
+
+    thumb_fit(thumb_rgb_w, thumb_rgb_h, &x0, &y0, &tw, &th);
+    for (int y = 0; y < th; y++) {
+        const uint16_t *row = thumb_rgb + (y * thumb_rgb_h / th) * thumb_rgb_w;
+        for (int x = 0; x < tw; x++) {
+            dst[(y0 + y) * THUMB_W + x0 + x] = row[x * thumb_rgb_w / tw];
+        }
+    }
+}
+
+static int thumb_from_jpeg(int idx, pixel_t *dst) {
+    jpeg_io_t io;
+    JDEC jdec;
+    int x0, y0, tw, th, ok;
+
+    if (!jpeg_io_load(&io, idx)) return 0;
+    if (jd_prepare(&jdec, tjpgd_input, tjpgd_work, TJPGD_WORKSPACE_SIZE, &io) != JDR_OK) return 0;
+
+    /* Every 8x8 block comes out as its DC value: no IDCT at all */
+    thumb_rgb_w = jdec.width >> 3;
+    thumb_rgb_h = jdec.height >> 3;
+    if (thumb_rgb_w < 1 || thumb_rgb_h < 1) return 0;
+    thumb_rgb = (uint16_t *)calloc(thumb_rgb_w * thumb_rgb_h, sizeof(uint16_t));
+    if (!thumb_rgb) return 0;
+
+    ok = (jd_decomp(&jdec, thumb_jpeg_output, 3) == JDR_OK);
+    if (ok) thumb_from_rgb(dst);
+    free(thumb_rgb);
+    thumb_rgb = NULL;
+    return ok;
+}
+
+/* Coding type of the first VOP in chunk idx (0 I, 1 P, 2 B, 3 S), or -1
+   if none starts within its first bytes */
+static int xvid_chunk_vop_type(int idx) {
+    uint8_t buf[128];
+    uint32_t n = frame_size(idx);
+
+    if (n > sizeof(buf)) n = sizeof(buf);
+    if (n < 5) return -1;
+    if (pf_seek(video_file, frame_offset(idx), SEEK_SET) != 0) return -1;
+    if (pf_read(video_file, buf, n) != n) return -1;
+    for (uint32_t i = 0; i + 4 < n; i++) {
+        if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1 && buf[i + 3] == 0xB6) return buf[i + 4] >> 6;
+    }
+    return -1;
+}
+
+/* Search back from *pos to (not including) end for a frame that decodes
+   on its own: any real frame for MJPEG, an I-VOP for Xvid, a keyframe for
+   PMPT. Frames the index flags as delta are skipped without reading
+   them; at most max chunks are read. Returns the frame, -1 if there is
+   none, or -2 with *pos where to go on once max chunks were read */
+static int keyframe_scan(int *pos, int end, int max) {
+    if (end < -1) end = -1;
+    for (int i = *pos; i > end; i--) {
+        if (frame_size(i) <= 1) continue;  /* dropped frame placeholders */
+        if (video_codec_type == CODEC_TYPE_MJPEG) return i;
+        if (frame_is_delta(i)) continue;
+        if (max-- == 0) {
+            *pos = i;
+            return -2;
+        }
+        if (video_codec_type == CODEC_TYPE_TILE) {
+            if (tile_chunk_key(i)) return i;
+        } else if (xvid_chunk_vop_type(i) == 0) return i;
+    }
+    return -1;
+}
+
+/* Last frame at or before idx (at most limit chunks back) that decodes on
+   its own. Returns -1 if none */
+static int keyframe_before(int idx, int limit) {
+    return keyframe_scan(&idx, idx - limit, -1);
+}
+
+/* Read chunk idx into frame_buf for Xvid. Returns its size, -1 on failure */
+static int thumb_read_chunk(int idx) {
+    uint32_t size = frame_size(idx);
+
+    if (size == 0 || !frame_buf_reserve(size)) return -1;
+    if (pf_seek(video_file, frame_offset(idx), SEEK_SET) != 0) return -1;
+    if (pf_read(video_file, frame_buf, size) != size) return -1;
+    memset(frame_buf + size, 0, XVID_BS_PADDING);
+    return (int)size;
+}
+
+/* A tile keyframe decodes on its own into a blank plane */
+static int thumb_from_tile(int idx, pixel_t *dst) {
+    int size;
+
+    if (xvid_width <= 0 || xvid_height <= 0 || (xvid_width & 7) || (xvid_height & 7)) return 0;
+    if ((size = thumb_read_chunk(idx)) <= 0) return 0;
+    thumb_rgb_w = xvid_width;
+    thumb_rgb_h = xvid_height;
+    thumb_rgb = (uint16_t *)calloc(thumb_rgb_w * thumb_rgb_h, sizeof(uint16_t));
+    if (!thumb_rgb) return 0;
+    tile_decode(frame_buf, size, thumb_rgb, thumb_rgb_w, thumb_rgb_h);
+    thumb_from_rgb(dst);
+    free(thumb_rgb);
+    thumb_rgb = NULL;
+    return 1;
+}
+
+/* Feed a chunk to the preview decoder, size < 0 flushes it. With out set
+   the picture goes to thumb_yuv. Returns 1 when one came out, 0 when it
+   is held back, -1 on error */
+static int thumb_xvid_feed(uint8_t *data, int size, int out) {
+    xvid_dec_frame_t xframe;
+    xvid_dec_stats_t xstats;
+    int w = xvid_width, h = xvid_height;
+    int ret, loops = 0;
+
+    do {
+        memset(&xframe, 0, sizeof(xframe));
+        memset(&xstats, 0, sizeof(xstats));
+        xframe.version = XVID_VERSION;
+        xstats.version = XVID_VERSION;
+
+        /* Each keyframe stands alone: nothing before it is output */
+        xframe.general = (size >= 0) ? XVID_DISCONTINUITY : 0;
+        xframe.bitstream = data;
+        xframe.length = size;
+        if (out) {
+            xframe.output.csp = XVID_CSP_PLANAR;
+            xframe.output.plane[0] = thumb_yuv;
+            xframe.output.plane[1] = thumb_yuv + w * h;
+            xframe.output.plane[2] = thumb_yuv + w * h + (w / 2) * (h / 2);
+            xframe.output.stride[0] = w;
+            xframe.output.stride[1] = w / 2;
+            xframe.output.stride[2] = w / 2;
+        } else {
+            xframe.output.csp = XVID_CSP_NULL;
+        }
+
+        ret = xvid_decore(thumb_xvid, XVID_DEC_DECODE, &xframe, &xstats);
+
+        /* A VOL for another size would not fit thumb_yuv */
+        if (xstats.type == XVID_TYPE_VOL &&
+            (xstats.data.vol.width > w || xstats.data.vol.height > h)) return -1;
+
+        if (ret > 0) {
+            data += ret;
+            size -= ret;
+        }
+        loops++;
+    } while (xstats.type == XVID_TYPE_VOL && ret > 0 && size > 4 && loops < 10);
+
+    if (ret < 0) return -1;
+    return xstats.type > 0;
+}
+
+static void thumb_xvid_close(void) {
+    if (thumb_xvid) {
+        xvid_decore(thumb_xvid, XVID_DEC_DESTROY, NULL, NULL);
+        thumb_xvid = NULL;
+    }
+    free(thumb_yuv);
+    thumb_yuv = NULL;
+}
+
+/* Second decoder for the previews, so the playback references stay as
+   they are. Needs the size, i.e. the main decoder has seen the VOL */
+static int thumb_xvid_open(void) {
+    xvid_dec_create_t xcreate;
+    int w = xvid_width, h = xvid_height;
+    int size;
+
+    if (!xvid_initialized || w <= 0 || h <= 0) return 0;
+
+    thumb_yuv = (uint8_t *)malloc(w * h + 2 * (w / 2) * (h / 2));
+    if (!thumb_yuv) return 0;
+
+    memset(&xcreate, 0, sizeof(xcreate));
+    xcreate.version = XVID_VERSION;
+    xcreate.width = w;
+    xcreate.height = h;
+    xcreate.num_threads = 1;
+    if (xvid_decore(NULL, XVID_DEC_CREATE, &xcreate, NULL) < 0) {
+        thumb_xvid_close();
+        return 0;
+    }
+    thumb_xvid = xcreate.handle;
+
+    /* VOL from strf, else from the first chunk which carries it in-band */
+    if (mpeg4_extradata_size > 0) {
+        thumb_xvid_feed(mpeg4_extradata, mpeg4_extradata_size, 0);
+    } else if ((size = thumb_read_chunk(0)) > 0) {
+        thumb_xvid_feed(frame_buf, size, 0);
+    }
+    return 1;
+}
+
+/* Decode I-VOP chunk idx and subsample it into a preview */
+static int thumb_from_xvid(int idx, pixel_t *dst) {
+    int w = xvid_width, h = xvid_height;
+    int x0, y0, tw, th, size, r;
+
+    if (!thumb_xvid && !thumb_xvid_open()) return 0;
+    if ((size = thumb_read_chunk(idx)) < 0) return 0;
+
+    r = thumb_xvid_feed(frame_buf, size, 1);
+    /* With B-frames the decoder holds the reference back: flush it out */
+    if (r == 0) r = thumb_xvid_feed(NULL, -1, 1);
+    if (r <= 0) return 0;
+
+    const uint8_t *yp = thumb_yuv;
+    const uint8_t *up = thumb_yuv + w * h;
+    const uint8_t *vp = up + (w / 2) * (h / 2);
+    const int16_t *y_table = yuv_y_table[xvid_black_level];
+
+    thumb_fit(w, h, &x0, &y0, &tw, &th);
+    for (int y = 0; y < th; y++) {
+        int sy = (2 * y + 1) * h / (2 * th);
+        for (int x = 0; x < tw; x++) {
+            int sx = (2 * x + 1) * w / (2 * tw);
+            int u_idx = up[(sy >> 1) * (w / 2) + (sx >> 1)];
+            int v_idx = vp[(sy >> 1) * (w / 2) + (sx >> 1)];
+            int yy = y_table[yp[sy * w + sx]];
+            int rr = yy + yuv_rv_table[v_idx];
+            int gg = yy + yuv_gu_table[u_idx] + yuv_gv_table[v_idx];
+            int bb = yy + yuv_bu_table[u_idx];
+            if (rr < 0) rr = 0; else if (rr > 255) rr = 255;
+            if (gg < 0) gg = 0; else if (gg > 255) gg = 255;
+            if (bb < 0) bb = 0; else if (bb > 255) bb = 255;
+            dst[(y0 + y) * THUMB_W + x0 + x] = ((rr >> 3) << 11) | ((gg >> 2) << 5) | (bb >> 3);
+        }
+    }
+    return 1;
+}
+
+/* Preview for slider step p: the step's frame for MJPEG, the last I-VOP
+   (tile keyframe) at or before it for Xvid (PMPT). Returns the frame
+   shown, or THUMB_NONE */
+static int thumb_build(int p, pixel_t *dst) {
+    int target = p * total_frames / 20;
+    if (target >= total_frames) target = total_frames - 1;
+
+    memset(dst, 0, THUMB_W * THUMB_H * sizeof(pixel_t));
+    int i = keyframe_before(target, THUMB_KEY_SEARCH);
+    if (i < 0) return THUMB_NONE;
+    if (video_codec_type == CODEC_TYPE_TILE) return thumb_from_tile(i, dst) ? i : THUMB_NONE;
+    if (video_codec_type != CODEC_TYPE_MPEG4) return thumb_from_jpeg(i, dst) ? i : THUMB_NONE;
+    return thumb_from_xvid(i, dst) ? i : THUMB_NONE;
+}
+
+/* The sidecar belongs to the file with this frame count and last chunk */
+static void thumb_header_fill(thumb_header_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->magic = THUMB_MAGIC;
+    h->version = THUMB_VERSION;
+    h->count = THUMB_COUNT;
+    h->width = THUMB_W;
+    h->height = THUMB_H;
+    h->frames = total_frames;
+    h->last_offset = frame_offset(total_frames - 1);
+    h->last_size = frame_size(total_frames - 1);
+}
+
+static int thumb_load(void) {
+    thumb_header_t want, got;
+    int fd, ok;
+
+    thumb_header_fill(&want);
+    fd = fs_open(thumb_path, FS_O_RDONLY, 0);
+    if (fd < 0) return 0;
+    ok = fs_read(fd, &got, sizeof(got)) == sizeof(got) &&
+         memcmp(&got, &want, offsetof(thumb_header_t, frame)) == 0 &&
+         fs_read(fd, thumb_pixels, sizeof(thumb_pixels)) == sizeof(thumb_pixels);
+    fs_close(fd);
+    if (!ok) return 0;
+
+    for (int i = 0; i < THUMB_COUNT; i++) {
+        thumb_frame[i] = (got.frame[i] >= 0 && got.frame[i] < total_frames) ? got.frame[i] : THUMB_NONE;
+    }
+    thumb_next = THUMB_COUNT;
+    return 1;
+}
+
+static void thumb_save(void) {
+    thumb_header_t h;
+    int fd;
+
+    thumb_header_fill(&h);
+    for (int i = 0; i < THUMB_COUNT; i++) h.frame[i] = thumb_frame[i];
+
+    fd = fs_open(thumb_path, FS_O_WRONLY | FS_O_CREAT | FS_O_TRUNC, 0666);
+    if (fd < 0) return;  /* read-only card: built again next time */
+    if (fs_write(fd, &h, sizeof(h)) != sizeof(h) ||
+        fs_write(fd, thumb_pixels, sizeof(thumb_pixels)) != sizeof(thumb_pixels)) {
+        trace(1, "thumbs: writing %s failed\n", thumb_path);
+    }
+    fs_close(fd);
+}
+
+/* New file: previews come from its sidecar or get built again */
+static void thumb_reset(const char *path) {
+    thumb_xvid_close();
+    snprintf(thumb_path, FB_MAX_PATH, "%s.thm", path);
+    for (int i = 0; i < THUMB_COUNT; i++) thumb_frame[i] = THUMB_TODO;
+    thumb_next = 0;
+    thumb_built = 0;
+    thumb_checked = 0;
+    seek_pending = 0;
+}
+
+/* Build previews in paused ticks (the menu pauses), the slider's step
+   first. Steps are fractions of the length, so only once it is known */
+static void thumb_background(void) {
+    if (!video_file || thumb_next >= THUMB_COUNT || index_mode != INDEX_DONE || total_frames <= 0) return;
+    if (is_playing && !is_paused) return;
+    if (video_codec_type == CODEC_TYPE_MPEG4 && !xvid_initialized) return;
+
+    if (!thumb_checked) {
+        thumb_checked = 1;
+        if (thumb_load()) {
+            xlog("Seek previews: %s\n", thumb_path);
+            return;
+        }
+    }
+
+    retro_time_t deadline = sched_tick_start +
+                            (1000000 / DISPLAY_FPS) * (100 - AUDIO_TICK_RESERVE_PCT) / 100;
+    do {
+        int p;
+        if (menu_active && menu_selection == 1 && thumb_frame[seek_position] == THUMB_TODO) {
+            p = seek_position;
+        } else {
+            while (thumb_next < THUMB_COUNT && thumb_frame[thumb_next] != THUMB_TODO) thumb_next++;
+            if (thumb_next >= THUMB_COUNT) break;
+            p = thumb_next;
+        }
+        thumb_frame[p] = thumb_build(p, thumb_pixels[p]);
+        thumb_built++;
+    } while (perf_get_time_usec && perf_get_time_usec() < deadline);
+
+    while (thumb_next < THUMB_COUNT && thumb_frame[thumb_next] != THUMB_TODO) thumb_next++;
+    if (thumb_next >= THUMB_COUNT) {
+        int shown = 0;
+        for (int i = 0; i < THUMB_COUNT; i++) shown += (thumb_frame[i] >= 0);
+        thumb_xvid_close();
+        if (shown) thumb_save();  /* nothing decoded: maybe out of memory, try again next time */
+        xlog("Seek previews: %d of %d built\n", shown, thumb_built);
+    }
+}
+
+/* Go to Position slider moved: with a preview for the step the seek waits
+   until the menu is left, without one it happens now as before */
+static void seek_slider_moved(void) {
+    seek_pending = (thumb_frame[seek_position] >= 0);
+    if (!seek_pending) {
+        seek_to_frame(slider_frame());
+        decode_single_frame(current_frame_idx);
+    }
+}
+
+/* Carry out the seek the slider previewed. Returns 0 if there was none */
+static int seek_commit(void) {
+    if (!seek_pending) return 0;
+    seek_pending = 0;
+    seek_to_frame(slider_frame());
+    return 1;
+}
+
+/* End of a scrub: Xvid resumes at the I-VOP on screen, MJPEG at the cursor */
+static void scrub_finish(void) {
+    int target = scrub_cursor;
+
+    if (video_codec_type == CODEC_TYPE_MPEG4 && scrub_shown >= 0) target = scrub_shown;
+    scrub_active = 0;
+    seek_to_frame(target);
+    decode_single_frame(current_frame_idx);
+    xlog("Scrub: frame %d\n", current_frame_idx);
+}
+
+/* One tick of a scrub: move the cursor, show the keyframe at or before it */
+static void scrub_step(void) {
+    if (!scrub_active) {
+        scrub_active = 1;
+        scrub_cursor = current_frame_idx;
+        scrub_shown = -1;
+        scrub_key_pos = -1;
+        scrub_speed = SCRUB_START_SPEED;
+        scrub_acc = 0;
+    } else if ((scrub_ticks - SCRUB_HOLD_TICKS) % SCRUB_ACCEL_TICKS == 0 && scrub_speed < SCRUB_MAX_SPEED) {
+        scrub_speed *= 2;
+    }
+
+    scrub_acc += scrub_speed * clip_fps;
+    scrub_cursor += scrub_dir * (int)(scrub_acc / DISPLAY_FPS);
+    scrub_acc %= DISPLAY_FPS;
+    if (scrub_cursor >= total_frames) scrub_cursor = total_frames - 1;
+    if (scrub_cursor < 0) scrub_cursor = 0;
+    current_frame_idx = scrub_cursor;  /* for the time display */
+
+    icon_type = scrub_dir < 0 ? ICON_SKIP_LEFT : ICON_SKIP_RIGHT;
+    icon_timer = ICON_FRAMES;
+
+    /* A search starts at the cursor once the last one is done; without
+       keyframe flags it reads SCRUB_KEY_READS chunks a tick while the
+       cursor moves on. Going forward nothing older than the frame shown
+       is worth reading */
+    if (scrub_key_pos < 0) {
+        int limit = SCRUB_KEY_SEARCH;
+        if (scrub_dir > 0 && scrub_shown >= 0 && scrub_cursor - scrub_shown < limit) limit = scrub_cursor - scrub_shown;
+        scrub_key_pos = scrub_cursor;
+        scrub_key_end = scrub_cursor - limit;
+    }
+    int key = keyframe_scan(&scrub_key_pos, scrub_key_end, SCRUB_KEY_READS);
+    if (key == -2) return;  /* out of reads: go on next tick */
+    scrub_key_pos = -1;
+    if (key >= 0 && key != scrub_shown && decode_single_frame(key)) scrub_shown = key;
+}
+
+/* Called every tick with the direction held (0 for none, or when scrubbing
+   is not allowed). A change of direction ends the scrub */
+static void scrub_update(int dir) {
+    if (dir != scrub_dir) {
+        if (scrub_active) scrub_finish();
+        scrub_dir = dir;
+        scrub_ticks = 0;
+        return;
+    }
+    if (!dir || total_frames <= 0) return;
+    if (++scrub_ticks >= SCRUB_HOLD_TICKS) scrub_step();
+}
+
 /* Audio: read raw PCM from disk into ring buffer */
 static int read_audio_disk_pcm(uint8_t *buf, int bytes_needed) {
     int bytes_read = 0;
     while (bytes_read < bytes_needed && audio_chunk_idx < total_audio_chunks) {
-        uint32_t chunk_size = audio_sizes[audio_chunk_idx];
+        uint32_t chunk_size = audio_size(audio_chunk_idx);
         uint32_t remaining = chunk_size - audio_chunk_pos;
         uint32_t to_read = bytes_needed - bytes_read;
         if (to_read > remaining) to_read = remaining;
 
-        uint32_t file_pos = audio_offsets[audio_chunk_idx] + audio_chunk_pos;
-        if (fseek(video_file, file_pos, SEEK_SET) != 0) break;
+        uint32_t file_pos = audio_offset(audio_chunk_idx) + audio_chunk_pos;
+        if (pf_seek(video_file, file_pos, SEEK_SET) != 0) break;
 
-        size_t got = fread(buf + bytes_read, 1, to_read, video_file);
+        size_t got = pf_read(video_file, buf + bytes_read, to_read);
         bytes_read += got;
         audio_chunk_pos += got;
 
@@ -2721,56 +4833,56 @@ static int read_audio_disk_pcm(uint8_t *buf, int bytes_needed) {
     return bytes_read;
 }
 
-/* ADPCM block read buffer */
-static uint8_t adpcm_read_buf[8192];  /* Large enough for any ADPCM block size */
+/* ADPCM read buffer - a whole chunk (or as many blocks as fit) per pf_read */
+static uint8_t adpcm_read_buf[8192];
+
+/* Read and decode ADPCM (MS or IMA), write up to ~max_bytes of PCM to ring buffer.
+ * Reads whole blocks of the current chunk in one pf_read and decodes them
+ * straight into the ring; only blocks that straddle the wrap go through
+ * adpcm_decode_buf. A block is only decoded when the ring has room for all
+ * of it, so nothing is ever dropped. */
+static int read_audio_disk_adpcm(int max_bytes) {
+    int ima = (audio_format == AUDIO_FMT_IMA);
+    int header = (ima ? 4 : 7) * audio_channels;
+    int align = adpcm_block_align;
+    if (align <= header || align > (int)sizeof(adpcm_read_buf) || audio_chunk_idx >= total_audio_chunks) return 0;
+
+    /* Decoded size of one full block, in bytes (MS headers carry 2 samples, IMA 1) */
+    int block_bytes = ((ima ? 1 : 2) * audio_channels + 2 * (align - header)) * 2;
+    int free_space = AUDIO_RING_SIZE - aring_count;
+    int total_decoded_bytes = 0;
+    int reads = 0;
 
-/* Read and decode ADPCM, write decoded PCM to ring buffer */
-static int read_audio_disk_adpcm(void) {
-    if (adpcm_block_align <= 0 || audio_chunk_idx >= total_audio_chunks) return 0;
+    trace(1, "ADPCM START: chunk=%d/%d pos=%u free=%d blk=%d\n",
+          audio_chunk_idx, total_audio_chunks, audio_chunk_pos, free_space, align);
 
-    int total_decoded_bytes = 0;
-    int free_space = AUDIO_RING_SIZE - aring_count;
-    int loop_count = 0;
-    int skip_count = 0;
-    static int adpcm_call_count = 0;
-    adpcm_call_count++;
-
-    xlog("ADPCM START: call=%d chunk=%d/%d pos=%u free=%d blk=%d\n",
-         adpcm_call_count, audio_chunk_idx, total_audio_chunks, audio_chunk_pos, free_space, adpcm_block_align);
-
-    while (free_space > 512 && audio_chunk_idx < total_audio_chunks && loop_count < 500) {
-        loop_count++;
-        /* Read one ADPCM block */
-        uint32_t chunk_size = audio_sizes[audio_chunk_idx];
+    while (audio_chunk_idx < total_audio_chunks && total_decoded_bytes < max_bytes) {
+        uint32_t chunk_size = audio_size(audio_chunk_idx);
         uint32_t remaining = chunk_size - audio_chunk_pos;
 
-        int block_size = adpcm_block_align;
-        if (block_size > (int)remaining) block_size = remaining;
-        if (block_size > (int)sizeof(adpcm_read_buf)) block_size = sizeof(adpcm_read_buf);
-        if (block_size < 7) {
-            /* Skip to next chunk */
-            skip_count++;
+        if (remaining < (uint32_t)header) {
+            /* Empty chunk or tail too short for a block header */
             audio_chunk_idx++;
             audio_chunk_pos = 0;
-            if (skip_count > 100) {
-                xlog("ADPCM SKIP LOOP: skips=%d chunk=%d\n", skip_count, audio_chunk_idx);
-                break;
-            }
             continue;
         }
 
-        uint32_t file_pos = audio_offsets[audio_chunk_idx] + audio_chunk_pos;
-        xlog("ADPCM LOOP %d: fseek pos=%u blk=%d\n", loop_count, file_pos, block_size);
+        /* Whole blocks that fit the ring, the budget and the read buffer */
+        int blocks = free_space / block_bytes;
+        int budget_blocks = (max_bytes - total_decoded_bytes + block_bytes - 1) / block_bytes;
+        if (blocks > budget_blocks) blocks = budget_blocks;
+        if (blocks > (int)sizeof(adpcm_read_buf) / align) blocks = sizeof(adpcm_read_buf) / align;
+        if (blocks <= 0) break;
 
-        if (fseek(video_file, file_pos, SEEK_SET) != 0) {
-            xlog("ADPCM: fseek FAILED\n");
-            break;
-        }
+        uint32_t span = (uint32_t)blocks * align;
+        if (span > remaining) span = remaining;
 
-        xlog("ADPCM LOOP %d: fread start\n", loop_count);
-        size_t got = fread(adpcm_read_buf, 1, block_size, video_file);
-        xlog("ADPCM LOOP %d: fread got=%zu\n", loop_count, got);
-        if (got < 7) break;
+        uint32_t file_pos = audio_offset(audio_chunk_idx) + audio_chunk_pos;
+        if (pf_seek(video_file, file_pos, SEEK_SET) != 0) break;
+        int got = pf_read(video_file, adpcm_read_buf, span);
+        reads++;
+        trace(2, "ADPCM READ: pos=%u span=%u got=%d\n", file_pos, span, got);
+        if (got < header) break;
 
         audio_chunk_pos += got;
         if (audio_chunk_pos >= chunk_size) {
@@ -2778,44 +4890,40 @@ static int read_audio_disk_adpcm(void) {
             audio_chunk_pos = 0;
         }
 
-        /* Decode block */
-        xlog("ADPCM LOOP %d: decode start ch=%d\n", loop_count, audio_channels);
-        int samples;
-        if (audio_channels == 1) {
-            samples = decode_adpcm_block_mono(adpcm_read_buf, got, adpcm_decode_buf, ADPCM_DECODE_BUF_SIZE);
-        } else {
-            samples = decode_adpcm_block_stereo(adpcm_read_buf, got, adpcm_decode_buf, ADPCM_DECODE_BUF_SIZE);
-        }
-        xlog("ADPCM LOOP %d: decode done samples=%d\n", loop_count, samples);
-
-        if (samples <= 0) continue;
-
-        /* Write decoded samples to ring buffer */
-        int decoded_bytes = samples * 2;  /* 16-bit samples */
-        if (decoded_bytes > free_space) decoded_bytes = free_space;
+        for (int off = 0; off + header <= got; off += align) {
+            int len = got - off;
+            if (len > align) len = align;
 
-        uint8_t *src = (uint8_t *)adpcm_decode_buf;
-        int written = 0;
-        while (written < decoded_bytes) {
             int before_wrap = AUDIO_RING_SIZE - aring_write;
-            int to_write = decoded_bytes - written;
-            if (to_write > before_wrap) to_write = before_wrap;
+            int16_t *dst = (before_wrap >= block_bytes) ? (int16_t *)(audio_ring + aring_write) : adpcm_decode_buf;
+            int samples;
+            if (ima) {
+                samples = (audio_channels == 1)
+                    ? decode_ima_block_mono(adpcm_read_buf + off, len, dst)
+                    : decode_ima_block_stereo(adpcm_read_buf + off, len, dst);
+            } else {
+                samples = (audio_channels == 1)
+                    ? decode_adpcm_block_mono(adpcm_read_buf + off, len, dst)
+                    : decode_adpcm_block_stereo(adpcm_read_buf + off, len, dst);
+            }
+            int decoded_bytes = samples * 2;  /* 16-bit samples */
 
-            memcpy(audio_ring + aring_write, src + written, to_write);
-            aring_write = (aring_write + to_write) % AUDIO_RING_SIZE;
-            written += to_write;
+            if (dst == adpcm_decode_buf) {
+                /* Block straddles the end of the ring - copy in two parts */
+                int first = (decoded_bytes < before_wrap) ? decoded_bytes : before_wrap;
+                memcpy(audio_ring + aring_write, adpcm_decode_buf, first);
+                memcpy(audio_ring, (uint8_t *)adpcm_decode_buf + first, decoded_bytes - first);
+            }
+            aring_write = (aring_write + decoded_bytes) % AUDIO_RING_SIZE;
+            aring_count += decoded_bytes;
+            free_space -= decoded_bytes;
+            total_decoded_bytes += decoded_bytes;
         }
 
-        aring_count += decoded_bytes;
-        free_space -= decoded_bytes;
-        total_decoded_bytes += decoded_bytes;
-
-        /* Limit per call to avoid blocking */
-        if (total_decoded_bytes > 4096) break;
+        if (got < (int)span) break;  /* short read - end of file */
     }
 
-    xlog("ADPCM END: loops=%d skips=%d decoded=%d chunk=%d\n",
-         loop_count, skip_count, total_decoded_bytes, audio_chunk_idx);
+    trace(1, "ADPCM END: reads=%d decoded=%d chunk=%d\n", reads, total_decoded_bytes, audio_chunk_idx);
     return total_decoded_bytes;
 }
 
@@ -2831,14 +4939,217 @@ static void mp3_init(void) {
     }
 }
 
-/* Reset MP3 decoder state (for seek) */
+/* Reset MP3 decoder state (for seek) - mutes history, no free/malloc */
 static void mp3_reset(void) {
     if (mp3_initialized && mp3_handle) {
-        mad_uninit(mp3_handle);
-        mp3_handle = mad_init();
+        mad_reset(mp3_handle);
     }
     mp3_input_len = 0;
     mp3_input_remaining = 0;
+    mp3_skip_samples = 0;
+}
+
+/* Forget the MP3 seek index (new file loaded) */
+static void mp3_index_clear(void) {
+    if (mp3_index_samples) free(mp3_index_samples);
+    if (mp3_index_first) free(mp3_index_first);
+    mp3_index_samples = NULL;
+    mp3_index_first = NULL;
+    mp3_index_cap = 0;
+    mp3_index_chunks = 0;
+    mp3_index_total = 0;
+    mp3_index_carry = 0;
+    mp3_index_spf = 0;
+    mp3_index_probed = 0;
+    mp3_index_one_per_chunk = 0;
+    mp3_index_failed = 0;
+}
+
+/* Parse a MPEG audio Layer III frame header.
+ * Returns frame length in bytes (0 = not a valid header), sets samples per frame */
+static int mp3_parse_header(const uint8_t *h, int *spf) {
+    static const uint16_t br_mpeg1[16] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+    static const uint16_t br_mpeg2[16] = { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 };
+    static const uint16_t sr_mpeg1[4] = { 44100, 48000, 32000, 0 };
+
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) return 0;
+
+    int version = (h[1] >> 3) & 3;  /* 3=MPEG-1, 2=MPEG-2, 0=MPEG-2.5, 1=reserved */
+    int layer = (h[1] >> 1) & 3;    /* 1=Layer III */
+    int br_idx = h[2] >> 4;
+    int sr_idx = (h[2] >> 2) & 3;
+    int padding = (h[2] >> 1) & 1;
+
+    /* Free format (br_idx 0) has no fixed length - not indexable */
+    if (version == 1 || layer != 1 || br_idx == 0 || br_idx == 15 || sr_idx == 3) return 0;
+
+    if (version == 3) {
+        *spf = 1152;
+        return 144000 * br_mpeg1[br_idx] / sr_mpeg1[sr_idx] + padding;
+    }
+    /* MPEG-2 halves, MPEG-2.5 quarters the MPEG-1 sample rates */
+    int sr = sr_mpeg1[sr_idx] >> ((version == 2) ? 1 : 2);
+    *spf = 576;
+    return 72000 * br_mpeg2[br_idx] / sr + padding;
+}
+
+/* Read bytes of the audio stream starting at chunk/pos, crossing chunk boundaries */
+static int mp3_read_stream_bytes(int chunk, uint32_t pos, uint8_t *buf, int len) {
+    int got = 0;
+    while (got < len && chunk < total_audio_chunks) {
+        if (pos >= audio_size(chunk)) {
+            pos -= audio_size(chunk);
+            chunk++;
+            continue;
+        }
+        int n = audio_size(chunk) - pos;
+        if (n > len - got) n = len - got;
+        if (pf_seek(video_file, audio_offset(chunk) + pos, SEEK_SET) != 0) break;
+        if (pf_read(video_file, buf + got, n) != (size_t)n) break;
+        got += n;
+        pos += n;
+    }
+    return got;
+}
+
+/* Extend the MP3 index so that chunks 0..upto are covered (header walk only) */
+static int mp3_index_extend(int upto) {
+    if (mp3_index_failed || total_audio_chunks <= 0) return 0;
+    if (upto >= total_audio_chunks) upto = total_audio_chunks - 1;
+
+    /* The AVI index may still be growing (progressive indexing) */
+    if (mp3_index_cap < total_audio_chunks) {
+        int cap = total_audio_chunks + total_audio_chunks / 2;
+        if (cap > MAX_AUDIO_CHUNKS) cap = MAX_AUDIO_CHUNKS;
+        uint32_t *samples = (uint32_t *)realloc(mp3_index_samples, (cap + 1) * sizeof(uint32_t));
+        if (samples) mp3_index_samples = samples;
+        uint16_t *first = (uint16_t *)realloc(mp3_index_first, cap * sizeof(uint16_t));
+        if (first) mp3_index_first = first;
+        if (!samples || !first) {
+            mp3_index_clear();
+            mp3_index_failed = 1;
+            return 0;
+        }
+        if (mp3_index_cap == 0) mp3_index_samples[0] = 0;
+        mp3_index_cap = cap;
+    }
+
+    while (mp3_index_chunks <= upto) {
+        int c = mp3_index_chunks;
+        uint32_t size = audio_size(c);
+        uint32_t pos = mp3_index_carry;
+
+        mp3_index_first[c] = MP3_INDEX_NO_FRAME;
+        while (pos < size) {
+            uint8_t hdr[4];
+            int spf = 0;
+            if (mp3_read_stream_bytes(c, pos, hdr, 4) != 4) {
+                pos = size;  /* truncated tail */
+                break;
+            }
+            int len = mp3_parse_header(hdr, &spf);
+            if (len <= 0) {
+                pos++;  /* lost sync - try next byte */
+                continue;
+            }
+            if (mp3_index_first[c] == MP3_INDEX_NO_FRAME && pos < MP3_INDEX_NO_FRAME) {
+                mp3_index_first[c] = pos;
+            }
+            if (mp3_index_spf == 0) mp3_index_spf = spf;
+            mp3_index_total += spf;
+            pos += len;
+        }
+        mp3_index_carry = pos - size;
+        mp3_index_samples[c + 1] = mp3_index_total;
+        mp3_index_chunks++;
+    }
+
+    if (mp3_index_spf == 0 && mp3_index_chunks >= total_audio_chunks && index_mode == INDEX_DONE) {
+        mp3_index_failed = 1;  /* not a single Layer III header in the stream */
+    }
+    return !mp3_index_failed;
+}
+
+/* Walk the first chunks once per file to pick the cheapest seek method */
+static void mp3_index_probe(void) {
+    int n = (total_audio_chunks < MP3_INDEX_PROBE_CHUNKS) ? total_audio_chunks : MP3_INDEX_PROBE_CHUNKS;
+
+    mp3_index_probed = 1;
+    if (n <= 0 || !mp3_index_extend(n - 1) || mp3_index_spf == 0) return;
+
+    for (int c = 0; c < n; c++) {
+        if (mp3_index_first[c] != 0) return;
+        if (mp3_index_samples[c + 1] - mp3_index_samples[c] != (uint32_t)mp3_index_spf) return;
+    }
+    if (mp3_index_carry != 0) return;
+
+    /* Classic ffmpeg layout - no table needed, free it */
+    int spf = mp3_index_spf;
+    mp3_index_clear();
+    mp3_index_probed = 1;
+    mp3_index_spf = spf;
+    mp3_index_one_per_chunk = 1;
+}
+
+/* Position the MP3 stream so the next sample sent to the ring is target.
+ * Decoding restarts one frame early (bit reservoir needs the previous frame),
+ * that frame and the head of the target frame are dropped via mp3_skip_samples.
+ * Returns the sample position actually reached. */
+static uint64_t mp3_seek_to_sample(uint64_t target, int effective_rate) {
+    int start_chunk = 0;
+    uint32_t start_pos = 0;
+    uint64_t start_sample = 0;
+
+    if (!mp3_index_probed) mp3_index_probe();
+
+    if (mp3_index_one_per_chunk) {
+        int k = target / mp3_index_spf;
+        if (k >= total_audio_chunks) k = total_audio_chunks - 1;
+        if (k < 0) k = 0;
+        start_chunk = (k > 0) ? k - 1 : 0;
+        start_sample = (uint64_t)start_chunk * mp3_index_spf;
+        if (target > (uint64_t)(k + 1) * mp3_index_spf) target = (uint64_t)k * mp3_index_spf;
+    } else if (!mp3_index_failed) {
+        while (mp3_index_chunks < total_audio_chunks && mp3_index_total <= target) {
+            if (!mp3_index_extend(mp3_index_chunks + MP3_INDEX_STEP)) break;
+        }
+    }
+
+    if (!mp3_index_one_per_chunk && !mp3_index_failed && mp3_index_chunks > 0) {
+        /* Last indexed chunk whose start is not past the target */
+        int lo = 0, hi = mp3_index_chunks - 1, k = 0;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            if (mp3_index_samples[mid] <= target) { k = mid; lo = mid + 1; }
+            else hi = mid - 1;
+        }
+        while (k > 0 && mp3_index_first[k] == MP3_INDEX_NO_FRAME) k--;
+
+        /* One more frame back to prime the reservoir */
+        int j = k;
+        if (k > 0) {
+            j = k - 1;
+            while (j > 0 && mp3_index_first[j] == MP3_INDEX_NO_FRAME) j--;
+        }
+        start_chunk = j;
+        start_pos = (mp3_index_first[j] == MP3_INDEX_NO_FRAME) ? 0 : mp3_index_first[j];
+        start_sample = mp3_index_samples[j];
+        if (target > mp3_index_total) target = mp3_index_total;
+    } else if (!mp3_index_one_per_chunk) {
+        /* No index - old estimate: each AVI chunk = one MP3 frame */
+        int spf = (effective_rate >= 32000) ? 1152 : 576;
+        start_chunk = target / spf;
+        if (start_chunk >= total_audio_chunks) start_chunk = total_audio_chunks - 1;
+        if (start_chunk < 0) start_chunk = 0;
+        start_sample = (uint64_t)start_chunk * spf;
+        target = start_sample;
+    }
+
+    if (target < start_sample) target = start_sample;
+    audio_chunk_idx = start_chunk;
+    audio_chunk_pos = start_pos;
+    mp3_skip_samples = (uint32_t)(target - start_sample);
+    return target;
 }
 
 /* Read raw MP3 data from AVI chunks into input buffer */
@@ -2858,7 +5169,7 @@ static int mp3_fill_input_buffer(void) {
     if (space <= 0) return mp3_input_len;
 
     while (space > 0 && audio_chunk_idx < total_audio_chunks) {
-        uint32_t chunk_size = audio_sizes[audio_chunk_idx];
+        uint32_t chunk_size = audio_size(audio_chunk_idx);
         uint32_t remaining = chunk_size - audio_chunk_pos;
 
         if (remaining == 0) {
@@ -2869,10 +5180,10 @@ static int mp3_fill_input_buffer(void) {
 
         int to_read = (space < (int)remaining) ? space : (int)remaining;
 
-        uint32_t file_pos = audio_offsets[audio_chunk_idx] + audio_chunk_pos;
-        if (fseek(video_file, file_pos, SEEK_SET) != 0) break;
+        uint32_t file_pos = audio_offset(audio_chunk_idx) + audio_chunk_pos;
+        if (pf_seek(video_file, file_pos, SEEK_SET) != 0) break;
 
-        size_t got = fread(mp3_input_buf + mp3_input_len, 1, to_read, video_file);
+        size_t got = pf_read(video_file, mp3_input_buf + mp3_input_len, to_read);
         if (got == 0) break;
 
         mp3_input_len += got;
@@ -2890,7 +5201,10 @@ static int mp3_fill_input_buffer(void) {
 }
 
 /* Read and decode MP3, write decoded PCM to ring buffer (froggyMP3 API) */
-static int read_audio_disk_mp3(void) {
+/* Largest PCM output of one MP3 frame in the ring (1152 stereo samples) */
+#define MP3_FRAME_OUT_MAX (1152 * 4)
+
+static int read_audio_disk_mp3(int max_bytes) {
     if (audio_chunk_idx >= total_audio_chunks && mp3_input_remaining <= 0) return 0;
 
     /* Initialize decoder if needed */
@@ -2901,7 +5215,8 @@ static int read_audio_disk_mp3(void) {
     int free_space = AUDIO_RING_SIZE - aring_count;
     int consecutive_errors = 0;
 
-    while (free_space > 512 && consecutive_errors < 100) {
+    /* Only decode when a whole frame fits - a partly written frame would be lost */
+    while (free_space >= MP3_FRAME_OUT_MAX && total_decoded_bytes < max_bytes && consecutive_errors < 100) {
         /* Refill input buffer if needed */
         if (mp3_input_remaining < 2048) {
             if (mp3_fill_input_buffer() <= 0) break;
@@ -2958,6 +5273,13 @@ static int read_audio_disk_mp3(void) {
             /* Recoverable error - skip at least 1 byte to avoid infinite loop */
             mp3_debug_errors++;
             consecutive_errors++;
+            /* A whole frame lost during seek pre-roll (usually the reservoir
+             * frame itself) - its samples will never arrive, don't skip them twice */
+            if (mp3_skip_samples > 0 && mp3_index_spf > 0 && mp3_input_len >= 2 &&
+                mp3_input_buf[0] == 0xFF && (mp3_input_buf[1] & 0xE0) == 0xE0) {
+                mp3_skip_samples = (mp3_skip_samples > (uint32_t)mp3_index_spf) ?
+                                   mp3_skip_samples - mp3_index_spf : 0;
+            }
             if (bytes_read == 0) bytes_read = 1;
             mp3_input_remaining = mp3_input_len - bytes_read;
             if (mp3_input_remaining > 0) {
@@ -2979,9 +5301,21 @@ static int read_audio_disk_mp3(void) {
          * Use detected MP3 channels (from first frame), fallback to AVI header
          */
         int actual_channels = (mp3_detected_channels > 0) ? mp3_detected_channels : audio_channels;
+
+        /* Drop seek pre-roll (reservoir frame + head of the target frame) */
+        int skip_bytes = 0;
+        if (mp3_skip_samples > 0) {
+            int bytes_per_frame_sample = (actual_channels == 1) ? 2 : 4;
+            int frame_samples = bytes_done / bytes_per_frame_sample;
+            int drop = (mp3_skip_samples < (uint32_t)frame_samples) ? (int)mp3_skip_samples : frame_samples;
+            mp3_skip_samples -= drop;
+            skip_bytes = drop * bytes_per_frame_sample;
+            if (skip_bytes >= bytes_done) continue;
+        }
+
         if (actual_channels == 1) {
             /* Mono input: duplicate each sample to stereo */
-            int mono_samples = bytes_done / 2;  /* 16-bit mono = 2 bytes/sample */
+            int mono_samples = (bytes_done - skip_bytes) / 2;  /* 16-bit mono = 2 bytes/sample */
             int stereo_bytes = mono_samples * 4;  /* stereo = 4 bytes/sample */
 
             mp3_debug_out_smp = mono_samples;
@@ -2991,7 +5325,7 @@ static int read_audio_disk_mp3(void) {
                 stereo_bytes = mono_samples * 4;
             }
 
-            int16_t *mono_src = (int16_t *)mp3_decode_buf;
+            int16_t *mono_src = (int16_t *)((uint8_t *)mp3_decode_buf + skip_bytes);
             for (int i = 0; i < mono_samples; i++) {
                 int16_t sample = mono_src[i];
                 /* Write L then R (same sample duplicated) */
@@ -3010,10 +5344,10 @@ static int read_audio_disk_mp3(void) {
             /* Stereo input: copy directly */
             mp3_debug_out_smp = bytes_done / 4;
 
-            int decoded_bytes = bytes_done;
+            int decoded_bytes = bytes_done - skip_bytes;
             if (decoded_bytes > free_space) decoded_bytes = free_space;
 
-            uint8_t *src = (uint8_t *)mp3_decode_buf;
+            uint8_t *src = (uint8_t *)mp3_decode_buf + skip_bytes;
             int written = 0;
             while (written < decoded_bytes) {
                 int before_wrap = AUDIO_RING_SIZE - aring_write;
@@ -3030,30 +5364,31 @@ static int read_audio_disk_mp3(void) {
             total_decoded_bytes += decoded_bytes;
             mp3_debug_bytes += decoded_bytes;
         }
-
-        /* Limit per call to avoid blocking */
-        if (total_decoded_bytes > 4096) break;
     }
 
     return total_decoded_bytes;
 }
 
-static void refill_audio_ring(void) {
-    if (!has_audio || audio_chunk_idx >= total_audio_chunks) return;
+/* Decode/read about max_bytes of audio into the ring. Returns bytes added */
+static int refill_audio_ring(int max_bytes) {
+    if (!has_audio) return 0;
+    if (audio_chunk_idx >= total_audio_chunks &&
+        !(audio_format == AUDIO_FMT_MP3 && mp3_input_remaining > 0)) return 0;
 
-    if (audio_format == AUDIO_FMT_ADPCM) {
-        /* ADPCM: read blocks, decode, write PCM to ring */
-        read_audio_disk_adpcm();
+    int added = 0;
+    if (audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_IMA) {
+        /* ADPCM (MS or IMA): read blocks, decode, write PCM to ring */
+        added = read_audio_disk_adpcm(max_bytes);
     } else if (audio_format == AUDIO_FMT_MP3) {
         /* MP3: read frames, decode with libmad, write PCM to ring */
-        read_audio_disk_mp3();
+        added = read_audio_disk_mp3(max_bytes);
     } else {
         /* PCM: read directly into ring */
         int free_space = AUDIO_RING_SIZE - aring_count;
-        while (free_space > 0 && audio_chunk_idx < total_audio_chunks) {
+        while (free_space > 0 && added < max_bytes && audio_chunk_idx < total_audio_chunks) {
             int before_wrap = AUDIO_RING_SIZE - aring_write;
             int to_read = (free_space < before_wrap) ? free_space : before_wrap;
-            if (to_read > 4096) to_read = 4096;
+            if (to_read > max_bytes - added) to_read = max_bytes - added;
 
             int got = read_audio_disk_pcm(audio_ring + aring_write, to_read);
             if (got <= 0) break;
@@ -3061,124 +5396,281 @@ static void refill_audio_ring(void) {
             aring_write = (aring_write + got) % AUDIO_RING_SIZE;
             aring_count += got;
             free_space -= got;
+            added += got;
+        }
+    }
+    return added;
+}
+
+/* Audio decode-ahead scheduler.
+ * Instead of refilling in one burst whenever the ring drops below half (which
+ * tends to coincide with a heavy video frame), audio is decoded in slices on
+ * every tick, using whatever time the video decode left over: repeat ticks and
+ * light frames get most of the work. Below the low-water mark the ring is
+ * topped up regardless of time, so slack accounting can never cause underrun.
+ * Time comes from the frontend perf interface; without it the compressed size
+ * of this tick's video frame stands in for its decode cost. */
+static int audio_decode_ahead(void) {
+    if (!has_audio || audio_bytes_per_sample == 0) return 0;
+
+    int rate = audio_sample_rate;
+    if (audio_format == AUDIO_FMT_MP3 && mp3_detected_samplerate > 0) {
+        rate = mp3_detected_samplerate;
+    }
+    int tick_bytes = rate * audio_bytes_per_sample / DISPLAY_FPS;
+    int low_water = tick_bytes * AUDIO_LOW_WATER_TICKS;
+    int slices = 0;
+
+    /* Must-do part: never let the ring run dry */
+    while (aring_count < low_water && aring_count < AUDIO_HIGH_WATER) {
+        if (refill_audio_ring(AUDIO_SLICE_BYTES) <= 0) return slices;
+        slices++;
+    }
+
+    if (perf_get_time_usec) {
+        /* Spend the rest of the tick, minus a reserve for blit/OSD/frontend */
+        retro_time_t deadline = sched_tick_start +
+                                (1000000 / DISPLAY_FPS) * (100 - AUDIO_TICK_RESERVE_PCT) / 100;
+        retro_time_t now = perf_get_time_usec();
+        while (aring_count < AUDIO_HIGH_WATER && now + sched_slice_us <= deadline) {
+            if (refill_audio_ring(AUDIO_SLICE_BYTES) <= 0) break;
+            retro_time_t after = perf_get_time_usec();
+            sched_slice_us += ((int)(after - now) - sched_slice_us) / 4;
+            now = after;
+            slices++;
+        }
+    } else {
+        /* No clock: repeat ticks are free, lighter-than-average frames are cheap */
+        int budget;
+        if (sched_video_bytes == 0) budget = 4;
+        else if (sched_video_bytes <= sched_video_avg_bytes) budget = 1;
+        else budget = 0;
+        while (budget-- > 0 && aring_count < AUDIO_HIGH_WATER) {
+            if (refill_audio_ring(AUDIO_SLICE_BYTES) <= 0) break;
+            slices++;
         }
     }
+
+    sched_slice_counter += slices;
+    return slices;
 }
 
-static int read_audio_ring(uint8_t *buf, int bytes_needed) {
+/* Copy bytes from the ring without consuming them */
+static int peek_audio_ring(uint8_t *buf, int bytes_needed) {
     int bytes_read = 0;
-    while (bytes_read < bytes_needed && aring_count > 0) {
-        int before_wrap = AUDIO_RING_SIZE - aring_read;
-        int avail = (aring_count < before_wrap) ? aring_count : before_wrap;
+    int pos = aring_read;
+    int left = aring_count;
+    while (bytes_read < bytes_needed && left > 0) {
+        int before_wrap = AUDIO_RING_SIZE - pos;
+        int avail = (left < before_wrap) ? left : before_wrap;
         int to_read = bytes_needed - bytes_read;
         if (to_read > avail) to_read = avail;
 
-        memcpy(buf + bytes_read, audio_ring + aring_read, to_read);
-        aring_read = (aring_read + to_read) % AUDIO_RING_SIZE;
-        aring_count -= to_read;
+        memcpy(buf + bytes_read, audio_ring + pos, to_read);
+        pos = (pos + to_read) % AUDIO_RING_SIZE;
+        left -= to_read;
         bytes_read += to_read;
     }
     return bytes_read;
 }
 
-static void play_audio_for_frame(void) {
-    if (!has_audio || !audio_batch_cb || audio_bytes_per_sample == 0) return;
+/* Drop bytes from the front of the ring */
+static void skip_audio_ring(int bytes) {
+    if (bytes > aring_count) bytes = aring_count;
+    aring_read = (aring_read + bytes) % AUDIO_RING_SIZE;
+    aring_count -= bytes;
+}
 
-    if (aring_count < AUDIO_REFILL_THRESHOLD) {
-        refill_audio_ring();
+/* Audio sample rate the ring actually holds (MP3: detected, AVI header may be wrong) */
+static int audio_effective_rate(void) {
+    if (audio_format == AUDIO_FMT_MP3 && mp3_detected_samplerate > 0) {
+        return mp3_detected_samplerate;
     }
+    return audio_sample_rate;
+}
 
-    /* Sync based on current_frame_idx (frames actually shown) */
-    /* For MP3: use detected sample rate (AVI header may be wrong) */
-    int effective_rate = audio_sample_rate;
-    if (audio_format == AUDIO_FMT_MP3 && mp3_detected_samplerate > 0) {
-        effective_rate = mp3_detected_samplerate;
+/* Source sample position of a video position, from the exact frame duration
+ * (us_per_frame) - integer clip_fps would turn 29.97 into 29 */
+static uint64_t frame_to_samples(int frame, int sub, int subs, int rate) {
+    uint64_t us = (uint64_t)frame * us_per_frame + (uint64_t)sub * us_per_frame / subs;
+    return us * rate / 1000000;
+}
+
+/* Forget interpolator history and restart sync at the current video position
+ * (seek, loop, new file) */
+static void audio_sync_reset(void) {
+    sync_last_frame = current_frame_idx;
+    sync_last_sub = repeat_counter;
+    rs_phase = 1 << 16;  /* first output lands exactly on the first new sample */
+    rs_prev[0] = 0;
+    rs_prev[1] = 0;
+    rs_ratio_ppm = 0;
+}
+
+/* Convert ring frames (any stored format) to interleaved stereo 16-bit */
+static void audio_frames_to_stereo(const uint8_t *raw, int frames, int16_t *dst) {
+    /* For ADPCM and MP3, data in ring buffer is already decoded to 16-bit PCM */
+    int effective_bits = (audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_IMA ||
+                          audio_format == AUDIO_FMT_MP3) ? 16 : audio_bits;
+    /* For MP3, ring buffer is always stereo (decoder duplicates mono) */
+    int effective_channels = (audio_format == AUDIO_FMT_MP3) ? 2 : audio_channels;
+
+    if (effective_bits == 16) {
+        const int16_t *src = (const int16_t *)raw;
+        if (effective_channels == 1) {
+            for (int i = 0; i < frames; i++) {
+                dst[i * 2] = src[i];
+                dst[i * 2 + 1] = src[i];
+            }
+        } else {
+            memcpy(dst, src, frames * 4);
+        }
+    } else {
+        /* 8-bit unsigned PCM */
+        for (int i = 0; i < frames; i++) {
+            int16_t l = ((int16_t)raw[i * effective_channels] - 128) << 8;
+            int16_t r = ((int16_t)raw[i * effective_channels + effective_channels - 1] - 128) << 8;
+            dst[i * 2] = l;
+            dst[i * 2 + 1] = r;
+        }
     }
-    /* Add ~0.1s audio lead to compensate for video-ahead-of-audio sync issue */
-    /* Offset = sample_rate / 10 (0.1 second worth of samples) */
-    int sync_offset = effective_rate / 10;
-    uint64_t expected = (uint64_t)current_frame_idx * effective_rate / clip_fps + sync_offset;
-    int64_t to_send = expected - audio_samples_sent;
+}
+
+/* A/V sync controller.
+ * Each tick outputs the samples the video advanced by (fractional fps from
+ * us_per_frame, so the frontend's audio pacing tracks the clip rate) and
+ * consumes source samples at ratio 1 +/- AUDIO_DRIFT_PPM through a linear
+ * interpolator, so lag from underruns or rounding is worked off inaudibly
+ * over about a second. Only gross errors (seek glitches, long stalls) fall
+ * back to dropping or padding. */
+static void play_audio_for_frame(void) {
+    if (!has_audio || !audio_batch_cb || audio_bytes_per_sample == 0) return;
+
+    audio_decode_ahead();
+
+    int rate = audio_effective_rate();
+    uint64_t expected = frame_to_samples(current_frame_idx, repeat_counter, repeat_count, rate);
+    uint64_t last = frame_to_samples(sync_last_frame, sync_last_sub, repeat_count, rate);
+    int64_t n = expected - last;  /* output samples this tick */
+    int64_t lag = (int64_t)expected - (int64_t)audio_samples_sent - n;  /* source behind video, after this tick */
+    sync_last_frame = current_frame_idx;
+    sync_last_sub = repeat_counter;
+    if (n <= 0) return;
+    if (n > MAX_AUDIO_BUFFER) n = MAX_AUDIO_BUFFER;
 
     /* Debug log every 30 frames for MP3 */
     static int sync_log_count = 0;
     if (audio_format == AUDIO_FMT_MP3 && (sync_log_count++ % 30 == 0)) {
-        xlog("SYNC MP3: frm=%d rate=%d exp=%llu sent=%llu to=%lld ring=%d\n",
-             current_frame_idx, effective_rate,
-             (unsigned long long)expected, (unsigned long long)audio_samples_sent,
-             (long long)to_send, aring_count);
+        trace(1, "SYNC MP3: frm=%d rate=%d exp=%llu sent=%llu lag=%lld ring=%d\n",
+              current_frame_idx, rate,
+              (unsigned long long)expected, (unsigned long long)audio_samples_sent,
+              (long long)lag, aring_count);
     }
 
-    if (to_send <= 0) return;
-    if (to_send > MAX_AUDIO_BUFFER) to_send = MAX_AUDIO_BUFFER;
-
-    int bytes_needed = to_send * audio_bytes_per_sample;
-    uint8_t temp[MAX_AUDIO_BUFFER * 4];
-    if (bytes_needed > (int)sizeof(temp)) {
-        bytes_needed = sizeof(temp);
-        to_send = bytes_needed / audio_bytes_per_sample;
+    int bpf = audio_bytes_per_sample;  /* ring bytes per source frame */
+    int available = aring_count / bpf;
+
+    /* Gross error: audio far behind - drop source; far ahead - hold with silence */
+    int64_t gross = rate / 4;
+    if (lag > gross) {
+        int64_t drop = lag;
+        if (drop > available) drop = available;
+        skip_audio_ring((int)drop * bpf);
+        audio_samples_sent += drop;
+        available -= drop;
+        lag -= drop;
+        audio_resyncs++;
+    } else if (lag < -gross) {
+        memset(audio_out_buffer, 0, n * 4);
+        audio_batch_cb(audio_out_buffer, n);
+        audio_resyncs++;
+        return;
     }
 
-    int got_bytes = read_audio_ring(temp, bytes_needed);
-    int got_samples = got_bytes / audio_bytes_per_sample;
-    if (got_samples <= 0) return;
+    /* Drift correction: consume faster when behind, slower when ahead */
+    int ppm = (int)(lag * 1000000 / rate);
+    if (ppm > AUDIO_DRIFT_PPM) ppm = AUDIO_DRIFT_PPM;
+    if (ppm < -AUDIO_DRIFT_PPM) ppm = -AUDIO_DRIFT_PPM;
+    rs_ratio_ppm = ppm;
+    uint32_t step = 65536 + (int32_t)((int64_t)ppm * 65536 / 1000000);  /* Q16 source step */
+
+    /* Source frames needed: everything the last output touches plus the next history frame */
+    int out = (int)n;
+    if (available < 1) {
+        audio_underruns++;
+        return;
+    }
+    int need = (int)((rs_phase + (uint64_t)(out - 1) * step) >> 16);
+    if (need >= available) {
+        /* Underrun: output only what the ring can interpolate - the last
+           output reads frame need + 1 */
+        audio_underruns++;
+        int64_t span = ((int64_t)available << 16) - 1 - rs_phase;
+        out = (span < 0) ? 0 : (int)(span / step) + 1;
+        if (out > n) out = n;
+        if (out <= 0) return;
+        need = (int)((rs_phase + (uint64_t)(out - 1) * step) >> 16);
+    }
+    int consumed = (int)((rs_phase + (uint64_t)out * step) >> 16);
+    if (consumed > available) consumed = available;
+    /* Every frame the loop reads (up to need + 1) and the next history
+       frame must come from this tick's peek, not a stale rs_src slot */
+    int peek = (need + 1 > consumed) ? need + 1 : consumed;
+
+    /* rs_src[0] = last frame of the previous tick, then new frames */
+    rs_src[0] = rs_prev[0];
+    rs_src[1] = rs_prev[1];
+    int got = peek_audio_ring(audio_raw_buf, peek * bpf) / bpf;
+    audio_frames_to_stereo(audio_raw_buf, got, rs_src + 2);
 
     /* Debug: capture first sample from ring buffer */
-    if (audio_format == AUDIO_FMT_MP3 && got_bytes >= 2) {
-        mp3_debug_ring_smp = ((int16_t *)temp)[0];
+    if (audio_format == AUDIO_FMT_MP3 && got > 0) {
+        mp3_debug_ring_smp = rs_src[2];
     }
 
-    int out = 0;
-    /* For ADPCM and MP3, data in ring buffer is already decoded to 16-bit PCM */
-    int effective_bits = (audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_MP3) ? 16 : audio_bits;
-    /* For MP3, ring buffer is always stereo (decoder duplicates mono) */
-    int effective_channels = (audio_format == AUDIO_FMT_MP3) ? 2 : audio_channels;
-
-    if (effective_channels == 1 && effective_bits == 16) {
-        int16_t *src = (int16_t *)temp;
-        for (int i = 0; i < got_samples && out < MAX_AUDIO_BUFFER; i++) {
-            audio_out_buffer[out * 2] = src[i];
-            audio_out_buffer[out * 2 + 1] = src[i];
-            out++;
-        }
-    } else if (effective_channels == 2 && effective_bits == 16) {
-        int16_t *src = (int16_t *)temp;
-        for (int i = 0; i < got_samples && out < MAX_AUDIO_BUFFER; i++) {
-            audio_out_buffer[out * 2] = src[i * 2];
-            audio_out_buffer[out * 2 + 1] = src[i * 2 + 1];
-            out++;
-        }
-    } else if (effective_bits == 8) {
-        for (int i = 0; i < got_samples && out < MAX_AUDIO_BUFFER; i++) {
-            int16_t s = ((int16_t)temp[i * effective_channels] - 128) << 8;
-            audio_out_buffer[out * 2] = s;
-            audio_out_buffer[out * 2 + 1] = s;
-            out++;
-        }
+    uint32_t pos = rs_phase;
+    for (int i = 0; i < out; i++) {
+        int j = pos >> 16;
+        int f = pos & 0xFFFF;
+        const int16_t *a = rs_src + j * 2;
+        /* Q15 weight keeps the product inside 32 bits */
+        audio_out_buffer[i * 2] = a[0] + (((a[2] - a[0]) * (f >> 1)) >> 15);
+        audio_out_buffer[i * 2 + 1] = a[1] + (((a[3] - a[1]) * (f >> 1)) >> 15);
+        pos += step;
     }
 
-    if (out > 0) {
-        audio_batch_cb(audio_out_buffer, out);
-        audio_samples_sent += out;
-        if (audio_format == AUDIO_FMT_MP3) {
-            mp3_debug_sent += out;
-            mp3_debug_ring = aring_count;
-            mp3_debug_sample = audio_out_buffer[0];  /* Capture first sample */
-        }
+    skip_audio_ring(consumed * bpf);
+    audio_samples_sent += consumed;
+    rs_prev[0] = rs_src[consumed * 2];
+    rs_prev[1] = rs_src[consumed * 2 + 1];
+    rs_phase = pos - ((uint32_t)consumed << 16);
+
+    /* Frontend accepted fewer frames than sent - its buffer is full */
+    size_t accepted = audio_batch_cb(audio_out_buffer, out);
+    if (accepted < (size_t)out) audio_overruns++;
+
+    if (audio_format == AUDIO_FMT_MP3) {
+        mp3_debug_sent += out;
+        mp3_debug_ring = aring_count;
+        mp3_debug_sample = audio_out_buffer[0];  /* Capture first sample */
     }
 }
 
 static int open_video(const char *path) {
     /* Close Xvid decoder from previous file if any */
     close_xvid();
+    tile_close();
 
     /* Reset MPEG-4 error message flag */
     mpeg4_error_shown = 0;
 
-    if (video_file) fclose(video_file);
-    video_file = fopen(path, "rb");
+    if (video_file) pf_close(video_file);
+    video_file = pf_open(path);
     if (!video_file) return 0;
-    if (!parse_avi()) { fclose(video_file); video_file = NULL; return 0; }
+    if (!parse_avi()) { pf_close(video_file); video_file = NULL; return 0; }
+    frame_buf_alloc();
+    if (index_mode != INDEX_DONE) index_file = pf_open(path);
+    thumb_reset(path);
 
     /* Reset all state */
     current_frame_idx = 0;
@@ -3190,8 +5682,9 @@ static int open_video(const char *path) {
     aring_write = 0;
     aring_count = 0;
 
-    /* Reset MP3 decoder state */
+    /* Reset MP3 decoder state and seek index */
     mp3_reset();
+    mp3_index_clear();
     /* Reset detected MP3 format for new file */
     mp3_detected_samplerate = 0;
     mp3_detected_channels = 0;
@@ -3200,9 +5693,25 @@ static int open_video(const char *path) {
     run_counter = 0;
     decode_counter = 0;
     sec_counter = 0;
+    audio_sync_reset();
+    audio_underruns = 0;
+    audio_overruns = 0;
+    audio_resyncs = 0;
+    deblock_active = 0;
+    deblock_calm_frames = 0;
+    deblock_last_underruns = 0;
+    xvid_degrade = 0;
+    degrade_late_frames = 0;
+    degrade_calm_frames = 0;
+    degrade_last_underruns = 0;
+    memset(xprof_ticks, 0, sizeof(xprof_ticks));
+    memset(xprof_pct, 0, sizeof(xprof_pct));
+    memset(xprof_vops, 0, sizeof(xprof_vops));
+    xprof_overall = 0;
+    xprof_valid = 0;
 
     /* Pre-fill audio buffer only */
-    refill_audio_ring();
+    refill_audio_ring(AUDIO_SLICE_BYTES);
 
     /* Don't decode first frame here for MPEG-4 - do lazy init in retro_run
        so we can see debug output. For MJPEG, decode first frame normally. */
@@ -3230,8 +5739,15 @@ void retro_init(void) {
     memset(framebuffer, 0, sizeof(framebuffer));
     init_color_tables();
     load_settings();  /* Load saved settings (color mode, show_time, etc.) */
+
+    /* Frontend clock for the audio scheduler - optional, size proxy otherwise */
+    struct retro_perf_callback perf;
+    memset(&perf, 0, sizeof(perf));
+    if (environ_cb && environ_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf) && perf.get_time_usec) {
+        perf_get_time_usec = perf.get_time_usec;
+    }
 }
-void retro_deinit(void) { close_xvid(); if (video_file) fclose(video_file); }
+void retro_deinit(void) { close_xvid(); tile_close(); thumb_xvid_close(); index_close(); if (video_file) pf_close(video_file); frame_buf_free(); }
 unsigned retro_api_version(void) { return RETRO_API_VERSION; }
 void retro_set_controller_port_device(unsigned p, unsigned d) { (void)p; (void)d; }
 
@@ -3244,7 +5760,7 @@ void retro_get_system_info(struct retro_system_info *info) {
 }
 
 void retro_get_system_av_info(struct retro_system_av_info *info) {
-    info->timing.fps = 30;
+    info->timing.fps = DISPLAY_FPS;
     /* Use actual sample rate from file, fallback to 22050 (we don't support 44kHz yet) */
     info->timing.sample_rate = (audio_sample_rate > 0) ? audio_sample_rate : 22050;
     info->geometry.base_width = SCREEN_WIDTH;
@@ -3279,9 +5795,102 @@ void retro_reset(void) {
     aring_count = 0;
     mp3_reset();
     repeat_counter = 0;
+    audio_sync_reset();
+}
+
+/* Decide whether the next Xvid frames get deblocked, from this frame's cost */
+static void deblock_update(void) {
+    if (video_codec_type != CODEC_TYPE_MPEG4) return;
+
+    if (perf_get_time_usec) {
+        int budget_us = (1000000 / DISPLAY_FPS) * repeat_count;  /* a frame owns repeat_count ticks */
+        if (sched_video_us * 100 > budget_us * DEBLOCK_TIGHT_PCT) {
+            deblock_active = 0;
+            deblock_calm_frames = 0;
+        } else if (sched_video_us * 100 <= budget_us * DEBLOCK_SLACK_PCT) {
+            if (++deblock_calm_frames >= DEBLOCK_ON_FRAMES) deblock_active = 1;
+        } else {
+            deblock_calm_frames = 0;
+        }
+    } else {
+        /* No clock: only content with idle repeat ticks can afford it,
+         * and an audio underrun means the budget is already tight */
+        if (repeat_count < 2 || audio_underruns != deblock_last_underruns) {
+            deblock_active = 0;
+            deblock_calm_frames = 0;
+        } else if (++deblock_calm_frames >= DEBLOCK_ON_FRAMES) {
+            deblock_active = 1;
+        }
+        deblock_last_underruns = audio_underruns;
+    }
+}
+
+/* Step Xvid down to FAST/DROP while frames decode late, back up when calm */
+static void degrade_update(void) {
+    int late, calm;
+
+    if (video_codec_type != CODEC_TYPE_MPEG4) return;
+
+    if (perf_get_time_usec) {
+        int budget_us = (1000000 / DISPLAY_FPS) * repeat_count;
+        late = sched_video_us * 100 > budget_us * DEGRADE_LATE_PCT;
+        calm = sched_video_us * 100 <= budget_us * DEGRADE_CALM_PCT;
+    } else {
+        /* No clock: an audio underrun is the only sign of running late */
+        late = audio_underruns != degrade_last_underruns;
+        calm = !late;
+        degrade_last_underruns = audio_underruns;
+    }
+
+    if (late) {
+        degrade_calm_frames = 0;
+        if (++degrade_late_frames >= DEGRADE_LATE_FRAMES && xvid_degrade < DEGRADE_DROP) {
+            xvid_degrade++;
+            degrade_late_frames = 0;
+            trace(1, "xvid degrade -> %d\n", xvid_degrade);
+        }
+    } else if (calm) {
+        degrade_late_frames = 0;
+        if (++degrade_calm_frames >= DEGRADE_CALM_FRAMES && xvid_degrade > 0) {
+            xvid_degrade--;
+            degrade_calm_frames = 0;
+            trace(1, "xvid degrade -> %d\n", xvid_degrade);
+        }
+    } else {
+        degrade_late_frames = 0;
+        degrade_calm_frames = 0;
+    }
+}
+
+/* Grow the index in what is left of the tick (one step without a clock) */
+static void index_background(void) {
+    if (index_mode == INDEX_DONE || !video_file) return;
+    if (index_mode == INDEX_TAIL) {
+        /* Short file: look for new chunks once a second */
+        if (++index_tail_wait < INDEX_TAIL_TICKS) return;
+        index_tail_wait = 0;
+    }
+
+    if (perf_get_time_usec) {
+        retro_time_t deadline = sched_tick_start +
+                                (1000000 / DISPLAY_FPS) * (100 - AUDIO_TICK_RESERVE_PCT) / 100;
+        do {
+            index_step(INDEX_STEP);
+        } while (index_mode != INDEX_DONE && index_mode != INDEX_TAIL && perf_get_time_usec() < deadline);
+    } else {
+        index_step(INDEX_STEP);
+    }
+
+    if (index_mode == INDEX_DONE) {
+        xlog("Index complete: %d frames, %d audio chunks, %d damaged spots skipped\n",
+             total_frames, total_audio_chunks, index_resyncs);
+        index_close();
+        frame_buf_fit();
+    }
 }
 
 void retro_run(void) {
+    if (perf_get_time_usec) sched_tick_start = perf_get_time_usec();
     input_poll_cb();
 
     /* Input handling */
@@ -3325,7 +5934,7 @@ void retro_run(void) {
                 color_submenu_active = 0;  /* close any submenus */
                 submenu_active = 0;
                 file_browser_active = 0;  /* close file browser */
-                decode_single_frame(current_frame_idx);  /* refresh frame */
+                if (!seek_commit()) decode_single_frame(current_frame_idx);  /* refresh frame */
                 is_paused = was_paused_before_menu;  /* restore pause state */
                 if (!is_paused) {
                     icon_type = ICON_PLAY;
@@ -3336,9 +5945,10 @@ void retro_run(void) {
                 menu_active = 1;
                 was_paused_before_menu = is_paused;  /* remember pause state */
                 is_paused = 1;  /* pause when menu opens */
+                seek_pending = 0;
                 /* Initialize slider to current position */
-                if (total_frames > 0) {
-                    seek_position = (current_frame_idx * 20) / total_frames;
+                if (slider_total() > 0) {
+                    seek_position = (int)((int64_t)current_frame_idx * 20 / slider_total());
                     if (seek_position > 20) seek_position = 20;
                 }
             }
@@ -3418,6 +6028,7 @@ void retro_run(void) {
                         fb_scan_directory();
                     } else {
                         /* At root or /mnt - close file browser */
+                        fb_cache_flush();
                         file_browser_active = 0;
                     }
                 }
@@ -3469,17 +6080,13 @@ void retro_run(void) {
                     if (cur_left && !prev_left) {
                         if (seek_position > 0) {
                             seek_position--;
-                            int target_frame = (total_frames > 0) ? (seek_position * total_frames / 20) : 0;
-                            seek_to_frame(target_frame);
-                            decode_single_frame(current_frame_idx);
+                            seek_slider_moved();
                         }
                     }
                     if (cur_right && !prev_right) {
                         if (seek_position < 20) {
                             seek_position++;
-                            int target_frame = (total_frames > 0) ? (seek_position * total_frames / 20) : 0;
-                            seek_to_frame(target_frame);
-                            decode_single_frame(current_frame_idx);
+                            seek_slider_moved();
                         }
                     }
                 }
@@ -3491,6 +6098,7 @@ void retro_run(void) {
                             fb_scan_directory();
                             break;
                         case 1:  /* Go to Position - close menu and resume */
+                            seek_commit();
                             is_paused = was_paused_before_menu;
                             menu_active = 0;
                             if (!is_paused) {
@@ -3562,7 +6170,7 @@ void retro_run(void) {
                 }
             }
 
-            /* Left: skip -15 seconds (on press) */
+            /* Left: skip -15 seconds (on press), scrub back while held */
             if (cur_left && !prev_left && !is_paused) {
                 int skip_frames = 15 * clip_fps;
                 seek_to_frame(current_frame_idx - skip_frames);
@@ -3570,7 +6178,7 @@ void retro_run(void) {
                 icon_timer = ICON_FRAMES;
             }
 
-            /* Right: skip +15 seconds (on press) */
+            /* Right: skip +15 seconds (on press), scrub forward while held */
             if (cur_right && !prev_right && !is_paused) {
                 int skip_frames = 15 * clip_fps;
                 seek_to_frame(current_frame_idx + skip_frames);
@@ -3596,6 +6204,8 @@ void retro_run(void) {
         }
     }
 
+    scrub_update((is_locked || menu_active || is_paused) ? 0 : cur_left ? -1 : cur_right ? 1 : 0);
+
     prev_a = cur_a;
     prev_b = cur_b;
     prev_left = cur_left;
@@ -3611,17 +6221,33 @@ void retro_run(void) {
     if (sec_counter >= 30) {
         runs_per_sec = run_counter;
         decodes_per_sec = decode_counter;
+        slices_per_sec = sched_slice_counter;
+        if (video_codec_type == CODEC_TYPE_MPEG4) xvid_profile_second();
         run_counter = 0;
         decode_counter = 0;
+        sched_slice_counter = 0;
         sec_counter = 0;
     }
 
-    if (is_playing && !is_paused) {
+    if (is_playing && !is_paused && !scrub_active) {
         /* Direct decode - no video buffer! */
+        sched_video_us = 0;
+        sched_video_bytes = 0;
+        index_until(current_frame_idx);  /* normally a no-op: the background is ahead */
         if (repeat_counter == 0) {
             /* New source frame needed - decode directly to framebuffer */
             if (current_frame_idx < total_frames) {
+                retro_time_t t0 = perf_get_time_usec ? perf_get_time_usec() : 0;
                 decode_single_frame(current_frame_idx);
+                /* Measure what the video decode took out of this tick */
+                if (perf_get_time_usec) {
+                    sched_video_us = (int)(perf_get_time_usec() - t0);
+                    sched_video_avg_us += (sched_video_us - sched_video_avg_us) / 8;
+                }
+                sched_video_bytes = frame_size(current_frame_idx);
+                sched_video_avg_bytes += (sched_video_bytes - sched_video_avg_bytes) / 8;
+                deblock_update();
+                degrade_update();
             }
         }
         /* else: same frame displayed again (repeat), framebuffer already has it */
@@ -3635,8 +6261,11 @@ void retro_run(void) {
         /* Play audio synced to frame position */
         play_audio_for_frame();
 
-        /* Loop when finished */
-        if (current_frame_idx >= total_frames) {
+        /* Loop when finished - unless the file may still grow: then wait
+           on the last picture for the index to find more */
+        if (current_frame_idx >= total_frames && index_mode == INDEX_TAIL) {
+            current_frame_idx = total_frames;
+        } else if (current_frame_idx >= total_frames) {
             current_frame_idx = 0;
             audio_chunk_idx = 0;
             audio_chunk_pos = 0;
@@ -3646,10 +6275,14 @@ void retro_run(void) {
             aring_count = 0;
             mp3_reset();
             repeat_counter = 0;
-            refill_audio_ring();
+            audio_sync_reset();
+            refill_audio_ring(AUDIO_SLICE_BYTES);
         }
     }
 
+    index_background();
+    thumb_background();
+
     /* Clear black bars for videos smaller than screen - BEFORE any UI drawing */
     if (offset_y > 0) {
         int scaled_h = video_height * scale_factor;
@@ -3663,11 +6296,11 @@ void retro_run(void) {
         }
     }
 
-    /* Time display in top left (when show_time enabled) */
-    if (show_time && !menu_active) {
+    /* Time display in top left (when show_time enabled, always while scrubbing) */
+    if ((show_time || scrub_active) && !menu_active) {
         /* Calculate current time from frame position */
-        int total_secs = (clip_fps > 0) ? (current_frame_idx / clip_fps) : 0;
-        int total_duration = (clip_fps > 0 && total_frames > 0) ? (total_frames / clip_fps) : 0;
+        int total_secs = (int)((uint64_t)current_frame_idx * us_per_frame / 1000000);
+        int total_duration = (total_frames > 0) ? (int)((uint64_t)total_frames * us_per_frame / 1000000) : 0;
         int cur_min = total_secs / 60;
         int cur_sec = total_secs % 60;
         int dur_min = total_duration / 60;
@@ -3682,11 +6315,20 @@ void retro_run(void) {
         draw_num(tx, 2, cur_sec, 0xFFFF);
         tx += num_width(cur_sec);
         draw_str(tx, 2, "/", 0x7BEF); tx += 6;
-        draw_num(tx, 2, dur_min, 0x7BEF);
-        tx += num_width(dur_min);
-        draw_str(tx, 2, ":", 0x7BEF); tx += 6;
-        if (dur_sec < 10) { draw_str(tx, 2, "0", 0x7BEF); tx += 6; }
-        draw_num(tx, 2, dur_sec, 0x7BEF);
+        if (index_mode != INDEX_DONE) {
+            draw_str(tx, 2, "indexing...", 0x7BEF);  /* duration not known yet */
+        } else {
+            draw_num(tx, 2, dur_min, 0x7BEF);
+            tx += num_width(dur_min);
+            draw_str(tx, 2, ":", 0x7BEF); tx += 6;
+            if (dur_sec < 10) { draw_str(tx, 2, "0", 0x7BEF); tx += 6; }
+            draw_num(tx, 2, dur_sec, 0x7BEF);
+        }
+        if (scrub_active) {
+            draw_str(140, 2, scrub_dir < 0 ? "<<" : ">>", 0xFFE0);
+            draw_num(158, 2, scrub_speed, 0xFFE0);
+            draw_str(158 + num_width(scrub_speed), 2, "x", 0xFFE0);
+        }
     }
 
     /* Key lock indicator - always show when locked */
@@ -3742,8 +6384,8 @@ void retro_run(void) {
             draw_str(80, 32, "Aud:", 0xFFFF);
             draw_num(106, 32, audio_sample_rate, 0xF81F);
             /* Show audio format: PCM or ADPCM with block align */
-            if (audio_format == AUDIO_FMT_ADPCM) {
-                draw_str(150, 32, "ADPCM", 0x07FF);  /* Cyan */
+            if (audio_format == AUDIO_FMT_ADPCM || audio_format == AUDIO_FMT_IMA) {
+                draw_str(150, 32, audio_format == AUDIO_FMT_IMA ? "IMA" : "ADPCM", 0x07FF);  /* Cyan */
                 draw_str(190, 32, "B:", 0xFFFF);
                 draw_num(206, 32, adpcm_block_align, 0x07FF);
             } else if (audio_format == AUDIO_FMT_PCM) {
@@ -3760,6 +6402,18 @@ void retro_run(void) {
             draw_str(2, 32, "Audio: none", 0x7BEF);
         }
 
+        /* A/V sync: underruns, frontend overruns, hard resyncs, drift correction */
+        if (has_audio) {
+            draw_str(2, 52, "Und:", 0xFFFF);
+            draw_num(28, 52, audio_underruns, audio_underruns > 0 ? 0xF800 : 0x07E0);
+            draw_str(70, 52, "Ovr:", 0xFFFF);
+            draw_num(96, 52, audio_overruns, audio_overruns > 0 ? 0xF800 : 0x07E0);
+            draw_str(138, 52, "Rsy:", 0xFFFF);
+            draw_num(164, 52, audio_resyncs, audio_resyncs > 0 ? 0xFFE0 : 0x07E0);
+            draw_str(200, 52, "ppm:", 0xFFFF);
+            draw_num(226, 52, rs_ratio_ppm, 0x07FF);
+        }
+
         /* Video codec info - moved to line 42 to make room for audio format */
         draw_str(2, 42, "Codec:", 0xFFFF);
         if (video_fourcc[0]) {
@@ -3768,6 +6422,43 @@ void retro_run(void) {
             draw_str(44, 42, "???", 0xF800);
         }
 
+        /* Scheduler: average video decode time (if clock) and audio slices per second */
+        if (perf_get_time_usec) {
+            draw_str(80, 42, "Vus:", 0xFFFF);
+            draw_num(106, 42, sched_video_avg_us, sched_video_avg_us < 1000000 / DISPLAY_FPS ? 0x07E0 : 0xF800);
+        }
+        if (has_audio) {
+            draw_str(160, 42, "ASl/s:", 0xFFFF);
+            draw_num(200, 42, slices_per_sec, 0x07FF);
+        }
+        if (deblock_active) {
+            draw_str(296, 42, "DB", 0x07E0);  /* Xvid deblocking on */
+        }
+        if (xvid_fast_mc && video_codec_type == CODEC_TYPE_MPEG4) {
+            draw_str(248, 42, "MC", 0xFFE0);  /* approximate motion compensation */
+        }
+        if (xvid_degrade) {
+            /* Xvid running degraded: FA = fast, DR = B-frames dropped */
+            draw_str(272, 42, xvid_degrade >= DEGRADE_DROP ? "DR" : "FA", 0xF800);
+        }
+
+        /* Xvid: where decode time went (% per stage, only when the
+           decoder is built with profiling) and VOPs per type */
+        if (video_codec_type == CODEC_TYPE_MPEG4) {
+            static const char *xprof_names[XPROF_STAGES] = { "VLC:", "Prd:", "IQ:", "IDC:", "Xfr:", "MC:", "Edg:", "Out:" };
+            static const char *vop_names[5] = { "I:", "P:", "B:", "S:", "N:" };
+            int i;
+            for (i = 0; xprof_valid && i < XPROF_STAGES; i++) {
+                int x = 2 + (i % 4) * 64, y = 62 + (i / 4) * 10;
+                draw_str(x, y, xprof_names[i], 0xFFFF);
+                draw_num(x + 28, y, xprof_pct[i], xprof_pct[i] >= 30 ? 0xF800 : 0x07FF);
+            }
+            for (i = 0; i < 5; i++) {
+                draw_str(2 + i * 64, 82, vop_names[i], 0xFFFF);
+                draw_num(16 + i * 64, 82, xprof_vops[i], 0xFFE0);
+            }
+        }
+
         /* MP3 debug - big display in center of screen */
         if (audio_format == AUDIO_FMT_MP3) {
             int dx = 30, dy = 40;
@@ -3842,6 +6533,7 @@ void retro_run(void) {
         draw_menu();
         /* Draw file browser on top of menu when active */
         if (file_browser_active) {
+            fb_meta_step();
             draw_file_browser();
         }
         /* Draw save feedback popup */
@@ -3906,8 +6598,12 @@ bool retro_load_game(const struct retro_game_info *info) {
 
 void retro_unload_game(void) {
     close_xvid();  /* Close Xvid decoder if open */
-    if (video_file) fclose(video_file);
+    tile_close();
+    thumb_xvid_close();
+    index_close();
+    if (video_file) pf_close(video_file);
     video_file = NULL;
+    frame_buf_free();
     is_playing = 0;
 }
 unsigned retro_get_region(void) { return RETRO_REGION_NTSC; }
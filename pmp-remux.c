@@ -0,0 +1,833 @@
+/*
+ * pmp-remux - rewrites an AVI in the layout A ZERO Player reads best
+ *
+ * Host tool, built with "make remux". It includes the player itself, so
+ * the input is read by the same parse_avi and index code the console
+ * runs, and the output is checked by opening it the same way: the index
+ * the player builds must find every chunk where it was written.
+ *
+ * The output is a plain AVI 1.0 file (any player opens it):
+ * - every chunk's data starts on a sector boundary (JUNK in between)
+ * - audio comes in large blocks of fixed duration, each just ahead of
+ *   the video it plays with
+ * - idx1 with keyframe flags from the VOP headers
+ * - dwSuggestedBufferSize in avih and strh holds the largest chunk, so
+ *   the frame buffer is sized right before the index is read
+ * - the seek previews (<name>.avi.thm) are built next to it
+ *
+ * With -t the video is re-encoded as PMPT, the player's RGB565 tile codec:
+ * each frame is decoded by the player's own MJPEG or Xvid code, exactly as
+ * the console would show it, and written as 8x8 tiles that are skipped,
+ * filled, palettised or raw, whichever is cheapest within the -q error.
+ * Files get larger but decoding is little more than copying.
+ *
+ * Usage: pmp-remux [-a align] [-b audio_ms] [-n] [-t [-q error]] in.avi out.avi
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "libretro-pmp.c"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define REMUX_ALIGN 512            /* SD sector */
+#define REMUX_AUDIO_MS 1000
+#define REMUX_AUDIO_MAX 60000      /* the MP3 index keeps chunk offsets in 16 bits */
+#define REMUX_HDRL_MAX (1 << 20)
+#define REMUX_TILE_ERROR 12        /* -q default */
+
+#define AVIF_HASINDEX 0x10
+#define AVIF_ISINTERLEAVED 0x100
+
+static int verbose = 0;
+
+/* ========== Firmware calls over POSIX ========== */
+
+void xlog(const char *fmt, ...) {
+    va_list ap;
+    if (!verbose) return;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+int fs_open(const char *path, int oflag, int perms) {
+    int flags = O_BINARY;
+    if (oflag & FS_O_WRONLY) flags |= O_WRONLY;
+    else if (oflag & FS_O_RDWR) flags |= O_RDWR;
+    else flags |= O_RDONLY;
+    if (oflag & FS_O_CREAT) flags |= O_CREAT;
+    if (oflag & FS_O_TRUNC) flags |= O_TRUNC;
+    return open(path, flags, perms);
+}
+
+int fs_close(int fd) { return close(fd); }
+int64_t fs_lseek(int fd, int64_t offset, int whence) { return lseek(fd, (off_t)offset, whence); }
+ssize_t fs_read(int fd, void *buf, size_t nbyte) { return read(fd, buf, nbyte); }
+ssize_t fs_write(int fd, const void *buf, size_t nbyte) { return write(fd, buf, nbyte); }
+
+/* The browser is never opened here */
+int fs_mkdir(const char *path, int mode) { return -1; }
+int fs_opendir(const char *path) { return -1; }
+int fs_closedir(int fd) { return -1; }
+ssize_t fs_readdir(int fd, void *buffer) { return -1; }
+
+/* ========== Output ========== */
+
+typedef struct {
+    uint8_t tag[4];
+    uint32_t flags;
+    uint32_t offset;  /* chunk header, from the 'movi' fourcc */
+    uint32_t size;
+} remux_entry_t;
+
+static FILE *out;
+static uint64_t out_pos;
+static uint64_t out_movi;          /* position of the 'movi' fourcc */
+static uint32_t out_align = REMUX_ALIGN;
+static uint64_t out_junk;          /* bytes spent on alignment */
+static remux_entry_t *entries;
+static int entry_count;
+static uint8_t *chunk_buf;
+static uint32_t chunk_buf_size;
+
+static void put_u32_le(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static int out_write(const void *data, uint32_t size) {
+    if (size && fwrite(data, 1, size, out) != size) return 0;
+    out_pos += size;
+    return 1;
+}
+
+static int out_header(const char *tag, uint32_t size) {
+    uint8_t h[8];
+    memcpy(h, tag, 4);
+    put_u32_le(h + 4, size);
+    return out_write(h, 8);
+}
+
+static int out_patch(uint64_t pos, const void *data, uint32_t size) {
+    if (fseeko(out, (off_t)pos, SEEK_SET) != 0) return 0;
+    return fwrite(data, 1, size, out) == size && fseeko(out, 0, SEEK_END) == 0;
+}
+
+static int out_patch_u32(uint64_t pos, uint32_t v) {
+    uint8_t b[4];
+    put_u32_le(b, v);
+    return out_patch(pos, b, 4);
+}
+
+/* JUNK so that the next chunk's data (after its 8 byte header) starts
+   on an out_align boundary */
+static int out_pad(void) {
+    static const uint8_t zero[4096];
+    uint32_t need;
+
+    if (out_align <= 1) return 1;
+    need = (uint32_t)((out_align - (out_pos + 8) % out_align) % out_align);
+    if (need == 0) return 1;
+    while (need < 8) need += out_align;
+    out_junk += need;
+    if (!out_header("JUNK", need - 8)) return 0;
+    for (need -= 8; need > 0; ) {
+        uint32_t n = need < sizeof(zero) ? need : sizeof(zero);
+        if (!out_write(zero, n)) return 0;
+        need -= n;
+    }
+    return 1;
+}
+
+/* One movi chunk plus its idx1 entry */
+static int out_chunk(uint64_t movi_fourcc, const uint8_t *tag, const uint8_t *data, uint32_t size, uint32_t flags) {
+    static const uint8_t pad = 0;
+    remux_entry_t *e = &entries[entry_count++];
+
+    if (!out_pad()) return 0;
+    memcpy(e->tag, tag, 4);
+    e->flags = flags;
+    e->offset = (uint32_t)(out_pos - movi_fourcc);
+    e->size = size;
+    if (!out_header((const char *)tag, size) || !out_write(data, size)) return 0;
+    if (size & 1) return out_write(&pad, 1);
+    return 1;
+}
+
+/* ========== PMPT encoder ========== */
+
+static int tile_mode = 0;
+static int tile_error = REMUX_TILE_ERROR;  /* largest channel error, 8 bit units */
+static int enc_w, enc_h;
+static uint16_t *enc_cur;   /* the player's picture of the frame */
+static uint16_t *enc_ref;   /* what the decoder has shown so far */
+static uint8_t *enc_buf;
+
+static void px_rgb(uint16_t p, int *c) {
+    c[0] = ((p >> 11) << 3) | (p >> 13);
+    c[1] = (((p >> 5) & 63) << 2) | ((p >> 9) & 3);
+    c[2] = ((p & 31) << 3) | ((p >> 2) & 7);
+}
+
+static uint16_t rgb_px(const int *c) {
+    return (uint16_t)(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+}
+
+/* Largest channel difference */
+static int px_error(uint16_t a, uint16_t b) {
+    int ca[3], cb[3], e = 0;
+    px_rgb(a, ca);
+    px_rgb(b, cb);
+    for (int i = 0; i < 3; i++) {
+        int d = abs(ca[i] - cb[i]);
+        if (d > e) e = d;
+    }
+    return e;
+}
+
+static int px_distance(uint16_t a, uint16_t b) {
+    int ca[3], cb[3], d = 0;
+    px_rgb(a, ca);
+    px_rgb(b, cb);
+    for (int i = 0; i < 3; i++) d += (ca[i] - cb[i]) * (ca[i] - cb[i]);
+    return d;
+}
+
+static int pal_nearest(uint16_t p, const uint16_t *pal, int n) {
+    int best = 0, best_d = px_distance(p, pal[0]);
+    for (int i = 1; i < n && best_d; i++) {
+        int d = px_distance(p, pal[i]);
+        if (d < best_d) {
+            best = i;
+            best_d = d;
+        }
+    }
+    return best;
+}
+
+/* Up to k colours for the 64 pixels of a tile: exact if there are no
+   more, else median cut refined by two k-means passes. Returns how many */
+static int tile_palette(const uint16_t *px, int k, uint16_t *pal) {
+    uint8_t ix[64];
+    int start[16], len[16], boxes = 1, n = 0, c[3], sum[16][4];
+
+    for (int i = 0; i < 64 && n <= k; i++) {
+        int j = 0;
+        while (j < n && pal[j] != px[i]) j++;
+        if (j == n && n++ < k) pal[j] = px[i];
+    }
+    if (n <= k) return n;
+
+    for (int i = 0; i < 64; i++) ix[i] = (uint8_t)i;
+    start[0] = 0;
+    len[0] = 64;
+    while (boxes < k) {
+        int b = -1, ch = 0, range = 0;
+        for (int i = 0; i < boxes; i++) {
+            int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+            for (int j = start[i]; j < start[i] + len[i]; j++) {
+                px_rgb(px[ix[j]], c);
+                for (int q = 0; q < 3; q++) {
+                    if (c[q] < lo[q]) lo[q] = c[q];
+                    if (c[q] > hi[q]) hi[q] = c[q];
+                }
+            }
+            for (int q = 0; q < 3; q++) {
+                if (hi[q] - lo[q] > range) {
+                    b = i;
+                    ch = q;
+                    range = hi[q] - lo[q];
+                }
+            }
+        }
+        if (b < 0) break;
+        for (int j = start[b] + 1; j < start[b] + len[b]; j++) {
+            uint8_t v = ix[j];
+            int cv, m = j;
+            px_rgb(px[v], c);
+            cv = c[ch];
+            for (; m > start[b]; m--) {
+                px_rgb(px[ix[m - 1]], c);
+                if (c[ch] <= cv) break;
+                ix[m] = ix[m - 1];
+            }
+            ix[m] = v;
+        }
+        start[boxes] = start[b] + len[b] / 2;
+        len[boxes] = len[b] - len[b] / 2;
+        len[b] /= 2;
+        boxes++;
+    }
+
+    for (int pass = 0; pass < 3; pass++) {
+        memset(sum, 0, sizeof(sum));
+        if (pass == 0) {
+            for (int i = 0; i < boxes; i++) {
+                for (int j = start[i]; j < start[i] + len[i]; j++) {
+                    px_rgb(px[ix[j]], c);
+                    for (int q = 0; q < 3; q++) sum[i][q] += c[q];
+                    sum[i][3]++;
+                }
+            }
+        } else {
+            for (int i = 0; i < 64; i++) {
+                int b = pal_nearest(px[i], pal, boxes);
+                px_rgb(px[i], c);
+                for (int q = 0; q < 3; q++) sum[b][q] += c[q];
+                sum[b][3]++;
+            }
+        }
+        for (int i = 0; i < boxes; i++) {
+            if (!sum[i][3]) continue;
+            for (int q = 0; q < 3; q++) c[q] = (sum[i][q] + sum[i][3] / 2) / sum[i][3];
+            pal[i] = rgb_px(c);
+        }
+    }
+    return boxes;
+}
+
+/* Every pixel of the tiles within tile_error */
+static int tile_close_to(const uint16_t *a, const uint16_t *b, int stride) {
+    for (int y = 0; y < 8; y++, a += stride, b += stride) {
+        for (int x = 0; x < 8; x++) {
+            if (px_error(a[x], b[x]) > tile_error) return 0;
+        }
+    }
+    return 1;
+}
+
+/* The cheapest type that keeps the tile within tile_error, its data in
+   data (the colour for TILE_FILL) */
+static int tile_encode(const uint16_t *src, int stride, uint8_t *data) {
+    static const int colours[3] = { 2, 4, 16 }, bits[3] = { 1, 2, 4 };
+    uint16_t px[64], pal[16];
+    int c[3], sum[3] = { 0, 0, 0 }, ok = 1;
+
+    for (int y = 0; y < 8; y++) memcpy(px + y * 8, src + y * stride, 16);
+
+    for (int i = 0; i < 64; i++) {
+        px_rgb(px[i], c);
+        for (int q = 0; q < 3; q++) sum[q] += c[q];
+    }
+    for (int q = 0; q < 3; q++) c[q] = (sum[q] + 32) / 64;
+    pal[0] = rgb_px(c);
+    for (int i = 0; i < 64 && ok; i++) ok = px_error(px[i], pal[0]) <= tile_error;
+    if (!ok) {
+        /* the mean can miss a flat tile by rounding */
+        pal[0] = px[0];
+        ok = 1;
+        for (int i = 0; i < 64 && ok; i++) ok = px_error(px[i], pal[0]) <= tile_error;
+    }
+    if (ok) {
+        data[0] = (uint8_t)pal[0];
+        data[1] = (uint8_t)(pal[0] >> 8);
+        return TILE_FILL;
+    }
+
+    for (int s = 0; s < 3; s++) {
+        int k = colours[s], n = tile_palette(px, k, pal), per = 8 / bits[s];
+        uint8_t *ix = data + k * 2;
+
+        for (int i = n; i < k; i++) pal[i] = pal[0];
+        memset(ix, 0, 64 / per);
+        ok = 1;
+        for (int i = 0; i < 64 && ok; i++) {
+            int p = pal_nearest(px[i], pal, n);
+            ok = px_error(px[i], pal[p]) <= tile_error;
+            ix[i / per] |= p << ((per - 1 - i % per) * bits[s]);
+        }
+        if (ok) {
+            for (int i = 0; i < k; i++) {
+                data[i * 2] = (uint8_t)pal[i];
+                data[i * 2 + 1] = (uint8_t)(pal[i] >> 8);
+            }
+            return TILE_PAL2 + s;
+        }
+    }
+
+    for (int i = 0; i < 64; i++) {
+        data[i * 2] = (uint8_t)px[i];
+        data[i * 2 + 1] = (uint8_t)(px[i] >> 8);
+    }
+    return TILE_RAW;
+}
+
+/* enc_cur against enc_ref into enc_buf, tiles of one type (and colour,
+   for fills) in runs. Returns the size */
+static uint32_t tile_encode_frame(int key) {
+    int cols = enc_w >> 3, total = cols * (enc_h >> 3), run_type = -1, run_n = 0;
+    uint8_t *p = enc_buf, *op = NULL, data[128], fill[2] = { 0, 0 };
+
+    *p++ = key ? TILE_FRAME_KEY : 0;
+    for (int t = 0; t < total; t++) {
+        int at = (t / cols) * 8 * enc_w + (t % cols) * 8, type;
+
+        if (!key && tile_close_to(enc_cur + at, enc_ref + at, enc_w)) type = TILE_SKIP;
+        else type = tile_encode(enc_cur + at, enc_w, data);
+
+        if (type != run_type || run_n == TILE_RUN_MAX ||
+            (type == TILE_FILL && memcmp(data, fill, 2) != 0)) {
+            op = p++;
+            run_type = type;
+            run_n = 0;
+            if (type == TILE_FILL) {
+                memcpy(fill, data, 2);
+                *p++ = fill[0];
+                *p++ = fill[1];
+            }
+        }
+        *op = (uint8_t)((type << 5) | run_n++);
+        if (type >= TILE_PAL2) {
+            memcpy(p, data, tile_data_size[type]);
+            p += tile_data_size[type];
+        }
+    }
+    return (uint32_t)(p - enc_buf);
+}
+
+/* Decoders up, frame 0 shown to learn the size. The picture is cropped to
+   what the player shows, in multiples of 8 */
+static int tile_setup(void) {
+    frame_buf_alloc();
+    init_yuv_tables();
+    color_mode = COLOR_MODE_UNCHANGED;
+    if (video_codec_type == CODEC_TYPE_MPEG4 && !init_xvid_mpeg4()) return 0;
+    if (!decode_single_frame(0)) {
+        fprintf(stderr, "frame 0 does not decode\n");
+        return 0;
+    }
+
+    enc_w = (SCREEN_WIDTH - offset_x) / scale_factor;
+    enc_h = (SCREEN_HEIGHT - offset_y) / scale_factor;
+    if (enc_w > video_width) enc_w = video_width;
+    if (enc_h > video_height) enc_h = video_height;
+    enc_w &= ~7;
+    enc_h &= ~7;
+    if (enc_w < 8 || enc_h < 8) {
+        fprintf(stderr, "%dx%d is too small for PMPT\n", video_width, video_height);
+        return 0;
+    }
+    enc_cur = (uint16_t *)malloc(enc_w * enc_h * sizeof(uint16_t));
+    enc_ref = (uint16_t *)calloc(enc_w * enc_h, sizeof(uint16_t));
+    enc_buf = (uint8_t *)malloc(enc_w * enc_h * 2 + (enc_w >> 3) * (enc_h >> 3) + 16);
+    if (!enc_cur || !enc_ref || !enc_buf) return 0;
+    if (enc_w != video_width || enc_h != video_height)
+        printf("PMPT: %dx%d cropped to %dx%d\n", video_width, video_height, enc_w, enc_h);
+    return 1;
+}
+
+/* Frame f re-encoded into enc_buf. Returns the size */
+static uint32_t tile_frame(int f, int key) {
+    uint32_t size;
+
+    decode_single_frame(f);  /* a broken frame repeats the last picture, as on the console */
+    for (int y = 0; y < enc_h; y++) {
+        int sy = offset_y + y * scale_factor;
+        for (int x = 0; x < enc_w; x++) {
+            int sx = offset_x + x * scale_factor;
+            /* a frame of another size moves the picture: black outside */
+            enc_cur[y * enc_w + x] = sx < SCREEN_WIDTH && sy < SCREEN_HEIGHT ? framebuffer[sy * SCREEN_WIDTH + sx] : 0;
+        }
+    }
+    size = tile_encode_frame(key);
+    tile_decode(enc_buf, size, enc_ref, enc_w, enc_h);  /* no drift against the player */
+    return size;
+}
+
+static void tile_done(void) {
+    close_xvid();
+    frame_buf_free();
+    free(enc_cur);
+    free(enc_ref);
+    free(enc_buf);
+    enc_cur = enc_ref = NULL;
+    enc_buf = NULL;
+}
+
+/* ========== Input ========== */
+
+/* Chunk header and data at offset (index points at the data) into
+   chunk_buf. Returns the header, NULL on a read error */
+static const uint8_t *read_chunk(uint32_t offset, uint32_t size) {
+    if (size + 8 > chunk_buf_size) {
+        uint8_t *p = (uint8_t *)realloc(chunk_buf, size + 8);
+        if (!p) return NULL;
+        chunk_buf = p;
+        chunk_buf_size = size + 8;
+    }
+    if (offset < 8 || pf_seek(video_file, offset - 8, SEEK_SET) != 0) return NULL;
+    if (pf_read(video_file, chunk_buf, size + 8) != size + 8) return NULL;
+    return chunk_buf;
+}
+
+/* Stream tag of a chunk (##dc or ##wb like def), def when the index
+   pointed at data without a header */
+static void chunk_tag(uint8_t *tag, const uint8_t *hdr, const char *def) {
+    if (hdr[0] >= '0' && hdr[0] <= '9' && hdr[1] >= '0' && hdr[1] <= '9' &&
+        (hdr[2] | 0x20) == def[2] && (hdr[3] | 0x20) == def[3]) memcpy(tag, hdr, 4);
+    else memcpy(tag, def, 4);
+}
+
+/* MJPEG frames all stand alone, MPEG-4 ones if their first VOP is an
+   I-VOP. Without a VOP header the input's flag stays */
+static uint32_t video_flags(int idx, const uint8_t *data, uint32_t size) {
+    if (size <= 1) return 0;  /* dropped frame placeholder */
+    if (video_codec_type != CODEC_TYPE_MPEG4) return AVIIF_KEYFRAME;
+    for (uint32_t i = 0; i + 4 < size && i < 1024; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 && data[i + 3] == 0xB6)
+            return (data[i + 4] >> 6) == 0 ? AVIIF_KEYFRAME : 0;
+    }
+    return frame_is_delta(idx) ? 0 : AVIIF_KEYFRAME;
+}
+
+/* The hdrl list of the input, as it is */
+static uint8_t *read_hdrl(const char *path, uint32_t *len) {
+    pfile_t *f = pf_open(path);
+    uint8_t h[12], *buf = NULL;
+    uint32_t pos = 12, size;
+
+    if (!f) return NULL;
+    while (pf_seek(f, pos, SEEK_SET) == 0 && pf_read(f, h, 12) == 12) {
+        size = read_u32_le(h + 4);
+        if (memcmp(h, "LIST", 4) == 0 && memcmp(h + 8, "hdrl", 4) == 0) {
+            if (size >= 4 && size <= REMUX_HDRL_MAX && (buf = (uint8_t *)malloc(size - 4)) != NULL) {
+                if (pf_read(f, buf, size - 4) == size - 4) *len = size - 4;
+                else { free(buf); buf = NULL; }
+            }
+            break;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    pf_close(f);
+    return buf;
+}
+
+/* Rewrite hdrl for the new layout. OpenDML indexes would point into the
+   old file, so they (and the odml list) become JUNK. With -t the video
+   stream is described as PMPT at the encoded size */
+static void patch_hdrl(uint8_t *p, uint32_t len, uint32_t max_video, uint32_t max_audio, uint32_t max_chunk) {
+    uint32_t pos = 0, size;
+    int stream = 0;  /* 1 video, 2 audio */
+
+    while (pos + 8 <= len) {
+        uint8_t *c = p + pos;
+        size = read_u32_le(c + 4);
+        if (size > len - pos - 8) break;
+        if (memcmp(c, "LIST", 4) == 0 && size >= 4 && memcmp(c + 8, "strl", 4) == 0) {
+            patch_hdrl(c + 12, size - 4, max_video, max_audio, max_chunk);
+        } else if (memcmp(c, "LIST", 4) == 0 && size >= 4 && memcmp(c + 8, "odml", 4) == 0) {
+            memcpy(c, "JUNK", 4);
+        } else if (memcmp(c, "indx", 4) == 0) {
+            memcpy(c, "JUNK", 4);
+        } else if (memcmp(c, "avih", 4) == 0 && size >= 32) {
+            put_u32_le(c + 8 + 8, out_align);                              /* dwPaddingGranularity */
+            put_u32_le(c + 8 + 12, read_u32_le(c + 8 + 12) | AVIF_HASINDEX | AVIF_ISINTERLEAVED);
+            put_u32_le(c + 8 + 16, total_frames);                          /* dwTotalFrames */
+            put_u32_le(c + 8 + 28, max_chunk);                             /* dwSuggestedBufferSize */
+            if (tile_mode && size >= 40) {
+                put_u32_le(c + 8 + 32, enc_w);                             /* dwWidth */
+                put_u32_le(c + 8 + 36, enc_h);
+            }
+        } else if (memcmp(c, "strh", 4) == 0 && size >= 40) {
+            stream = memcmp(c + 8, "vids", 4) == 0 ? 1 : memcmp(c + 8, "auds", 4) == 0 ? 2 : 0;
+            if (stream == 1) {
+                put_u32_le(c + 8 + 32, total_frames);                      /* dwLength */
+                put_u32_le(c + 8 + 36, max_video);
+                if (tile_mode) {
+                    memcpy(c + 8 + 4, "PMPT", 4);                          /* fccHandler */
+                    if (size >= 56) {                                      /* rcFrame */
+                        put_u32_le(c + 8 + 48, 0);
+                        put_u32_le(c + 8 + 52, (uint32_t)enc_h << 16 | enc_w);
+                    }
+                }
+            } else if (stream == 2) {
+                put_u32_le(c + 8 + 36, max_audio);
+            }
+        } else if (memcmp(c, "strf", 4) == 0 && stream == 1 && tile_mode && size >= 40) {
+            put_u32_le(c + 8 + 4, enc_w);                                  /* biWidth */
+            put_u32_le(c + 8 + 8, enc_h);
+            c[8 + 14] = 16;                                                /* biBitCount */
+            c[8 + 15] = 0;
+            memcpy(c + 8 + 16, "PMPT", 4);                                 /* biCompression */
+            put_u32_le(c + 8 + 20, enc_w * enc_h * 2);                     /* biSizeImage */
+            /* MPEG-4 extradata (the VOL header) is no use to PMPT */
+            if (size >= 48) {
+                put_u32_le(c + 4, 40);
+                memcpy(c + 8 + 40, "JUNK", 4);
+                put_u32_le(c + 8 + 44, size - 48);
+            } else {
+                memset(c + 8 + 40, 0, size - 40);
+            }
+        }
+        pos += 8 + size + (size & 1);
+    }
+}
+
+/* ========== Remux ========== */
+
+static int remux(const char *in_path, const char *out_path, uint32_t audio_ms) {
+    uint8_t *hdrl;
+    uint32_t hdrl_len = 0, max_video = 0, max_chunk, block, align;
+    uint64_t riff_pos, hdrl_pos, movi_pos, audio_total = 0, audio_done = 0, bytes_per_sec;
+    uint8_t vtag[4] = "00dc", atag[4] = "01wb";
+    int a_idx = 0, have_atag = 0;
+    uint32_t a_pos = 0;
+    uint8_t *ablock;
+
+    video_file = pf_open(in_path);
+    if (!video_file || !parse_avi()) {
+        fprintf(stderr, "%s: not an AVI the player can open\n", in_path);
+        return 0;
+    }
+    while (index_mode != INDEX_DONE) index_step(INDEX_STEP);
+    index_close();
+
+    hdrl = read_hdrl(in_path, &hdrl_len);
+    if (!hdrl) {
+        fprintf(stderr, "%s: no hdrl list\n", in_path);
+        return 0;
+    }
+
+    /* Audio: the stream re-cut in blocks of audio_ms, whole sample blocks
+       (ADPCM) or frames (PCM) each. Its average rate comes from its length */
+    for (int i = 0; i < total_audio_chunks; i++) audio_total += audio_size(i);
+    align = (audio_format == AUDIO_FMT_MP3 || adpcm_block_align == 0) ? 1 : adpcm_block_align;
+    bytes_per_sec = total_frames > 0 ? audio_total * 1000000 / ((uint64_t)total_frames * us_per_frame) : 0;
+    block = (uint32_t)(bytes_per_sec * audio_ms / 1000);
+    if (block > REMUX_AUDIO_MAX) block = REMUX_AUDIO_MAX;
+    block -= block % align;
+    if (block < align) block = align;
+    ablock = (uint8_t *)malloc(block);
+
+    if (tile_mode && !tile_setup()) {
+        fprintf(stderr, "%s: cannot encode PMPT\n", in_path);
+        return 0;
+    }
+
+    entries = (remux_entry_t *)malloc(sizeof(remux_entry_t) *
+                                      (total_frames + (audio_total / block) + 2));
+    out = fopen(out_path, "wb");
+    if (!ablock || !entries || !out) {
+        fprintf(stderr, "%s: cannot write\n", out_path);
+        return 0;
+    }
+
+    riff_pos = out_pos;
+    out_header("RIFF", 0);
+    out_write("AVI ", 4);
+    out_header("LIST", hdrl_len + 4);
+    out_write("hdrl", 4);
+    hdrl_pos = out_pos;
+    out_write(hdrl, hdrl_len);  /* patched once the chunk sizes are known */
+
+    /* The player (like most readers) tells movi-relative idx1 offsets from
+       absolute ones by looking for a chunk header. With every chunk on a
+       boundary, 'movi' on one too would make both readings find one */
+    if (out_align > 1 && (out_pos + 8) % out_align == 0) out_header("JUNK", 0);
+    movi_pos = out_pos;
+    out_movi = movi_pos + 8;
+    out_header("LIST", 0);
+    out_write("movi", 4);
+
+    for (int f = 0; f <= total_frames; f++) {
+        /* Audio up to this frame's time, and one block beyond it */
+        uint64_t due = f < total_frames ? bytes_per_sec * f * us_per_frame / 1000000 : audio_total;
+        while (audio_done < audio_total && audio_done <= due) {
+            uint32_t n = 0, want = audio_total - audio_done < block ? (uint32_t)(audio_total - audio_done) : block;
+            while (n < want && a_idx < total_audio_chunks) {
+                uint32_t size = audio_size(a_idx), take = size - a_pos;
+                const uint8_t *c = read_chunk(audio_offset(a_idx), size);
+                if (!c) {
+                    fprintf(stderr, "%s: read error in audio chunk %d\n", in_path, a_idx);
+                    return 0;
+                }
+                if (!have_atag) {
+                    chunk_tag(atag, c, "01wb");
+                    have_atag = 1;
+                }
+                if (take > want - n) take = want - n;
+                memcpy(ablock + n, c + 8 + a_pos, take);
+                n += take;
+                a_pos += take;
+                if (a_pos >= size) {
+                    a_idx++;
+                    a_pos = 0;
+                }
+            }
+            if (n == 0) break;
+            if (!out_chunk(movi_pos + 8, atag, ablock, n, AVIIF_KEYFRAME)) goto write_error;
+            audio_done += n;
+            if (n < want) audio_total = audio_done;  /* index promised more than there is */
+        }
+        if (f == total_frames) break;
+
+        uint32_t size = frame_size(f), flags;
+        const uint8_t *c = read_chunk(frame_offset(f), tile_mode ? 0 : size), *data;
+        if (!c) {
+            fprintf(stderr, "%s: read error in frame %d\n", in_path, f);
+            return 0;
+        }
+        if (f == 0) chunk_tag(vtag, c, "00dc");
+        if (tile_mode) {
+            /* a keyframe every second bounds the decoding on a seek */
+            int key = f % (clip_fps > 0 ? (int)clip_fps : 1) == 0;
+            size = tile_frame(f, key);
+            data = enc_buf;
+            flags = key ? AVIIF_KEYFRAME : 0;
+        } else {
+            data = c + 8;
+            flags = video_flags(f, data, size);
+        }
+        if (size > max_video) max_video = size;
+        if (!out_chunk(movi_pos + 8, vtag, data, size, flags)) goto write_error;
+        if (out_pos > 0xFFFFFFFFull - 16ull * entry_count) {
+            fprintf(stderr, "%s: over 4 GB, the player reads only FAT32 files\n", out_path);
+            return 0;
+        }
+    }
+
+    if (!out_patch_u32(movi_pos + 4, (uint32_t)(out_pos - movi_pos - 8))) goto write_error;
+
+    out_header("idx1", entry_count * 16);
+    for (int i = 0; i < entry_count; i++) {
+        uint8_t e[16];
+        memcpy(e, entries[i].tag, 4);
+        put_u32_le(e + 4, entries[i].flags);
+        put_u32_le(e + 8, entries[i].offset);
+        put_u32_le(e + 12, entries[i].size);
+        if (!out_write(e, 16)) goto write_error;
+    }
+    if (!out_patch_u32(riff_pos + 4, (uint32_t)(out_pos - 8))) goto write_error;
+
+    max_chunk = audio_total && block > max_video ? block : max_video;
+    patch_hdrl(hdrl, hdrl_len, max_video, audio_total ? block : 0, max_chunk);
+    if (!out_patch(hdrl_pos, hdrl, hdrl_len)) goto write_error;
+    free(hdrl);
+    if (tile_mode) tile_done();
+
+    if (fclose(out) != 0) {
+        out = NULL;
+        goto write_error;
+    }
+    out = NULL;
+
+    printf("%s: %d frames", out_path, total_frames);
+    if (tile_mode) printf(" of PMPT %dx%d", enc_w, enc_h);
+    if (audio_total) printf(", %d audio blocks of %u bytes", entry_count - total_frames, (unsigned)block);
+    printf(", largest chunk %u, %llu KB of padding\n", (unsigned)max_chunk, (unsigned long long)(out_junk / 1024));
+    free(ablock);
+    pf_close(video_file);
+    video_file = NULL;
+    return 1;
+
+write_error:
+    fprintf(stderr, "%s: write error\n", out_path);
+    return 0;
+}
+
+/* Open the output the way the player does: its index must find every
+   chunk where it was written. Leaves the file open */
+static int check_output(const char *path) {
+    int v = 0, a = 0, ok;
+
+    video_file = pf_open(path);
+    if (!video_file || !parse_avi()) {
+        fprintf(stderr, "%s: the player cannot open the output\n", path);
+        return 0;
+    }
+    while (index_mode != INDEX_DONE) index_step(INDEX_STEP);
+    index_close();
+
+    for (int i = 0; i < entry_count; i++) {
+        uint32_t data = (uint32_t)(out_movi + entries[i].offset + 8);
+        if ((entries[i].tag[3] | 0x20) == 'c') ok = v < total_frames && frame_offset(v++) == data;
+        else ok = a < total_audio_chunks && audio_offset(a++) == data;
+        if (!ok) {
+            fprintf(stderr, "%s: the player finds chunk %d elsewhere\n", path, i);
+            return 0;
+        }
+    }
+    if (v != total_frames || a != total_audio_chunks) {
+        fprintf(stderr, "%s: the player finds %d frames, %d audio chunks\n", path, total_frames, total_audio_chunks);
+        return 0;
+    }
+    return 1;
+}
+
+/* Build the seek previews of the output opened by check_output */
+static void build_previews(const char *path) {
+    int shown = 0;
+
+    frame_buf_alloc();
+    init_yuv_tables();
+    if (video_codec_type == CODEC_TYPE_MPEG4) init_xvid_mpeg4();
+
+    thumb_reset(path);
+    for (int p = 0; p < THUMB_COUNT; p++) {
+        thumb_frame[p] = thumb_build(p, thumb_pixels[p]);
+        shown += (thumb_frame[p] >= 0);
+    }
+    thumb_xvid_close();
+    close_xvid();
+    if (shown) thumb_save();
+    printf("%s: %d of %d seek previews\n", thumb_path, shown, THUMB_COUNT);
+    frame_buf_free();
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: pmp-remux [-a align] [-b audio_ms] [-n] [-t [-q error]] [-v] in.avi out.avi\n"
+            "  -a  chunk data alignment, a power of two from 16 (default %d, 1 = none)\n"
+            "  -b  audio block duration in ms (default %d)\n"
+            "  -n  no seek previews (out.avi.thm)\n"
+            "  -t  re-encode the video as PMPT tiles, the lowest CPU use\n"
+            "  -q  largest PMPT error per colour channel, 0-255 (default %d, 0 = lossless)\n"
+            "  -v  player log on stderr\n",
+            REMUX_ALIGN, REMUX_AUDIO_MS, REMUX_TILE_ERROR);
+}
+
+int main(int argc, char **argv) {
+    uint32_t audio_ms = REMUX_AUDIO_MS;
+    int previews = 1, i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) out_align = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) audio_ms = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0) previews = 0;
+        else if (strcmp(argv[i], "-t") == 0) tile_mode = 1;
+        else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) tile_error = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (argc - i != 2 || audio_ms == 0 || tile_error < 0 || tile_error > 255 ||
+        (out_align != 1 && (out_align < 16 || (out_align & (out_align - 1))))) {
+        usage();
+        return 2;
+    }
+    if (strcmp(argv[i], argv[i + 1]) == 0) {
+        fprintf(stderr, "pmp-remux: input and output are the same file\n");
+        return 2;
+    }
+
+    if (!remux(argv[i], argv[i + 1], audio_ms)) return 1;
+    if (!check_output(argv[i + 1])) return 1;
+    if (previews) build_previews(argv[i + 1]);
+    pf_close(video_file);
+    free(entries);
+    return 0;
+}
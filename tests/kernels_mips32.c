@@ -0,0 +1,146 @@
+/*
+ * kernels_mips32 - host conformance test of the mips32 kernels
+ *
+ * Built and run by "make check". The mips32 kernels are plain C on 32-bit
+ * words (ld32/st32 from utils/mips_asm/mips32.h), so they build and run
+ * unchanged on a little-endian host like the SF2000. Each one is fed
+ * random blocks (noise, black/white, near-saturated) with both rounding
+ * modes and unaligned sources, and its output must match the _c version
+ * byte for byte.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "portab.h"
+#include "image/interpolate8x8.h"
+#include "utils/mem_transfer.h"
+
+/* interpolate8x8.h and mem_transfer.h only declare these for ARCH_IS_MIPS32 */
+INTERPOLATE8X8 interpolate8x8_halfpel_h_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_mips32;
+INTERPOLATE8X4 interpolate8x4_halfpel_h_mips32;
+INTERPOLATE8X4 interpolate8x4_halfpel_v_mips32;
+INTERPOLATE8X4 interpolate8x4_halfpel_hv_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_h_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_add_mips32;
+INTERPOLATE8X8_AVG2 interpolate8x8_avg2_mips32;
+extern TRANSFER_16TO8COPY transfer_16to8copy_mips32;
+extern TRANSFER_16TO8ADD transfer_16to8add_mips32;
+extern TRANSFER8X8_COPY transfer8x8_copy_mips32;
+
+#define STRIDE 40
+#define ITERS  20000
+
+static uint32_t seed = 1;
+static int fails = 0;
+
+static uint32_t
+rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/* mode 0: noise, 1: black/white, 2: near-saturated */
+static void
+fill(uint8_t *buf, int n, int mode)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		buf[i] = mode == 0 ? rnd() : mode == 1 ? (rnd() & 1 ? 255 : 0) : 250 + rnd() % 6;
+}
+
+static void
+report(const char *name, int ok)
+{
+	printf("%s %s_mips32\n", ok ? "ok  " : "FAIL", name);
+	if (!ok)
+		fails++;
+}
+
+typedef void HALFPEL(uint8_t * const, const uint8_t * const, const uint32_t, const uint32_t);
+
+static void
+test_halfpel(const char *name, HALFPEL *ref, HALFPEL *mips)
+{
+	int it;
+	for (it = 0; it < ITERS; it++) {
+		uint8_t src[STRIDE * 12 + 16], d1[STRIDE * 12], d2[STRIDE * 12];
+		const int mode = it % 3, off = rnd() % 8;
+		fill(src, sizeof(src), mode);
+		fill(d1, sizeof(d1), mode);
+		memcpy(d2, d1, sizeof(d1));
+		ref(d1 + 3, src + off, STRIDE, it & 1);
+		mips(d2 + 3, src + off, STRIDE, it & 1);
+		if (memcmp(d1, d2, sizeof(d1)))
+			break;
+	}
+	report(name, it == ITERS);
+}
+
+static void
+test_transfers(void)
+{
+	int it, ok_copy = 1, ok_add = 1, ok_copy16 = 1, ok_avg2 = 1;
+	for (it = 0; it < ITERS; it++) {
+		uint8_t s1[STRIDE * 9 + 8], s2[STRIDE * 9 + 8], d1[STRIDE * 9], d2[STRIDE * 9];
+		int16_t coef[64];
+		const int off = rnd() % 4, height = 1 + rnd() % 8;
+		int i;
+
+		fill(s1, sizeof(s1), it % 3);
+		fill(s2, sizeof(s2), it % 3);
+		for (i = 0; i < 64; i++)
+			coef[i] = (it & 1) ? (int)(rnd() % 32768) - 16384 : (int)(rnd() % 600) - 300;
+
+		fill(d1, sizeof(d1), 0);
+		memcpy(d2, d1, sizeof(d1));
+		transfer8x8_copy_c(d1 + 1, s1 + off, STRIDE);
+		transfer8x8_copy_mips32(d2 + 1, s1 + off, STRIDE);
+		ok_copy &= !memcmp(d1, d2, sizeof(d1));
+
+		fill(d1, sizeof(d1), it % 3);
+		memcpy(d2, d1, sizeof(d1));
+		transfer_16to8add_c(d1 + off, coef, STRIDE);
+		transfer_16to8add_mips32(d2 + off, coef, STRIDE);
+		ok_add &= !memcmp(d1, d2, sizeof(d1));
+
+		transfer_16to8copy_c(d1 + off, coef, STRIDE);
+		transfer_16to8copy_mips32(d2 + off, coef, STRIDE);
+		ok_copy16 &= !memcmp(d1, d2, sizeof(d1));
+
+		interpolate8x8_avg2_c(d1 + 1, s1 + off, s2 + 3, STRIDE, (it >> 1) & 1, height);
+		interpolate8x8_avg2_mips32(d2 + 1, s1 + off, s2 + 3, STRIDE, (it >> 1) & 1, height);
+		ok_avg2 &= !memcmp(d1, d2, sizeof(d1));
+	}
+	report("transfer8x8_copy", ok_copy);
+	report("transfer_16to8add", ok_add);
+	report("transfer_16to8copy", ok_copy16);
+	report("interpolate8x8_avg2", ok_avg2);
+}
+
+int
+main(void)
+{
+#define HALFPEL_TEST(name) test_halfpel(#name, name##_c, name##_mips32)
+	HALFPEL_TEST(interpolate8x8_halfpel_h);
+	HALFPEL_TEST(interpolate8x8_halfpel_v);
+	HALFPEL_TEST(interpolate8x8_halfpel_hv);
+	HALFPEL_TEST(interpolate8x4_halfpel_h);
+	HALFPEL_TEST(interpolate8x4_halfpel_v);
+	HALFPEL_TEST(interpolate8x4_halfpel_hv);
+	HALFPEL_TEST(interpolate8x8_halfpel_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_h_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_v_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_hv_add);
+#undef HALFPEL_TEST
+
+	test_transfers();
+
+	printf("kernels_mips32: %d failed\n", fails);
+	return fails != 0;
+}
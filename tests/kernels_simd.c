@@ -0,0 +1,283 @@
+/*
+ * kernels_simd - host conformance test of the SSE2 / NEON intrinsics kernels
+ *
+ * Built and run by "make check". Every kernel xvid.c can pick on this host
+ * is fed random blocks (noise, black/white, near-saturated) with both
+ * rounding modes and unaligned sources, and its output must match the _c
+ * version byte for byte. On a host with neither SSE2 nor NEON there is
+ * nothing to compare and the test passes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "portab.h"
+#include "image/interpolate8x8.h"
+#include "image/qpel.h"
+#include "utils/mem_transfer.h"
+#include "dct/idct.h"
+
+#if defined(ARCH_IS_SSE2) || defined(ARCH_IS_NEON)
+
+#if defined(ARCH_IS_SSE2)
+#define SIMD(name) name##_sse2_c
+#define QP_FUNCS xvid_QP_Funcs_SSE2_C
+#define QP_ADD_FUNCS xvid_QP_Add_Funcs_SSE2_C
+#define SIMD_NAME "sse2"
+#else
+#define SIMD(name) name##_neon_c
+#define QP_FUNCS xvid_QP_Funcs_NEON_C
+#define QP_ADD_FUNCS xvid_QP_Add_Funcs_NEON_C
+#define SIMD_NAME "neon"
+#endif
+
+extern void SIMD(GMC_Core_Lin_8)(uint8_t *Dst, const uint16_t *Offsets,
+								 const uint8_t * const Src0, const int BpS,
+								 const int Rounder);
+
+#define STRIDE 48
+#define ITERS  20000
+
+static uint32_t seed = 1;
+static int fails = 0;
+
+static uint32_t
+rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/* mode 0: noise, 1: black/white, 2: near-saturated */
+static void
+fill(uint8_t *buf, int n, int mode)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		buf[i] = mode == 0 ? rnd() : mode == 1 ? (rnd() & 1 ? 255 : 0) : 250 + rnd() % 6;
+}
+
+static void
+report(const char *name, int ok)
+{
+	printf("%s %s_" SIMD_NAME "\n", ok ? "ok  " : "FAIL", name);
+	if (!ok)
+		fails++;
+}
+
+typedef void HALFPEL(uint8_t * const, const uint8_t * const, const uint32_t, const uint32_t);
+
+static void
+test_halfpel(const char *name, HALFPEL *ref, HALFPEL *simd)
+{
+	int it;
+	for (it = 0; it < ITERS; it++) {
+		uint8_t src[STRIDE * 12 + 16], d1[STRIDE * 12], d2[STRIDE * 12];
+		const int mode = it % 3, off = rnd() % 8;
+		fill(src, sizeof(src), mode);
+		fill(d1, sizeof(d1), mode);
+		memcpy(d2, d1, sizeof(d1));
+		ref(d1 + 3, src + off, STRIDE, it & 1);
+		simd(d2 + 3, src + off, STRIDE, it & 1);
+		if (memcmp(d1, d2, sizeof(d1)))
+			break;
+	}
+	report(name, it == ITERS);
+}
+
+static void
+test_transfers(void)
+{
+	int it, ok_copy = 1, ok_add = 1, ok_copy16 = 1, ok_avg2 = 1;
+	for (it = 0; it < ITERS; it++) {
+		uint8_t s1[STRIDE * 9 + 8], s2[STRIDE * 9 + 8], d1[STRIDE * 9], d2[STRIDE * 9];
+		int16_t coef[64];
+		const int off = rnd() % 4, height = 1 + rnd() % 8;
+		int i;
+
+		fill(s1, sizeof(s1), it % 3);
+		fill(s2, sizeof(s2), it % 3);
+		for (i = 0; i < 64; i++)
+			coef[i] = (it & 1) ? (int)(rnd() % 32768) - 16384 : (int)(rnd() % 600) - 300;
+
+		fill(d1, sizeof(d1), 0);
+		memcpy(d2, d1, sizeof(d1));
+		transfer8x8_copy_c(d1 + 1, s1 + off, STRIDE);
+		SIMD(transfer8x8_copy)(d2 + 1, s1 + off, STRIDE);
+		ok_copy &= !memcmp(d1, d2, sizeof(d1));
+
+		fill(d1, sizeof(d1), it % 3);
+		memcpy(d2, d1, sizeof(d1));
+		transfer_16to8add_c(d1 + off, coef, STRIDE);
+		SIMD(transfer_16to8add)(d2 + off, coef, STRIDE);
+		ok_add &= !memcmp(d1, d2, sizeof(d1));
+
+		transfer_16to8copy_c(d1 + off, coef, STRIDE);
+		SIMD(transfer_16to8copy)(d2 + off, coef, STRIDE);
+		ok_copy16 &= !memcmp(d1, d2, sizeof(d1));
+
+		interpolate8x8_avg2_c(d1 + 1, s1 + off, s2 + 3, STRIDE, (it >> 1) & 1, height);
+		SIMD(interpolate8x8_avg2)(d2 + 1, s1 + off, s2 + 3, STRIDE, (it >> 1) & 1, height);
+		ok_avg2 &= !memcmp(d1, d2, sizeof(d1));
+	}
+	report("transfer8x8_copy", ok_copy);
+	report("transfer_16to8add", ok_add);
+	report("transfer_16to8copy", ok_copy16);
+	report("interpolate8x8_avg2", ok_avg2);
+}
+
+/* mode 0: dense, 1: sparse, 2: first row/column only, 3: full 16-bit range */
+static void
+test_idct(void)
+{
+	int it;
+	for (it = 0; it < 10 * ITERS; it++) {
+		short b1[64], b2[64];
+		const int mode = it % 4;
+		int i;
+		for (i = 0; i < 64; i++)
+			b1[i] = mode == 0 ? (int)(rnd() % 4096) - 2048 :
+					mode == 1 ? (rnd() % 8 == 0 ? (int)(rnd() % 4096) - 2048 : 0) :
+					mode == 2 ? (i < 8 || i % 8 == 0 ? (int)(rnd() % 512) - 256 : 0) :
+					(int)(rnd() % 65536) - 32768;
+		memcpy(b2, b1, sizeof(b1));
+		idct_int32(b1);
+		SIMD(idct)(b2);
+		if (memcmp(b1, b2, sizeof(b1)))
+			break;
+	}
+	report("idct", it == 10 * ITERS);
+}
+
+/* the 12 passes of each table: 16-wide ones first, then the 8-wide ones;
+ * the h-passes read length+1 source pixels, the v-passes length+1 rows */
+static void
+test_qpel(void)
+{
+	static const char * const names[12] = {
+		"H_Pass", "H_Pass_Avrg", "H_Pass_Avrg_Up",
+		"V_Pass", "V_Pass_Avrg", "V_Pass_Avrg_Up",
+		"H_Pass_8", "H_Pass_Avrg_8", "H_Pass_Avrg_Up_8",
+		"V_Pass_8", "V_Pass_Avrg_8", "V_Pass_Avrg_Up_8"
+	};
+	XVID_QP_PASS **ref = (XVID_QP_PASS **)&xvid_QP_Funcs_C;
+	XVID_QP_PASS **ref_add = (XVID_QP_PASS **)&xvid_QP_Add_Funcs_C;
+	XVID_QP_PASS **simd = (XVID_QP_PASS **)&QP_FUNCS;
+	XVID_QP_PASS **simd_add = (XVID_QP_PASS **)&QP_ADD_FUNCS;
+	int k, it;
+
+	for (k = 0; k < 24; k++) {
+		XVID_QP_PASS *f1 = k < 12 ? ref[k] : ref_add[k - 12];
+		XVID_QP_PASS *f2 = k < 12 ? simd[k] : simd_add[k - 12];
+		const int pass = k % 12, wide = pass < 6, vertical = pass % 6 >= 3;
+		char name[32];
+
+		for (it = 0; it < ITERS; it++) {
+			uint8_t src[STRIDE * 20], d1[STRIDE * 20], d2[STRIDE * 20];
+			const int mode = it % 3;
+			int len;
+			if (vertical)
+				len = wide ? 16 : (rnd() & 1 ? 8 : 16);
+			else
+				len = wide ? (rnd() & 1 ? 16 : 17) : (rnd() & 1 ? 8 : 9);
+			fill(src, sizeof(src), mode);
+			fill(d1, sizeof(d1), mode);
+			memcpy(d2, d1, sizeof(d1));
+			f1(d1 + 2, src + 5, len, STRIDE, it & 1);
+			f2(d2 + 2, src + 5, len, STRIDE, it & 1);
+			if (memcmp(d1, d2, sizeof(d1)))
+				break;
+		}
+		snprintf(name, sizeof(name), "%s%s", k < 12 ? "qpel " : "qpel add ", names[pass]);
+		report(name, it == ITERS);
+	}
+}
+
+/* gmc.c keeps its C core static; this is the same arithmetic */
+#define MLT(i)  (((16-(i))<<16) + (i))
+static const uint32_t MTab[16] = {
+	MLT( 0), MLT( 1), MLT( 2), MLT( 3), MLT( 4), MLT( 5), MLT( 6), MLT( 7),
+	MLT( 8), MLT( 9), MLT(10), MLT(11), MLT(12), MLT(13), MLT(14), MLT(15)
+};
+#undef MLT
+
+static void
+gmc_core_c(uint8_t *Dst, const uint16_t *Offsets, const uint8_t * const Src0,
+		   const int srcstride, const int Rounder)
+{
+	int i;
+	for (i = 0; i < 8; ++i) {
+		const uint32_t u = Offsets[i], v = Offsets[i + 16];
+		const uint32_t ri = MTab[u & 0x0f], rj = MTab[v & 0x0f];
+		const uint8_t * const Src = Src0 + (u >> 4) + (v >> 4) * srcstride;
+		uint32_t f0, f1;
+		f0 = Src[0] | (Src[1] << 16);
+		f1 = Src[srcstride] | (Src[srcstride + 1] << 16);
+		f0 = (ri * f0) >> 16;
+		f1 = (ri * f1) & 0x0fff0000;
+		f0 |= f1;
+		Dst[i] = (uint8_t)((rj * f0 + Rounder) >> 24);
+	}
+}
+
+static void
+test_gmc(void)
+{
+	int it;
+	for (it = 0; it < 10 * ITERS; it++) {
+		uint8_t src[STRIDE * 3], d1[8], d2[8];
+		uint16_t offsets[32];
+		int i, rho, rounding, rounder;
+		fill(src, sizeof(src), it % 3);
+		for (i = 0; i < 8; i++) {
+			offsets[i] = (i << 4) | (rnd() & 15);
+			offsets[16 + i] = rnd() & 15;
+		}
+		rho = rnd() % 4;
+		rounding = rnd() & 1;
+		rounder = (128 - (rounding << (2 * rho))) << 16;
+		gmc_core_c(d1, offsets, src + 3, STRIDE, rounder);
+		SIMD(GMC_Core_Lin_8)(d2, offsets, src + 3, STRIDE, rounder);
+		if (memcmp(d1, d2, 8))
+			break;
+	}
+	report("GMC_Core_Lin_8", it == 10 * ITERS);
+}
+
+int
+main(void)
+{
+	xvid_Init_QP();
+
+#define HALFPEL_TEST(name) test_halfpel(#name, name##_c, SIMD(name))
+	HALFPEL_TEST(interpolate8x8_halfpel_h);
+	HALFPEL_TEST(interpolate8x8_halfpel_v);
+	HALFPEL_TEST(interpolate8x8_halfpel_hv);
+	HALFPEL_TEST(interpolate8x4_halfpel_h);
+	HALFPEL_TEST(interpolate8x4_halfpel_v);
+	HALFPEL_TEST(interpolate8x4_halfpel_hv);
+	HALFPEL_TEST(interpolate8x8_halfpel_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_h_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_v_add);
+	HALFPEL_TEST(interpolate8x8_halfpel_hv_add);
+#undef HALFPEL_TEST
+
+	test_transfers();
+	test_idct();
+	test_qpel();
+	test_gmc();
+
+	printf("kernels_simd: %d failed\n", fails);
+	return fails != 0;
+}
+
+#else
+
+int
+main(void)
+{
+	printf("kernels_simd: no SSE2 or NEON on this host, nothing to test\n");
+	return 0;
+}
+
+#endif
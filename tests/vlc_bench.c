@@ -0,0 +1,162 @@
+/*
+ * vlc_bench - DCT coefficient VLC decoding speed on the host
+ *
+ * Built and run by "make bench". Writes a stream of valid intra and inter
+ * blocks from coeff_tab, with the code lengths the table was designed for,
+ * then times get_intra_block, get_inter_block_h263 and
+ * get_inter_block_mpeg over it. The intra pass also checks every decoded
+ * coefficient against what was written. The figures only compare builds
+ * on the same machine; the SF2000 is far slower.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "portab.h"
+#include "global.h"
+#include "bitstream/bitstream.h"
+#include "bitstream/mbcoding.h"
+#include "bitstream/vlc_codes.h"
+#include "bitstream/zigzag.h"
+
+#define BLOCKS 100000
+#define REPEAT 20
+
+static uint32_t seed = 1;
+
+static uint32_t
+rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/* MSB-first bit writer, the order BitstreamGetBits reads */
+typedef struct
+{
+	uint8_t *buf;
+	uint32_t pos;
+} WRITER;
+
+static void
+put_bits(WRITER *w, uint32_t value, uint32_t len)
+{
+	while (len--) {
+		if ((value >> len) & 1)
+			w->buf[w->pos >> 3] |= 0x80 >> (w->pos & 7);
+		w->pos++;
+	}
+}
+
+/* a coeff_tab entry with the given last flag, each code as likely as its
+ * length implies (2^-len, what the table was designed for) */
+static const VLC_TABLE *
+pick_event(int intra, int last, int room)
+{
+	for (;;) {
+		const VLC_TABLE *e = &coeff_tab[intra][rnd() % 102];
+		if (e->event.last != last || e->event.run >= room)
+			continue;
+		if (rnd() & ((1 << (e->vlc.len - 2)) - 1))
+			continue;
+		return e;
+	}
+}
+
+/* writes BLOCKS blocks, returns the stream length in bits; with check
+ * set, the coefficients each intra block must decode to */
+static uint32_t
+write_stream(uint8_t *buf, int intra, int16_t *check)
+{
+	WRITER w = { buf, 0 };
+	int b;
+
+	for (b = 0; b < BLOCKS; b++) {
+		int coeff = intra, events = 1 + rnd() % 12;
+		for (;;) {
+			const int last = --events == 0 || coeff >= 63;
+			const VLC_TABLE *e = pick_event(intra, last, 64 - coeff - !last);
+			const int sign = rnd() & 1;
+			put_bits(&w, e->vlc.code, e->vlc.len);
+			put_bits(&w, sign, 1);
+			coeff += e->event.run;
+			if (check)
+				check[b * 64 + scan_tables[0][coeff]] = sign ? -e->event.level : e->event.level;
+			coeff++;
+			if (last)
+				break;
+		}
+	}
+	return w.pos;
+}
+
+static void
+report(const char *name, uint32_t bits, clock_t ticks)
+{
+	const double s = (double)ticks / CLOCKS_PER_SEC;
+	printf("%-22s %7.1f Mbit/s %6.1f ns/block\n", name,
+		   REPEAT * (double)bits / s / 1e6, s * 1e9 / ((double)REPEAT * BLOCKS));
+}
+
+int
+main(void)
+{
+	const uint32_t size = BLOCKS * 64 * 2;
+	uint8_t *intra = calloc(size + 8, 1), *inter = calloc(size + 8, 1);
+	int16_t *check = calloc(BLOCKS * 64, sizeof(int16_t));
+	static uint16_t matrix[64];
+	int16_t block[64];
+	uint32_t intra_bits, inter_bits;
+	Bitstream bs;
+	clock_t t0;
+	int i, r, errors = 0;
+
+	for (i = 0; i < 64; i++)
+		matrix[i] = 16 + i;
+	init_vlc_tables();
+	intra_bits = write_stream(intra, 1, check);
+	inter_bits = write_stream(inter, 0, NULL);
+
+	t0 = clock();
+	for (r = 0; r < REPEAT; r++) {
+		BitstreamInit(&bs, intra, size);
+		for (i = 0; i < BLOCKS; i++) {
+			memset(block, 0, sizeof(block));
+			get_intra_block(&bs, block, 0, 1);
+			if (r == 0 && memcmp(block, check + i * 64, sizeof(block)))
+				errors++;
+		}
+		if (BitstreamPos(&bs) != intra_bits)
+			errors++;
+	}
+	report("get_intra_block", intra_bits, clock() - t0);
+
+	t0 = clock();
+	for (r = 0; r < REPEAT; r++) {
+		BitstreamInit(&bs, inter, size);
+		for (i = 0; i < BLOCKS; i++)
+			get_inter_block_h263(&bs, block, 0, 5, NULL);
+		if (BitstreamPos(&bs) != inter_bits)
+			errors++;
+	}
+	report("get_inter_block_h263", inter_bits, clock() - t0);
+
+	t0 = clock();
+	for (r = 0; r < REPEAT; r++) {
+		BitstreamInit(&bs, inter, size);
+		for (i = 0; i < BLOCKS; i++)
+			get_inter_block_mpeg(&bs, block, 0, 7, matrix);
+		if (BitstreamPos(&bs) != inter_bits)
+			errors++;
+	}
+	report("get_inter_block_mpeg", inter_bits, clock() - t0);
+
+	free(intra);
+	free(inter);
+	free(check);
+	if (errors)
+		printf("vlc_bench: %d decode errors\n", errors);
+	return errors != 0;
+}
@@ -26,6 +26,7 @@
 #ifndef _BITSTREAM_H_
 #define _BITSTREAM_H_
 
+#include <string.h>
 #include "../portab.h"
 #include "../decoder.h"
 #ifndef SF2000
@@ -172,14 +173,60 @@ void write_video_packet_header(Bitstream * const bs,
  * Bitstream
  ****************************************************************************/
 
-/* Input buffer should be readable as full chunks of 8bytes, including
-the end of the buffer. Padding might be appropriate. If only chunks
-of 4bytes are applicable, define XVID_SAFE_BS_TAIL. Note that this will
-slow decoding, so consider this as a last-resort solution */
-#ifndef XVID_HAVE_PADDED_BS_BUFFER
-#define XVID_SAFE_BS_TAIL
+/* The reader loads whole cache words without checking the end of the
+ * input, so the buffer passed in must stay readable for XVID_BS_PADDING
+ * bytes past its length (see xvid.h). Once the stream is exhausted the
+ * cache is fed zeros. */
+
+/* refill threshold: ShowBits/Skip of up to this many bits never touch
+ * memory. 64-bit caches keep a full 32-bit peek available. */
+#if BS_CACHE_BITS == 64
+#define BS_MIN_CACHED 32
+#else
+#define BS_MIN_CACHED 25
 #endif
 
+/* big-endian load of one cache word from a possibly unaligned address */
+
+static __inline bs_cache_t
+BitstreamLoad(const uint8_t * const p)
+{
+	uint32_t hi;
+#if BS_CACHE_BITS == 64
+	uint32_t lo;
+#endif
+
+	memcpy(&hi, p, 4);
+#ifndef ARCH_IS_BIG_ENDIAN
+	BSWAP(hi);
+#endif
+#if BS_CACHE_BITS == 64
+	memcpy(&lo, p + 4, 4);
+#ifndef ARCH_IS_BIG_ENDIAN
+	BSWAP(lo);
+#endif
+	return ((bs_cache_t)hi << 32) | lo;
+#else
+	return hi;
+#endif
+}
+
+
+/* top up the cache with as many whole bytes as fit; no loop, no shifts
+ * by the full cache width (bits < BS_MIN_CACHED here) */
+
+static __inline void
+BitstreamRefill(Bitstream * const bs)
+{
+	int n = (BS_CACHE_BITS - bs->bits) >> 3;
+
+	if (bs->rptr < bs->end)
+		bs->cache |= BitstreamLoad(bs->rptr) >> bs->bits;
+	bs->rptr += n;
+	bs->bits += n << 3;
+}
+
+
 /* initialise bitstream structure */
 
 static void __inline
@@ -187,37 +234,15 @@ BitstreamInit(Bitstream * const bs,
 			  void *const bitstream,
 			  uint32_t length)
 {
-	uint32_t tmp;
-	size_t bitpos;
-	ptr_t adjbitstream = (ptr_t)bitstream;
-
-	/*
-	 * Start the stream on a uint32_t boundary, by rounding down to the
-	 * previous uint32_t and skipping the intervening bytes.
-	 */
-	bitpos = ((sizeof(uint32_t)-1) & (size_t)bitstream);
-	adjbitstream = adjbitstream - bitpos;
-	bs->start = bs->tail = (uint32_t *) adjbitstream;
-
-	tmp = *bs->start;
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufa = tmp;
-
-	tmp = *(bs->start + 1);
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufb = tmp;
+	bs->head = bs->rptr = (const uint8_t *) bitstream;
+	bs->end = bs->head + length;
+	bs->cache = 0;
+	bs->bits = 0;
+	BitstreamRefill(bs);
 
-	bs->pos = bs->initpos = (uint32_t) bitpos*8;
-	/* preserve the intervening bytes */
-	if (bs->initpos > 0)
-		bs->buf = bs->bufa & (0xffffffff << (32 - bs->initpos));
-	else
-		bs->buf = 0;
 	bs->length = length;
+	bs->start = bs->tail = (uint32_t *) bitstream;
+	bs->buf = bs->pos = bs->initpos = 0;
 }
 
 
@@ -226,79 +251,73 @@ BitstreamInit(Bitstream * const bs,
 static void __inline
 BitstreamReset(Bitstream * const bs)
 {
-	uint32_t tmp;
-
-	bs->tail = bs->start;
+	bs->rptr = bs->head;
+	bs->cache = 0;
+	bs->bits = 0;
+	BitstreamRefill(bs);
+}
 
-	tmp = *bs->start;
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufa = tmp;
 
-	tmp = *(bs->start + 1);
-#ifndef ARCH_IS_BIG_ENDIAN
-	BSWAP(tmp);
-#endif
-	bs->bufb = tmp;
+/*
+ * returns the next 32 bits left-aligned, of which at least BS_MIN_CACHED
+ * are valid; the rest are zero or also valid. Branch- and load-free, for
+ * VLC decoders that need fewer bits than that per symbol.
+ */
 
-	/* preserve the intervening bytes */
-	if (bs->initpos > 0)
-		bs->buf = bs->bufa & (0xffffffff << (32 - bs->initpos));
-	else
-		bs->buf = 0;
-	bs->pos = bs->initpos;
+static uint32_t __inline
+BitstreamShowCache(const Bitstream * const bs)
+{
+	return (uint32_t)(bs->cache >> (BS_CACHE_BITS - 32));
 }
 
 
-/* reads n bits from bitstream without changing the stream pos */
+/* reads n bits from bitstream without changing the stream pos (n <= 32) */
 
 static uint32_t __inline
 BitstreamShowBits(Bitstream * const bs,
 				  const uint32_t bits)
 {
-	int nbit = (bits + bs->pos) - 32;
-
-	if (nbit > 0) {
-		return ((bs->bufa & (0xffffffff >> bs->pos)) << nbit) | (bs->
-																 bufb >> (32 -
-																		  nbit));
-	} else {
-		return (bs->bufa & (0xffffffff >> bs->pos)) >> (32 - bs->pos - bits);
+#if BS_CACHE_BITS == 32
+	if (bits > BS_MIN_CACHED) {
+		/* fill the low bits of the word straight from memory */
+		uint32_t w = bs->cache;
+		if (bs->rptr < bs->end)
+			w |= (BitstreamLoad(bs->rptr) >> 1) >> (bs->bits - 1);
+		return w >> (32 - bits);
 	}
+#endif
+	/* split shift keeps bits == 0 defined */
+	return (uint32_t)((bs->cache >> 1) >> (BS_CACHE_BITS - 1 - bits));
 }
 
 
-/* skip n bits forward in bitstream */
+/* consume n <= BS_MIN_CACHED bits, refilling lazily */
 
 static __inline void
-BitstreamSkip(Bitstream * const bs,
-			  const uint32_t bits)
+BitstreamConsume(Bitstream * const bs,
+				 const uint32_t bits)
 {
-	bs->pos += bits;
+	bs->cache <<= bits;
+	bs->bits -= bits;
+	if (bs->bits < BS_MIN_CACHED)
+		BitstreamRefill(bs);
+}
 
-	if (bs->pos >= 32) {
-		uint32_t tmp;
 
-		bs->bufa = bs->bufb;
-#if defined(XVID_SAFE_BS_TAIL)
-		if (bs->tail<(bs->start+((bs->length+3)>>2)))
-#endif
-		{
-			tmp = *((uint32_t *) bs->tail + 2);
-#ifndef ARCH_IS_BIG_ENDIAN
-			BSWAP(tmp);
-#endif
-			bs->bufb = tmp;
-			bs->tail++;
-		}
-#if defined(XVID_SAFE_BS_TAIL)
-		else {
-			bs->bufb = 0;
-		}
-#endif
-		bs->pos -= 32;
+/* skip n bits forward in bitstream (n <= 32) */
+
+static __inline void
+BitstreamSkip(Bitstream * const bs,
+			  const uint32_t bits)
+{
+#if BS_CACHE_BITS == 32
+	if (bits > BS_MIN_CACHED) {
+		BitstreamConsume(bs, 16);
+		BitstreamConsume(bs, bits - 16);
+		return;
 	}
+#endif
+	BitstreamConsume(bs, bits);
 }
 
 
@@ -306,7 +325,8 @@ BitstreamSkip(Bitstream * const bs,
 static __inline uint32_t
 BitstreamNumBitsToByteAlign(Bitstream *bs)
 {
-	uint32_t n = (32 - bs->pos) % 8;
+	/* the cache always ends on a byte boundary */
+	uint32_t n = bs->bits & 7;
 	return n == 0 ? 8 : n;
 }
 
@@ -315,19 +335,9 @@ BitstreamNumBitsToByteAlign(Bitstream *bs)
 static __inline uint32_t
 BitstreamShowBitsFromByteAlign(Bitstream *bs, int bits)
 {
-	int bspos = bs->pos + BitstreamNumBitsToByteAlign(bs);
-	int nbit = (bits + bspos) - 32;
-
-	if (bspos >= 32) {
-		return bs->bufb >> (32 - nbit);
-	} else	if (nbit > 0) {
-		return ((bs->bufa & (0xffffffff >> bspos)) << nbit) | (bs->
-																 bufb >> (32 -
-																		  nbit));
-	} else {
-		return (bs->bufa & (0xffffffff >> bspos)) >> (32 - bspos - bits);
-	}
+	uint32_t n = BitstreamNumBitsToByteAlign(bs) + bits;
 
+	return BitstreamShowBits(bs, n) & (0xffffffff >> (32 - bits));
 }
 
 
@@ -337,10 +347,10 @@ BitstreamShowBitsFromByteAlign(Bitstream *bs, int bits)
 static __inline void
 BitstreamByteAlign(Bitstream * const bs)
 {
-	uint32_t remainder = bs->pos % 8;
+	uint32_t remainder = bs->bits & 7;
 
 	if (remainder) {
-		BitstreamSkip(bs, 8 - remainder);
+		BitstreamSkip(bs, remainder);
 	}
 }
 
@@ -350,7 +360,7 @@ BitstreamByteAlign(Bitstream * const bs)
 static uint32_t __inline
 BitstreamPos(const Bitstream * const bs)
 {
-	return((uint32_t)(8*((ptr_t)bs->tail - (ptr_t)bs->start) + bs->pos - bs->initpos));
+	return (uint32_t)(8*(bs->rptr - bs->head) - bs->bits);
 }
 
 
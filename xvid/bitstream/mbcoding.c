@@ -1003,7 +1003,7 @@ get_coeff(Bitstream * bs,
 	int32_t level;
 	REVERSE_EVENT *reverse_event;
 
-	uint32_t cache = BitstreamShowBits(bs, 32);
+	uint32_t cache = BitstreamShowCache(bs);
 	
 	if (short_video_header)		/* inter-VLCs will be used for both intra and inter blocks */
 		intra = 0;
@@ -1023,8 +1023,9 @@ get_coeff(Bitstream * bs,
 		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
 	}
 
-	/* flush 7bits of cache */
-	cache <<= 7;
+	/* flush the 7bit escape; everything after it fits in a fresh cache */
+	BitstreamSkip(bs, 7);
+	cache = BitstreamShowCache(bs);
 
 	if (short_video_header) {
 		/* escape mode 4 - H.263 type, only used if short_video_header = 1  */
@@ -1036,7 +1037,7 @@ get_coeff(Bitstream * bs,
 			DPRINTF(XVID_DEBUG_ERROR, "Illegal LEVEL for ESCAPE mode 4: %d\n", level);
 
 		/* We've "eaten" 22 bits */
-		BitstreamSkip(bs, 22);
+		BitstreamSkip(bs, 15);
 
 		return (level << 24) >> 24;
 	}
@@ -1062,7 +1063,7 @@ get_coeff(Bitstream * bs,
 		}
 		
 		/* Update bitstream position */
-		BitstreamSkip(bs, 7 + skip[mode] + reverse_event->len + 1);
+		BitstreamSkip(bs, skip[mode] + reverse_event->len + 1);
 
 		return (GET_BITS(cache, reverse_event->len+1)&0x01) ? -level : level;
 	}
@@ -1074,7 +1075,7 @@ get_coeff(Bitstream * bs,
 	level = (GET_BITS(cache, 20)&0xfff);
 	
 	/* Update bitstream position */
-	BitstreamSkip(bs, 30);
+	BitstreamSkip(bs, 23);
 
 	return (level << 20) >> 20;
 
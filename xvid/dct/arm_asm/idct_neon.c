@@ -0,0 +1,155 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - Inverse DCT, NEON intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_NEON)
+
+#include <arm_neon.h>
+#include "../idct.h"
+
+/* Same arithmetic as idct_int32() in idct.c and idct_sse2_c(), so the
+ * output is bit-identical: the row pass multiplies into 32 bits, the column
+ * pass keeps 32-bit intermediates (four columns per register) and both
+ * passes truncate to 16 bits on store. */
+
+#define ROW_TAB(C1,C2,C3,C4,C5,C6,C7) \
+  { {  C4,  C4,  C4,  C4 }, \
+    {  C1,  C3,  C5,  C7 }, \
+    {  C2,  C6, -C6, -C2 }, \
+    {  C3, -C7, -C1, -C5 }, \
+    {  C4, -C4, -C4,  C4 }, \
+    {  C5, -C1,  C7,  C3 }, \
+    {  C6, -C2,  C2, -C6 }, \
+    {  C7, -C5,  C3, -C1 } }
+
+/* coefficients of x0..x7 towards a0..a3 (even x) or b0..b3 (odd x) */
+static const int16_t Row_Tab[4][8][4] = {
+	ROW_TAB(22725, 21407, 19266, 16384, 12873,  8867, 4520),	/* 0,4 */
+	ROW_TAB(31521, 29692, 26722, 22725, 17855, 12299, 6270),	/* 1,7 */
+	ROW_TAB(29692, 27969, 25172, 21407, 16819, 11585, 5906),	/* 2,6 */
+	ROW_TAB(26722, 25172, 22654, 19266, 15137, 10426, 5315)		/* 3,5 */
+};
+#undef ROW_TAB
+
+static const int Row_Map[8] = { 0, 1, 2, 3, 0, 3, 2, 1 };
+static const int Row_Rnd[8] = { 65536, 3597, 2260, 1203, 0, 120, 512, 512 };
+
+#define ROW_SHIFT 11
+#define COL_SHIFT 6
+
+#define Tan1  0x32ec
+#define Tan2  0x6a0a
+#define Tan3  0xab0e
+#define Sqrt2 0x5a82
+
+static __inline int16x8_t
+Idct_Row(const int16x8_t x, const int16_t (* const T)[4], const int Rnd)
+{
+	const int16x4_t l = vget_low_s16(x);
+	const int16x4_t h = vget_high_s16(x);
+	int32x4_t a, b;
+	int16x4_t lo, hi;
+
+	a = vmlal_lane_s16(vdupq_n_s32(Rnd), vld1_s16(T[0]), l, 0);
+	a = vmlal_lane_s16(a, vld1_s16(T[2]), l, 2);
+	a = vmlal_lane_s16(a, vld1_s16(T[4]), h, 0);
+	a = vmlal_lane_s16(a, vld1_s16(T[6]), h, 2);
+	b = vmull_lane_s16(vld1_s16(T[1]), l, 1);
+	b = vmlal_lane_s16(b, vld1_s16(T[3]), l, 3);
+	b = vmlal_lane_s16(b, vld1_s16(T[5]), h, 1);
+	b = vmlal_lane_s16(b, vld1_s16(T[7]), h, 3);
+
+	lo = vmovn_s32(vshrq_n_s32(vaddq_s32(a, b), ROW_SHIFT));
+	hi = vrev64_s16(vmovn_s32(vshrq_n_s32(vsubq_s32(a, b), ROW_SHIFT)));
+	return vcombine_s16(lo, hi);
+}
+
+/* ((c * x) >> 16), product wrapping at 32 bits like the C version */
+#define MULT(c, x) vshrq_n_s32(vmulq_n_s32((x), (c)), 16)
+
+/* Idct_Col_8 of idct.c on four columns, In[i] = row i */
+static __inline void
+Idct_Col(int32x4_t * const In)
+{
+	int32x4_t mm0, mm1, mm2, mm3, mm4, mm5, mm6, mm7, t;
+
+	/* odd */
+	mm0 = vaddq_s32(MULT(Tan1, In[7]), In[1]);
+	mm1 = vsubq_s32(MULT(Tan1, In[1]), In[7]);
+	mm2 = vaddq_s32(MULT(Tan3, In[5]), In[3]);
+	mm3 = vsubq_s32(MULT(Tan3, In[3]), In[5]);
+
+	mm7 = vaddq_s32(mm0, mm2);
+	mm4 = vsubq_s32(mm1, mm3);
+	mm0 = vsubq_s32(mm0, mm2);
+	mm1 = vaddq_s32(mm1, mm3);
+	mm6 = vaddq_s32(mm0, mm1);
+	mm5 = vsubq_s32(mm0, mm1);
+	mm5 = vshlq_n_s32(MULT(Sqrt2, mm5), 1);
+	mm6 = vshlq_n_s32(MULT(Sqrt2, mm6), 1);
+
+	/* even */
+	mm3 = vaddq_s32(MULT(Tan2, In[6]), In[2]);
+	mm2 = vsubq_s32(MULT(Tan2, In[2]), In[6]);
+	mm0 = vaddq_s32(In[0], In[4]);
+	mm1 = vsubq_s32(In[0], In[4]);
+
+	t = vaddq_s32(mm0, mm3); mm3 = vsubq_s32(mm0, mm3); mm0 = t;
+	t = vaddq_s32(mm0, mm7); mm7 = vsubq_s32(mm0, mm7); mm0 = t;
+	In[0] = vshrq_n_s32(mm0, COL_SHIFT);
+	In[7] = vshrq_n_s32(mm7, COL_SHIFT);
+	t = vaddq_s32(mm3, mm4); mm4 = vsubq_s32(mm3, mm4); mm3 = t;
+	In[3] = vshrq_n_s32(mm3, COL_SHIFT);
+	In[4] = vshrq_n_s32(mm4, COL_SHIFT);
+
+	t = vaddq_s32(mm1, mm2); mm2 = vsubq_s32(mm1, mm2); mm1 = t;
+	t = vaddq_s32(mm1, mm6); mm6 = vsubq_s32(mm1, mm6); mm1 = t;
+	In[1] = vshrq_n_s32(mm1, COL_SHIFT);
+	In[6] = vshrq_n_s32(mm6, COL_SHIFT);
+	t = vaddq_s32(mm2, mm5); mm5 = vsubq_s32(mm2, mm5); mm2 = t;
+	In[2] = vshrq_n_s32(mm2, COL_SHIFT);
+	In[5] = vshrq_n_s32(mm5, COL_SHIFT);
+}
+
+void
+idct_neon_c(short *const block)
+{
+	int32x4_t Lo[8], Hi[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		const int16x8_t r = Idct_Row(vld1q_s16(block + 8*i),
+									 Row_Tab[Row_Map[i]], Row_Rnd[i]);
+		Lo[i] = vmovl_s16(vget_low_s16(r));
+		Hi[i] = vmovl_s16(vget_high_s16(r));
+	}
+
+	Idct_Col(Lo);
+	Idct_Col(Hi);
+
+	for (i = 0; i < 8; i++)
+		vst1q_s16(block + 8*i, vcombine_s16(vmovn_s32(Lo[i]), vmovn_s32(Hi[i])));
+}
+
+#endif /* ARCH_IS_NEON */
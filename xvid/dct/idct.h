@@ -55,4 +55,12 @@ idctFunc idct_ia64;
 idctFunc idct_altivec_c;
 #endif
 
+#ifdef ARCH_IS_SSE2
+idctFunc idct_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+idctFunc idct_neon_c;
+#endif
+
 #endif							/* _IDCT_H_ */
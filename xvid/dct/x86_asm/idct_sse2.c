@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - Inverse DCT, SSE2 intrinsics version of idct_int32 -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_SSE2)
+
+#include <emmintrin.h>
+#include "../idct.h"
+
+/* Same arithmetic as idct_int32() in idct.c, so the output is bit-identical:
+ * the row pass is exact in pmaddwd, the column pass keeps 32-bit
+ * intermediates (four columns per register) and both passes truncate to
+ * 16 bits on store. The zero-row shortcuts of the C version compute the
+ * same values, so they are simply not taken here. */
+
+#define ROW_TAB(C1,C2,C3,C4,C5,C6,C7) \
+  { { C4, C2,  C4, C6,  C4,-C6,  C4,-C2 }, \
+    { C4, C6, -C4,-C2, -C4, C2,  C4,-C6 }, \
+    { C1, C3,  C3,-C7,  C5,-C1,  C7,-C5 }, \
+    { C5, C7, -C1,-C5,  C7, C3,  C3,-C1 } }
+
+/* coefficients for (x0,x2) (x4,x6) (x1,x3) (x5,x7), giving a0..a3, b0..b3 */
+static const int16_t Row_Tab[4][4][8] = {
+	ROW_TAB(22725, 21407, 19266, 16384, 12873,  8867, 4520),	/* 0,4 */
+	ROW_TAB(31521, 29692, 26722, 22725, 17855, 12299, 6270),	/* 1,7 */
+	ROW_TAB(29692, 27969, 25172, 21407, 16819, 11585, 5906),	/* 2,6 */
+	ROW_TAB(26722, 25172, 22654, 19266, 15137, 10426, 5315)		/* 3,5 */
+};
+#undef ROW_TAB
+
+static const int Row_Map[8] = { 0, 1, 2, 3, 0, 3, 2, 1 };
+static const int Row_Rnd[8] = { 65536, 3597, 2260, 1203, 0, 120, 512, 512 };
+
+#define ROW_SHIFT 11
+#define COL_SHIFT 6
+
+#define Tan1  0x32ec
+#define Tan2  0x6a0a
+#define Tan3  0xab0e
+#define Sqrt2 0x5a82
+
+/* low 16 bits, sign extended: what a store to short keeps */
+static __inline __m128i
+trunc16(const __m128i x)
+{
+	return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+static __inline __m128i
+Idct_Row(const __m128i x, const int16_t (* const T)[8], const int Rnd)
+{
+	const __m128i y = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3,1,2,0)),
+										  _MM_SHUFFLE(3,1,2,0));
+	__m128i a, b, lo, hi;
+
+	a = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(y, 0x00), _mm_loadu_si128((const __m128i *)T[0])),
+					  _mm_madd_epi16(_mm_shuffle_epi32(y, 0xaa), _mm_loadu_si128((const __m128i *)T[1])));
+	a = _mm_add_epi32(a, _mm_set1_epi32(Rnd));
+	b = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi32(y, 0x55), _mm_loadu_si128((const __m128i *)T[2])),
+					  _mm_madd_epi16(_mm_shuffle_epi32(y, 0xff), _mm_loadu_si128((const __m128i *)T[3])));
+
+	lo = _mm_srai_epi32(_mm_add_epi32(a, b), ROW_SHIFT);
+	hi = _mm_srai_epi32(_mm_sub_epi32(a, b), ROW_SHIFT);
+	hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(0,1,2,3));
+	return _mm_packs_epi32(trunc16(lo), trunc16(hi));
+}
+
+/* ((c * x) >> 16) on 32-bit lanes; SSE2 has no 32-bit mullo */
+static __inline __m128i
+MULT(const int c, const __m128i x)
+{
+	const __m128i k = _mm_set1_epi32(c);
+	const __m128i e = _mm_mul_epu32(x, k);
+	const __m128i o = _mm_mul_epu32(_mm_srli_epi64(x, 32), k);
+	return _mm_srai_epi32(_mm_unpacklo_epi32(_mm_shuffle_epi32(e, _MM_SHUFFLE(0,0,2,0)),
+											 _mm_shuffle_epi32(o, _MM_SHUFFLE(0,0,2,0))), 16);
+}
+
+/* Idct_Col_8 of idct.c on four columns, In[i] = row i */
+static __inline void
+Idct_Col(__m128i * const In)
+{
+	__m128i mm0, mm1, mm2, mm3, mm4, mm5, mm6, mm7, t;
+
+	/* odd */
+	mm0 = _mm_add_epi32(MULT(Tan1, In[7]), In[1]);
+	mm1 = _mm_sub_epi32(MULT(Tan1, In[1]), In[7]);
+	mm2 = _mm_add_epi32(MULT(Tan3, In[5]), In[3]);
+	mm3 = _mm_sub_epi32(MULT(Tan3, In[3]), In[5]);
+
+	mm7 = _mm_add_epi32(mm0, mm2);
+	mm4 = _mm_sub_epi32(mm1, mm3);
+	mm0 = _mm_sub_epi32(mm0, mm2);
+	mm1 = _mm_add_epi32(mm1, mm3);
+	mm6 = _mm_add_epi32(mm0, mm1);
+	mm5 = _mm_sub_epi32(mm0, mm1);
+	mm5 = _mm_slli_epi32(MULT(Sqrt2, mm5), 1);
+	mm6 = _mm_slli_epi32(MULT(Sqrt2, mm6), 1);
+
+	/* even */
+	mm3 = _mm_add_epi32(MULT(Tan2, In[6]), In[2]);
+	mm2 = _mm_sub_epi32(MULT(Tan2, In[2]), In[6]);
+	mm0 = _mm_add_epi32(In[0], In[4]);
+	mm1 = _mm_sub_epi32(In[0], In[4]);
+
+	t = _mm_add_epi32(mm0, mm3); mm3 = _mm_sub_epi32(mm0, mm3); mm0 = t;
+	t = _mm_add_epi32(mm0, mm7); mm7 = _mm_sub_epi32(mm0, mm7); mm0 = t;
+	In[0] = _mm_srai_epi32(mm0, COL_SHIFT);
+	In[7] = _mm_srai_epi32(mm7, COL_SHIFT);
+	t = _mm_add_epi32(mm3, mm4); mm4 = _mm_sub_epi32(mm3, mm4); mm3 = t;
+	In[3] = _mm_srai_epi32(mm3, COL_SHIFT);
+	In[4] = _mm_srai_epi32(mm4, COL_SHIFT);
+
+	t = _mm_add_epi32(mm1, mm2); mm2 = _mm_sub_epi32(mm1, mm2); mm1 = t;
+	t = _mm_add_epi32(mm1, mm6); mm6 = _mm_sub_epi32(mm1, mm6); mm1 = t;
+	In[1] = _mm_srai_epi32(mm1, COL_SHIFT);
+	In[6] = _mm_srai_epi32(mm6, COL_SHIFT);
+	t = _mm_add_epi32(mm2, mm5); mm5 = _mm_sub_epi32(mm2, mm5); mm2 = t;
+	In[2] = _mm_srai_epi32(mm2, COL_SHIFT);
+	In[5] = _mm_srai_epi32(mm5, COL_SHIFT);
+}
+
+void
+idct_sse2_c(short *const block)
+{
+	__m128i Lo[8], Hi[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		const __m128i r = Idct_Row(_mm_loadu_si128((const __m128i *)(block + 8*i)),
+								   Row_Tab[Row_Map[i]], Row_Rnd[i]);
+		Lo[i] = _mm_srai_epi32(_mm_unpacklo_epi16(r, r), 16);
+		Hi[i] = _mm_srai_epi32(_mm_unpackhi_epi16(r, r), 16);
+	}
+
+	Idct_Col(Lo);
+	Idct_Col(Hi);
+
+	for (i = 0; i < 8; i++)
+		_mm_storeu_si128((__m128i *)(block + 8*i),
+						 _mm_packs_epi32(trunc16(Lo[i]), trunc16(Hi[i])));
+}
+
+#endif /* ARCH_IS_SSE2 */
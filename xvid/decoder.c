@@ -140,6 +140,7 @@ memory_error:
   image_destroy(&dec->refn[1], dec->edged_width, dec->edged_height);
   image_destroy(&dec->tmp, dec->edged_width, dec->edged_height);
   image_destroy(&dec->qtmp, dec->edged_width, dec->edged_height);
+  smp_pool_destroy(dec->smp);
 
   xvid_free(dec);
   return XVID_ERR_MEMORY;
@@ -174,6 +175,7 @@ decoder_create(xvid_dec_create_t * create)
   dec->height = MAX(0, create->height);
 
   dec->num_threads = MAX(0, create->num_threads);
+  dec->smp = smp_pool_create(dec->num_threads);
 
   image_null(&dec->cur);
   image_null(&dec->refn[0]);
@@ -233,6 +235,7 @@ decoder_destroy(DECODER * dec)
   image_destroy(&dec->qtmp, dec->edged_width, dec->edged_height);
   image_destroy(&dec->cur, dec->edged_width, dec->edged_height);
   xvid_free(dec->mpeg_quant_matrices);
+  smp_pool_destroy(dec->smp);
   xvid_free(dec);
 
   write_timer();
@@ -369,10 +372,6 @@ decoder_mb_decode(DECODER * dec,
       int direction,
       const int quant,
       const uint16_t *matrix);
-  typedef void (*add_residual_function_t)(
-      uint8_t *predicted_block,
-      const int16_t *residual,
-      int stride);
 
   const get_inter_block_function_t get_inter_block = (dec->quant_type == 0)
     ? (get_inter_block_function_t)get_inter_block_h263
@@ -517,13 +516,13 @@ decoder_mbinter(DECODER * dec,
     uv_dx = (uv_dx >> 1) + roundtab_79[uv_dx & 0x3];
     uv_dy = (uv_dy >> 1) + roundtab_79[uv_dy & 0x3];
 
-    if (dec->quarterpel)
+    if (dec->quarterpel && !dec->fast_mc)
       interpolate16x16_quarterpel(dec->cur.y, dec->refn[ref].y, dec->qtmp.y, dec->qtmp.y + 64,
                   dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
                       mv[0].x, mv[0].y, stride, rounding);
-    else
+    else /* fast mc: qpel vector rounded down to halfpel */
       interpolate16x16_switch(dec->cur.y, dec->refn[ref].y, 16*x_pos, 16*y_pos,
-                  mv[0].x, mv[0].y, stride, rounding);
+                  mv[0].x >> dec->quarterpel, mv[0].y >> dec->quarterpel, stride, rounding);
 
   } else {  /* MODE_INTER4V */
 
@@ -548,7 +547,7 @@ decoder_mbinter(DECODER * dec,
     uv_dx = (uv_dx >> 3) + roundtab_76[uv_dx & 0xf];
     uv_dy = (uv_dy >> 3) + roundtab_76[uv_dy & 0xf];
 
-    if (dec->quarterpel) {
+    if (dec->quarterpel && !dec->fast_mc) {
       interpolate8x8_quarterpel(dec->cur.y, dec->refn[0].y , dec->qtmp.y, dec->qtmp.y + 64,
                   dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
                   mv[0].x, mv[0].y, stride, rounding);
@@ -562,14 +561,15 @@ decoder_mbinter(DECODER * dec,
                   dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos + 8,
                   mv[3].x, mv[3].y, stride, rounding);
     } else {
+      const int qp = dec->quarterpel;
       interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos, 16*y_pos,
-                mv[0].x, mv[0].y, stride, rounding);
+                mv[0].x >> qp, mv[0].y >> qp, stride, rounding);
       interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos + 8, 16*y_pos,
-                mv[1].x, mv[1].y, stride, rounding);
+                mv[1].x >> qp, mv[1].y >> qp, stride, rounding);
       interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos, 16*y_pos + 8,
-                mv[2].x, mv[2].y, stride, rounding);
+                mv[2].x >> qp, mv[2].y >> qp, stride, rounding);
       interpolate8x8_switch(dec->cur.y, dec->refn[0].y , 16*x_pos + 8, 16*y_pos + 8,
-                mv[3].x, mv[3].y, stride, rounding);
+                mv[3].x >> qp, mv[3].y >> qp, stride, rounding);
     }
   }
 
@@ -697,6 +697,16 @@ decoder_mbgmc(DECODER * dec,
 
   NEW_GMC_DATA * gmc_data = &dec->new_gmc_data;
 
+  if (dec->fast_mc) {
+    /* fast mc: the macroblock's average warp as a plain translation */
+    gmc_data->get_average_mv(gmc_data, &pMB->amv, x_pos, y_pos, dec->quarterpel);
+    pMB->amv.x = gmc_sanitize(pMB->amv.x, dec->quarterpel, fcode);
+    pMB->amv.y = gmc_sanitize(pMB->amv.y, dec->quarterpel, fcode);
+    pMB->mvs[0] = pMB->mvs[1] = pMB->mvs[2] = pMB->mvs[3] = pMB->amv;
+    decoder_mbinter(dec, pMB, x_pos, y_pos, cbp, bs, rounding, 0, 0);
+    return;
+  }
+
   pMB->mvs[0] = pMB->mvs[1] = pMB->mvs[2] = pMB->mvs[3] = pMB->amv;
 
   start_timer();
@@ -1235,7 +1245,7 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
   }
 
   start_timer();
-  if(dec->quarterpel) {
+  if(dec->quarterpel && !dec->fast_mc) {
     if(!direct) {
       interpolate16x16_quarterpel(dec->cur.y, forward.y, dec->qtmp.y, dec->qtmp.y + 64,
                     dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
@@ -1254,15 +1264,16 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
                     dec->qtmp.y + 128, 16*x_pos + 8, 16*y_pos + 8,
                     pMB->mvs[3].x, pMB->mvs[3].y, stride, 0);
     }
-  } else {
+  } else { /* fast mc: qpel vectors rounded down to halfpel */
+    const int qp = dec->quarterpel;
     interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos, 16 * y_pos,
-              pMB->mvs[0].x, pMB->mvs[0].y, stride, 0);
+              pMB->mvs[0].x >> qp, pMB->mvs[0].y >> qp, stride, 0);
     interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos + 8, 16 * y_pos,
-              pMB->mvs[1].x, pMB->mvs[1].y, stride, 0);
+              pMB->mvs[1].x >> qp, pMB->mvs[1].y >> qp, stride, 0);
     interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos, 16 * y_pos + 8,
-              pMB->mvs[2].x, pMB->mvs[2].y, stride, 0);
+              pMB->mvs[2].x >> qp, pMB->mvs[2].y >> qp, stride, 0);
     interpolate8x8_switch(dec->cur.y, forward.y, 16 * x_pos + 8, 16 * y_pos + 8,
-              pMB->mvs[3].x, pMB->mvs[3].y, stride, 0);
+              pMB->mvs[3].x >> qp, pMB->mvs[3].y >> qp, stride, 0);
   }
 
   interpolate8x8_switch(dec->cur.u, forward.u, 8 * x_pos, 8 * y_pos, uv_dx,
@@ -1271,7 +1282,7 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
             uv_dy, stride2, 0);
 
 
-  if(dec->quarterpel) {
+  if(dec->quarterpel && !dec->fast_mc) {
     if(!direct) {
       interpolate16x16_add_quarterpel(dec->cur.y, backward.y, dec->qtmp.y, dec->qtmp.y + 64,
           dec->qtmp.y + 128, 16*x_pos, 16*y_pos,
@@ -1291,14 +1302,15 @@ decoder_bf_interpolate_mbinter(DECODER * dec,
           pMB->b_mvs[3].x, pMB->b_mvs[3].y, stride, 0);
     }
   } else {
+    const int qp = dec->quarterpel;
     interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos, 16 * y_pos,
-        pMB->b_mvs[0].x, pMB->b_mvs[0].y, stride, 0);
+        pMB->b_mvs[0].x >> qp, pMB->b_mvs[0].y >> qp, stride, 0);
     interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos + 8,
-        16 * y_pos, pMB->b_mvs[1].x, pMB->b_mvs[1].y, stride, 0);
+        16 * y_pos, pMB->b_mvs[1].x >> qp, pMB->b_mvs[1].y >> qp, stride, 0);
     interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos,
-        16 * y_pos + 8, pMB->b_mvs[2].x, pMB->b_mvs[2].y, stride, 0);
+        16 * y_pos + 8, pMB->b_mvs[2].x >> qp, pMB->b_mvs[2].y >> qp, stride, 0);
     interpolate8x8_add_switch(dec->cur.y, backward.y, 16 * x_pos + 8,
-        16 * y_pos + 8, pMB->b_mvs[3].x, pMB->b_mvs[3].y, stride, 0);
+        16 * y_pos + 8, pMB->b_mvs[3].x >> qp, pMB->b_mvs[3].y >> qp, stride, 0);
   }
 
   interpolate8x8_add_switch(dec->cur.u, backward.u, 8 * x_pos, 8 * y_pos,
@@ -1523,18 +1535,36 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
           int coding_type, int quant)
 {
   const int brightness = XVID_VERSION_MINOR(frame->version) >= 1 ? frame->brightness : 0;
+  int deblock_inplace;
+
+  /* preroll: the picture never leaves the decoder */
+  if (frame->general & XVID_DEC_PREROLL)
+    goto out_stats;
+
+  start_timer();
 
   if (dec->cartoon_mode)
     frame->general &= ~XVID_FILMEFFECT;
 
+  if (frame->general & XVID_DEC_FAST)
+    frame->general &= ~(XVID_DEBLOCKY|XVID_DEBLOCKUV|XVID_DERINGY|XVID_DERINGUV|XVID_FILMEFFECT);
+
+  /* deblocking only, to separate planes: filter the caller's output in
+     place instead of copying the whole reference frame to tmp first */
+  deblock_inplace = (frame->general & (XVID_DEBLOCKY|XVID_DEBLOCKUV))
+    && !(frame->general & XVID_FILMEFFECT) && brightness == 0
+    && mbs != NULL && !dec->interlacing
+    && frame->output.csp == XVID_CSP_PLANAR
+    && (frame->output.plane[0] != NULL) && (frame->output.stride[0] >= dec->width);
+
   if ((frame->general & (XVID_DEBLOCKY|XVID_DEBLOCKUV|XVID_FILMEFFECT) || brightness!=0)
-    && mbs != NULL) /* post process */
+    && mbs != NULL && !deblock_inplace) /* post process */
   {
     /* note: image is stored to tmp */
     image_copy(&dec->tmp, img, dec->edged_width, dec->height);
     image_postproc(&dec->postproc, &dec->tmp, dec->edged_width,
              mbs, dec->mb_width, dec->mb_height, dec->mb_width,
-             frame->general, brightness, dec->frames, (coding_type == B_VOP), dec->num_threads);
+             frame->general, brightness, dec->frames, (coding_type == B_VOP), dec->smp);
     img = &dec->tmp;
   }
 
@@ -1544,6 +1574,15 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
            frame->output.csp, dec->interlacing);
   }
 
+  if (deblock_inplace) {
+    image_deblock_planes(&dec->postproc, (uint8_t**)frame->output.plane, frame->output.stride,
+           dec->width, dec->height, mbs, dec->mb_width,
+           frame->general, frame->deblock_quant, dec->smp);
+  }
+
+  stop_conv_timer();
+
+out_stats:
   if (stats) {
     stats->type = coding2type(coding_type);
     stats->data.vop.time_base = (int)dec->time_base;
@@ -1559,8 +1598,8 @@ static void decoder_output(DECODER * dec, IMAGE * img, MACROBLOCK * mbs,
   }
 }
 
-int
-decoder_decode(DECODER * dec,
+static int
+decoder_decode_vops(DECODER * dec,
         xvid_dec_frame_t * frame, xvid_dec_stats_t * stats)
 {
 
@@ -1577,7 +1616,6 @@ decoder_decode(DECODER * dec,
   if (XVID_VERSION_MAJOR(frame->version) != 1 || (stats && XVID_VERSION_MAJOR(stats->version) != 1))  /* v1.x.x */
     return XVID_ERR_VERSION;
 
-  start_global_timer();
   memset((void *)&gmc_warp, 0, sizeof(WARPPOINTS));
 
   dec->low_delay_default = (frame->general & XVID_LOWDELAY);
@@ -1599,7 +1637,6 @@ decoder_decode(DECODER * dec,
     }
 
     emms();
-    stop_global_timer();
     return ret;
   }
 
@@ -1608,8 +1645,9 @@ decoder_decode(DECODER * dec,
   /* XXX: 0x7f is only valid whilst decoding vfw xvid/divx5 avi's */
   if(dec->low_delay_default && frame->length == 1 && BitstreamShowBits(&bs, 8) == 0x7f)
   {
-    image_output(&dec->refn[0], dec->width, dec->height, dec->edged_width,
-           (uint8_t**)frame->output.plane, frame->output.stride, frame->output.csp, dec->interlacing);
+    if (!(frame->general & XVID_DEC_PREROLL))
+      image_output(&dec->refn[0], dec->width, dec->height, dec->edged_width,
+             (uint8_t**)frame->output.plane, frame->output.stride, frame->output.csp, dec->interlacing);
     if (stats) stats->type = XVID_TYPE_NOTHING;
     emms();
     return 1; /* one byte consumed */
@@ -1672,6 +1710,7 @@ repeat:
   }
 
   dec->p_bmv.x = dec->p_bmv.y = dec->p_fmv.x = dec->p_fmv.y = 0;  /* init pred vector to 0 */
+  dec->vop_counts[coding_type]++;
 
   /* packed_mode: special-N_VOP treament */
   if (dec->packed_mode && coding_type == N_VOP) {
@@ -1681,6 +1720,8 @@ repeat:
     }
     /* ignore otherwise */
   } else if (coding_type != B_VOP) {
+    /* references: approximated MC drifts until the next I-VOP */
+    dec->fast_mc = !!(frame->general & XVID_DEC_FASTMC);
     switch(coding_type) {
     case I_VOP :
       decoder_iframe(dec, &bs, quant, intra_dc_threshold);
@@ -1741,7 +1782,11 @@ repeat:
       image_printf(&dec->cur, dec->edged_width, dec->height, 16, 16,
             "broken b-frame, tpp=%i tbp=%i", dec->time_pp, dec->time_bp);
       if (stats) stats->type = XVID_TYPE_NOTHING;
+    } else if (frame->general & (XVID_DEC_DROP|XVID_DEC_PREROLL)) {
+      /* not a reference: the header alone is enough to move on */
+      if (stats) stats->type = XVID_TYPE_NOTHING;
     } else {
+      dec->fast_mc = !!(frame->general & (XVID_DEC_FAST|XVID_DEC_FASTMC));
       decoder_bframe(dec, &bs, quant, fcode_forward, fcode_backward);
       decoder_output(dec, &dec->cur, dec->mbs, frame, stats, coding_type, quant);
     }
@@ -1777,14 +1822,51 @@ done :
     if (dec->packed_mode && seen_something) {
       decoder_output(dec, &dec->refn[0], dec->last_mbs, frame, stats, dec->last_coding_type, quant);
     } else {
-      image_clear(&dec->cur, dec->width, dec->height, dec->edged_width, 0, 128, 128);
-      decoder_output(dec, &dec->cur, NULL, frame, stats, P_VOP, quant);
+      if (!(frame->general & XVID_DEC_PREROLL)) {
+        image_clear(&dec->cur, dec->width, dec->height, dec->edged_width, 0, 128, 128);
+        decoder_output(dec, &dec->cur, NULL, frame, stats, P_VOP, quant);
+      }
       if (stats) stats->type = XVID_TYPE_NOTHING;
     }
   }
 
   emms();
-  stop_global_timer();
 
   return (BitstreamPos(&bs)+7)/8; /* number of bytes consumed */
 }
+
+int
+decoder_decode(DECODER * dec,
+        xvid_dec_frame_t * frame, xvid_dec_stats_t * stats)
+{
+  const int b_vops = dec->vop_counts[B_VOP];
+  int ret;
+
+  reset_timer();
+  start_global_timer();
+  ret = decoder_decode_vops(dec, frame, stats);
+  stop_global_timer();
+
+#if defined(_PROFILING_)
+  if (stats && XVID_VERSION_MAJOR(stats->version) == 1) {
+    stats->prof.overall = (unsigned int)tim.overall;
+    stats->prof.coding = (unsigned int)tim.coding;
+    stats->prof.prediction = (unsigned int)tim.prediction;
+    stats->prof.iquant = (unsigned int)tim.iquant;
+    stats->prof.idct = (unsigned int)tim.idct;
+    stats->prof.transfer = (unsigned int)tim.trans;
+    stats->prof.comp = (unsigned int)tim.comp;
+    stats->prof.edges = (unsigned int)tim.edges;
+    stats->prof.conv = (unsigned int)tim.conv;
+  }
+#endif
+  if (stats && XVID_VERSION_MAJOR(stats->version) == 1) {
+    memcpy(stats->prof.vops, dec->vop_counts, sizeof(stats->prof.vops));
+    /* the last reference is held back for B-frames unless the stream is
+       low_delay or packed pictures are being unpacked (low_delay_default) */
+    stats->delay = !dec->low_delay && !(dec->low_delay_default && dec->packed_mode);
+    stats->bvop = dec->vop_counts[B_VOP] != b_vops;
+  }
+
+  return ret;
+}
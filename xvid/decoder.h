@@ -165,6 +165,10 @@ typedef struct
 	int is_edged[2];
 
 	int num_threads;
+	SMP_POOL *smp;				/* workers for postprocessing, NULL if single-threaded */
+
+	int vop_counts[5];			/* VOPs decoded per coding type, for stats */
+	int fast_mc;				/* this VOP: halfpel luma MC for qpel, translational GMC */
 }
 DECODER;
 
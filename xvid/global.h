@@ -164,10 +164,32 @@ typedef struct
 }
 IMAGE;
 
+/* bitstream reader cache: a full register on 64-bit hosts, one word on
+ * 32-bit targets where 64-bit shifts are split into several instructions */
+#ifndef BS_CACHE_BITS
+#  if defined(ARCH_IS_64BIT) || defined(__LP64__) || defined(_WIN64)
+#    define BS_CACHE_BITS 64
+#  else
+#    define BS_CACHE_BITS 32
+#  endif
+#endif
+
+#if BS_CACHE_BITS == 64
+typedef uint64_t bs_cache_t;
+#else
+typedef uint32_t bs_cache_t;
+#endif
+
 typedef struct
 {
-	uint32_t bufa;
-	uint32_t bufb;
+	/* reader */
+	bs_cache_t cache;		/* upcoming bits, msb first */
+	int32_t bits;			/* number of valid bits in cache */
+	const uint8_t *rptr;	/* first byte not yet loaded into cache */
+	const uint8_t *head;
+	const uint8_t *end;
+
+	/* writer */
 	uint32_t buf;
 	uint32_t pos;
 	uint32_t *tail;
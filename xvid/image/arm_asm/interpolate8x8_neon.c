@@ -0,0 +1,225 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8x8 block-based halfpel interpolation, NEON intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_NEON)
+
+#include <arm_neon.h>
+#include "../interpolate8x8.h"
+
+/* One 8-pixel row per d register. vrhadd is (a + b + 1) >> 1 and vhadd
+ * is (a + b) >> 1, so the rounding control picks one of the two and every
+ * kernel stays bit-identical to its _c version. */
+
+static __inline uint8x8_t
+avg_rnd(const uint8x8_t a, const uint8x8_t b, const uint32_t rounding)
+{
+	return rounding ? vhadd_u8(a, b) : vrhadd_u8(a, b);
+}
+
+/* src[i] + src[i+1] of one row, 16 bit */
+static __inline uint16x8_t
+pair_sum(const uint8_t * const src)
+{
+	return vaddl_u8(vld1_u8(src), vld1_u8(src + 1));
+}
+
+/* (four-pixel sum + 2 - rounding) >> 2 */
+static __inline uint8x8_t
+hv_row(const uint16x8_t s0, const uint16x8_t s1, const uint32_t rounding)
+{
+	const uint16x8_t s = vaddq_u16(s0, s1);
+	return rounding ? vmovn_u16(vshrq_n_u16(vaddq_u16(s, vdupq_n_u16(1)), 2))
+	                : vrshrn_n_u16(s, 2);
+}
+
+static __inline void
+halfpel_h(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	for (; rows > 0; rows--) {
+		vst1_u8(dst, avg_rnd(vld1_u8(src), vld1_u8(src + 1), rounding));
+		src += stride;
+		dst += stride;
+	}
+}
+
+static __inline void
+halfpel_v(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	uint8x8_t a = vld1_u8(src);
+
+	for (; rows > 0; rows--) {
+		const uint8x8_t b = vld1_u8(src + stride);
+		vst1_u8(dst, avg_rnd(a, b, rounding));
+		a = b;
+		src += stride;
+		dst += stride;
+	}
+}
+
+static __inline void
+halfpel_hv(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		   const uint32_t rounding, int rows)
+{
+	uint16x8_t s0 = pair_sum(src);
+
+	for (; rows > 0; rows--) {
+		const uint16x8_t s1 = pair_sum(src + stride);
+		vst1_u8(dst, hv_row(s0, s1, rounding));
+		s0 = s1;
+		src += stride;
+		dst += stride;
+	}
+}
+
+/* dst = interpolate(src) */
+
+void
+interpolate8x8_halfpel_h_neon_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_v_neon_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_hv_neon_c(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x4_halfpel_h_neon_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_v_neon_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_hv_neon_c(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 4);
+}
+
+/* dst = (dst + interpolate(src) + 1)/2, except hv with rounding: no +1 */
+
+void
+interpolate8x8_halfpel_add_neon_c(uint8_t * const dst, const uint8_t * const src,
+								  const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		vst1_u8(d, vrhadd_u8(vld1_u8(d), vld1_u8(s)));
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_h_add_neon_c(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint8x8_t h = avg_rnd(vld1_u8(s), vld1_u8(s + 1), rounding);
+		vst1_u8(d, vrhadd_u8(vld1_u8(d), h));
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_v_add_neon_c(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint8x8_t v = avg_rnd(vld1_u8(s), vld1_u8(s + stride), rounding);
+		vst1_u8(d, vrhadd_u8(vld1_u8(d), v));
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_hv_add_neon_c(uint8_t * const dst, const uint8_t * const src,
+									 const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	uint16x8_t s0 = pair_sum(s);
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint16x8_t s1 = pair_sum(s + stride);
+		vst1_u8(d, avg_rnd(vld1_u8(d), hv_row(s0, s1, rounding), rounding));
+		s0 = s1;
+		d += stride;
+		s += stride;
+	}
+}
+
+/* (src1 + src2 + 1 - rounding)>>1 */
+
+void
+interpolate8x8_avg2_neon_c(uint8_t * dst, const uint8_t * src1, const uint8_t * src2,
+						   const uint32_t stride, const uint32_t rounding, const uint32_t height)
+{
+	uint32_t i;
+
+	for (i = 0; i < height; i++) {
+		vst1_u8(dst, avg_rnd(vld1_u8(src1), vld1_u8(src2), rounding));
+		dst += stride;
+		src1 += stride;
+		src2 += stride;
+	}
+}
+
+#endif /* ARCH_IS_NEON */
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - QPel interpolation, NEON intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_NEON)
+
+#include <arm_neon.h>
+#include "../qpel.h"
+
+/* Same scheme as qpel_sse2.c: the line is mirrored 3 deep at both ends
+ * into a 16-bit buffer, after which every output is the plain 8-tap sum
+ * (-1, 3, -6, 20, 20, -6, 3, -1). The sum stays inside 16 bits, so the
+ * results match the _c passes of qpel.c bit for bit. */
+
+/* (-1,3,-6,20,20,-6,3,-1) . e[0..7] + 16 - Rnd for 8 outputs, e[i] lane i */
+static __inline uint8x8_t
+fir8(const int16x8_t *e, const int16x8_t rnd16)
+{
+	int16x8_t c;
+
+	c = vmulq_n_s16(vaddq_s16(e[3], e[4]), 20);
+	c = vmlsq_n_s16(c, vaddq_s16(e[2], e[5]), 6);
+	c = vmlaq_n_s16(c, vaddq_s16(e[1], e[6]), 3);
+	c = vsubq_s16(c, vaddq_s16(e[0], e[7]));
+	return vqmovun_s16(vshrq_n_s16(vaddq_s16(c, rnd16), 5));
+}
+
+/* (a + b + 1 - rounding) >> 1 per byte */
+static __inline uint8x8_t
+avg_rnd(const uint8x8_t a, const uint8x8_t b, const int32_t Rnd)
+{
+	return Rnd ? vhadd_u8(a, b) : vrhadd_u8(a, b);
+}
+
+/* avrg: 0 = filter only, 1 = average with a[0], 2 = with a[1].
+ * add: average the result into d (B-frames). */
+static __inline uint8x8_t
+finish(uint8x8_t c, const uint8_t * const a, const uint8_t * const d,
+	   const int avrg, const int add, const int32_t Rnd)
+{
+	if (avrg)
+		c = avg_rnd(c, vld1_u8(a), Rnd);
+	if (add)
+		c = vrhadd_u8(c, vld1_u8(d));
+	return c;
+}
+
+static __inline void
+h_pass(uint8_t *Dst, const uint8_t *Src, int32_t H, const int32_t BpS, const int32_t Rnd,
+	   const int size, const int avrg, const int add)
+{
+	const int16x8_t rnd16 = vdupq_n_s16(16 - Rnd);
+	int16_t e[32];
+
+	while (H-- > 0) {
+		int16x8_t v[8];
+		int j, k;
+
+		/* e[3+k] = Src[k], k = 0..size, mirrored 3 deep at each end */
+		vst1q_s16(e + 3, vreinterpretq_s16_u16(vmovl_u8(vld1_u8(Src))));
+		if (size == 16)
+			vst1q_s16(e + 11, vreinterpretq_s16_u16(vmovl_u8(vld1_u8(Src + 8))));
+		e[0] = Src[2];
+		e[1] = Src[1];
+		e[2] = Src[0];
+		e[size + 3] = Src[size];
+		e[size + 4] = Src[size];
+		e[size + 5] = Src[size - 1];
+		e[size + 6] = Src[size - 2];
+
+		for (j = 0; j < size; j += 8) {
+			for (k = 0; k < 8; k++)
+				v[k] = vld1q_s16(e + j + k);
+			vst1_u8(Dst + j, finish(fir8(v, rnd16), Src + j + avrg - 1, Dst + j,
+									avrg, add, Rnd));
+		}
+		Src += BpS;
+		Dst += BpS;
+	}
+}
+
+/* eight columns at a time; W is 8 or 16 at every call site (qpel.h) */
+static __inline void
+v_pass(uint8_t *Dst, const uint8_t *Src, int32_t W, const int32_t BpS, const int32_t Rnd,
+	   const int size, const int avrg, const int add)
+{
+	const int16x8_t rnd16 = vdupq_n_s16(16 - Rnd);
+
+	for (; W > 0; W -= 8) {
+		int16x8_t r[16 + 7];
+		const uint8_t *S = Src;
+		uint8_t *D = Dst;
+		int i;
+
+		for (i = 0; i <= size; i++) {
+			r[3 + i] = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(S)));
+			S += BpS;
+		}
+		r[0] = r[5];
+		r[1] = r[4];
+		r[2] = r[3];
+		r[size + 4] = r[size + 3];
+		r[size + 5] = r[size + 2];
+		r[size + 6] = r[size + 1];
+
+		S = Src;
+		for (i = 0; i < size; i++) {
+			vst1_u8(D, finish(fir8(r + i, rnd16), S + (avrg - 1)*BpS, D, avrg, add, Rnd));
+			S += BpS;
+			D += BpS;
+		}
+		Src += 8;
+		Dst += 8;
+	}
+}
+
+#define H_PASS(NAME, SIZE, AVRG, ADD) \
+	XVID_QP_PASS_SIGNATURE(NAME) { h_pass(dst, src, length, BpS, rounding, SIZE, AVRG, ADD); }
+#define V_PASS(NAME, SIZE, AVRG, ADD) \
+	XVID_QP_PASS_SIGNATURE(NAME) { v_pass(dst, src, length, BpS, rounding, SIZE, AVRG, ADD); }
+
+H_PASS(H_Pass_16_NEON_C,              16, 0, 0)
+H_PASS(H_Pass_Avrg_16_NEON_C,         16, 1, 0)
+H_PASS(H_Pass_Avrg_Up_16_NEON_C,      16, 2, 0)
+V_PASS(V_Pass_16_NEON_C,              16, 0, 0)
+V_PASS(V_Pass_Avrg_16_NEON_C,         16, 1, 0)
+V_PASS(V_Pass_Avrg_Up_16_NEON_C,      16, 2, 0)
+
+H_PASS(H_Pass_8_NEON_C,               8, 0, 0)
+H_PASS(H_Pass_Avrg_8_NEON_C,          8, 1, 0)
+H_PASS(H_Pass_Avrg_Up_8_NEON_C,       8, 2, 0)
+V_PASS(V_Pass_8_NEON_C,               8, 0, 0)
+V_PASS(V_Pass_Avrg_8_NEON_C,          8, 1, 0)
+V_PASS(V_Pass_Avrg_Up_8_NEON_C,       8, 2, 0)
+
+H_PASS(H_Pass_16_Add_NEON_C,          16, 0, 1)
+H_PASS(H_Pass_Avrg_16_Add_NEON_C,     16, 1, 1)
+H_PASS(H_Pass_Avrg_Up_16_Add_NEON_C,  16, 2, 1)
+V_PASS(V_Pass_16_Add_NEON_C,          16, 0, 1)
+V_PASS(V_Pass_Avrg_16_Add_NEON_C,     16, 1, 1)
+V_PASS(V_Pass_Avrg_Up_16_Add_NEON_C,  16, 2, 1)
+
+H_PASS(H_Pass_8_Add_NEON_C,           8, 0, 1)
+H_PASS(H_Pass_Avrg_8_Add_NEON_C,      8, 1, 1)
+H_PASS(H_Pass_Avrg_Up_8_Add_NEON_C,   8, 2, 1)
+V_PASS(V_Pass_8_Add_NEON_C,           8, 0, 1)
+V_PASS(V_Pass_Avrg_8_Add_NEON_C,      8, 1, 1)
+V_PASS(V_Pass_Avrg_Up_8_Add_NEON_C,   8, 2, 1)
+
+#endif /* ARCH_IS_NEON */
@@ -188,6 +188,51 @@ INTERPOLATE8X8 interpolate8x8_halfpel_v_add_altivec_c;
 INTERPOLATE8X8 interpolate8x8_halfpel_hv_add_altivec_c;
 #endif
 
+#ifdef ARCH_IS_MIPS32
+INTERPOLATE8X8 interpolate8x8_halfpel_h_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_mips32;
+
+INTERPOLATE8X4 interpolate8x4_halfpel_h_mips32;
+INTERPOLATE8X4 interpolate8x4_halfpel_v_mips32;
+INTERPOLATE8X4 interpolate8x4_halfpel_hv_mips32;
+
+INTERPOLATE8X8 interpolate8x8_halfpel_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_h_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_add_mips32;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_add_mips32;
+#endif
+
+#ifdef ARCH_IS_SSE2
+INTERPOLATE8X8 interpolate8x8_halfpel_h_sse2_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_sse2_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_sse2_c;
+
+INTERPOLATE8X4 interpolate8x4_halfpel_h_sse2_c;
+INTERPOLATE8X4 interpolate8x4_halfpel_v_sse2_c;
+INTERPOLATE8X4 interpolate8x4_halfpel_hv_sse2_c;
+
+INTERPOLATE8X8 interpolate8x8_halfpel_add_sse2_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_h_add_sse2_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_add_sse2_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_add_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+INTERPOLATE8X8 interpolate8x8_halfpel_h_neon_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_neon_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_neon_c;
+
+INTERPOLATE8X4 interpolate8x4_halfpel_h_neon_c;
+INTERPOLATE8X4 interpolate8x4_halfpel_v_neon_c;
+INTERPOLATE8X4 interpolate8x4_halfpel_hv_neon_c;
+
+INTERPOLATE8X8 interpolate8x8_halfpel_add_neon_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_h_add_neon_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_v_add_neon_c;
+INTERPOLATE8X8 interpolate8x8_halfpel_hv_add_neon_c;
+#endif
+
 INTERPOLATE8X8_AVG2 interpolate8x8_avg2_c;
 INTERPOLATE8X8_AVG4 interpolate8x8_avg4_c;
 
@@ -201,6 +246,18 @@ INTERPOLATE8X8_AVG2 interpolate8x8_avg2_altivec_c;
 INTERPOLATE8X8_AVG4 interpolate8x8_avg4_altivec_c;
 #endif
 
+#ifdef ARCH_IS_MIPS32
+INTERPOLATE8X8_AVG2 interpolate8x8_avg2_mips32;
+#endif
+
+#ifdef ARCH_IS_SSE2
+INTERPOLATE8X8_AVG2 interpolate8x8_avg2_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+INTERPOLATE8X8_AVG2 interpolate8x8_avg2_neon_c;
+#endif
+
 INTERPOLATE_LOWPASS interpolate8x8_lowpass_h_c;
 INTERPOLATE_LOWPASS interpolate8x8_lowpass_v_c;
 
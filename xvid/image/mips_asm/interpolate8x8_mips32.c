@@ -0,0 +1,268 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8x8 block-based halfpel interpolation, MIPS32 word-at-a-time version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+#include "../../global.h"
+#include "../interpolate8x8.h"
+#include "../../utils/mips_asm/mips32.h"
+
+/* Every kernel works on 4 pixels per register with exact packed averages,
+ * so the results are bit-identical to the _c versions. */
+
+/* (a+b+c+d+2-rounding)>>2 on four lanes at once: the sum of the top six
+ * bits of each pixel cannot overflow a lane, the sum of the low two bits
+ * plus rounding cannot either; the horizontal pair sums (hi, lo) of one
+ * row are reused by the row below it */
+#define PAIR_HI(a, b) ((((a) >> 2) & 0x3f3f3f3fu) + (((b) >> 2) & 0x3f3f3f3fu))
+#define PAIR_LO(a, b) (((a) & 0x03030303u) + ((b) & 0x03030303u))
+#define HV4(hi0, lo0, hi1, lo1, rnd) \
+	((hi0) + (hi1) + ((((lo0) + (lo1) + (rnd)) >> 2) & 0x03030303u))
+
+static __inline void
+halfpel_h(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	for (; rows > 0; rows--) {
+		const uint32_t a0 = ld32(src), a1 = ld32(src + 1);
+		const uint32_t b0 = ld32(src + 4), b1 = ld32(src + 5);
+		if (rounding) {
+			st32(dst,     AVG4_DOWN(a0, a1));
+			st32(dst + 4, AVG4_DOWN(b0, b1));
+		} else {
+			st32(dst,     AVG4_UP(a0, a1));
+			st32(dst + 4, AVG4_UP(b0, b1));
+		}
+		src += stride;
+		dst += stride;
+	}
+}
+
+static __inline void
+halfpel_v(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	uint32_t a = ld32(src), b = ld32(src + 4);
+
+	for (; rows > 0; rows--) {
+		const uint32_t c = ld32(src + stride), d = ld32(src + stride + 4);
+		if (rounding) {
+			st32(dst,     AVG4_DOWN(a, c));
+			st32(dst + 4, AVG4_DOWN(b, d));
+		} else {
+			st32(dst,     AVG4_UP(a, c));
+			st32(dst + 4, AVG4_UP(b, d));
+		}
+		a = c;
+		b = d;
+		src += stride;
+		dst += stride;
+	}
+}
+
+static __inline void
+halfpel_hv(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		   const uint32_t rounding, int rows)
+{
+	const uint32_t rnd = rounding ? 0x01010101u : 0x02020202u;
+	uint32_t a0 = ld32(src), a1 = ld32(src + 1);
+	uint32_t b0 = ld32(src + 4), b1 = ld32(src + 5);
+	uint32_t ahi = PAIR_HI(a0, a1), alo = PAIR_LO(a0, a1);
+	uint32_t bhi = PAIR_HI(b0, b1), blo = PAIR_LO(b0, b1);
+
+	for (; rows > 0; rows--) {
+		uint32_t chi, clo, dhi, dlo;
+		src += stride;
+		a0 = ld32(src); a1 = ld32(src + 1);
+		b0 = ld32(src + 4); b1 = ld32(src + 5);
+		chi = PAIR_HI(a0, a1); clo = PAIR_LO(a0, a1);
+		dhi = PAIR_HI(b0, b1); dlo = PAIR_LO(b0, b1);
+		st32(dst,     HV4(ahi, alo, chi, clo, rnd));
+		st32(dst + 4, HV4(bhi, blo, dhi, dlo, rnd));
+		ahi = chi; alo = clo;
+		bhi = dhi; blo = dlo;
+		dst += stride;
+	}
+}
+
+/* dst = interpolate(src) */
+
+void
+interpolate8x8_halfpel_h_mips32(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_v_mips32(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_hv_mips32(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x4_halfpel_h_mips32(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_v_mips32(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_hv_mips32(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 4);
+}
+
+/* dst = (dst + interpolate(src) + 1)/2, except hv with rounding: no +1 */
+
+void
+interpolate8x8_halfpel_add_mips32(uint8_t * const dst, const uint8_t * const src,
+								  const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		st32(d,     AVG4_UP(ld32(d), ld32(s)));
+		st32(d + 4, AVG4_UP(ld32(d + 4), ld32(s + 4)));
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_h_add_mips32(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint32_t a0 = ld32(s), a1 = ld32(s + 1);
+		const uint32_t b0 = ld32(s + 4), b1 = ld32(s + 5);
+		const uint32_t a = rounding ? AVG4_DOWN(a0, a1) : AVG4_UP(a0, a1);
+		const uint32_t b = rounding ? AVG4_DOWN(b0, b1) : AVG4_UP(b0, b1);
+		st32(d,     AVG4_UP(ld32(d), a));
+		st32(d + 4, AVG4_UP(ld32(d + 4), b));
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_v_add_mips32(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	uint32_t a0 = ld32(s), b0 = ld32(s + 4);
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint32_t a1 = ld32(s + stride), b1 = ld32(s + stride + 4);
+		const uint32_t a = rounding ? AVG4_DOWN(a0, a1) : AVG4_UP(a0, a1);
+		const uint32_t b = rounding ? AVG4_DOWN(b0, b1) : AVG4_UP(b0, b1);
+		st32(d,     AVG4_UP(ld32(d), a));
+		st32(d + 4, AVG4_UP(ld32(d + 4), b));
+		a0 = a1;
+		b0 = b1;
+		d += stride;
+		s += stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_hv_add_mips32(uint8_t * const dst, const uint8_t * const src,
+									 const uint32_t stride, const uint32_t rounding)
+{
+	const uint32_t rnd = rounding ? 0x01010101u : 0x02020202u;
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	uint32_t a0 = ld32(s), a1 = ld32(s + 1);
+	uint32_t b0 = ld32(s + 4), b1 = ld32(s + 5);
+	uint32_t ahi = PAIR_HI(a0, a1), alo = PAIR_LO(a0, a1);
+	uint32_t bhi = PAIR_HI(b0, b1), blo = PAIR_LO(b0, b1);
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		uint32_t chi, clo, dhi, dlo, a, b;
+		s += stride;
+		a0 = ld32(s); a1 = ld32(s + 1);
+		b0 = ld32(s + 4); b1 = ld32(s + 5);
+		chi = PAIR_HI(a0, a1); clo = PAIR_LO(a0, a1);
+		dhi = PAIR_HI(b0, b1); dlo = PAIR_LO(b0, b1);
+		a = HV4(ahi, alo, chi, clo, rnd);
+		b = HV4(bhi, blo, dhi, dlo, rnd);
+		if (rounding) {
+			st32(d,     AVG4_DOWN(ld32(d), a));
+			st32(d + 4, AVG4_DOWN(ld32(d + 4), b));
+		} else {
+			st32(d,     AVG4_UP(ld32(d), a));
+			st32(d + 4, AVG4_UP(ld32(d + 4), b));
+		}
+		ahi = chi; alo = clo;
+		bhi = dhi; blo = dlo;
+		d += stride;
+	}
+}
+
+/* (src1 + src2 + 1 - rounding)>>1 */
+
+void
+interpolate8x8_avg2_mips32(uint8_t * dst, const uint8_t * src1, const uint8_t * src2,
+						   const uint32_t stride, const uint32_t rounding, const uint32_t height)
+{
+	uint32_t i;
+
+	for (i = 0; i < height; i++) {
+		const uint32_t a0 = ld32(src1), a1 = ld32(src2);
+		const uint32_t b0 = ld32(src1 + 4), b1 = ld32(src2 + 4);
+		if (rounding) {
+			st32(dst,     AVG4_DOWN(a0, a1));
+			st32(dst + 4, AVG4_DOWN(b0, b1));
+		} else {
+			st32(dst,     AVG4_UP(a0, a1));
+			st32(dst + 4, AVG4_UP(b0, b1));
+		}
+		dst += stride;
+		src1 += stride;
+		src2 += stride;
+	}
+}
@@ -47,6 +47,9 @@ IMAGEBRIGHTNESS_PTR image_brightness;
 #define FAST_ABS(x) ((((int)(x)) >> 31) ^ ((int)(x))) - (((int)(x)) >> 31)
 #define ABS(X)    (((X)>0)?(X):-(X)) 
 
+/* deblocking stripes per pass, at most */
+#define MAX_STRIPES 8
+
 void init_postproc(XVID_POSTPROC *tbls)
 {
 	init_deblock(tbls);
@@ -54,8 +57,9 @@ void init_postproc(XVID_POSTPROC *tbls)
 }
 
 void 
-stripe_deblock_h(SMPDeblock *h)
+stripe_deblock_h(void *arg)
 {
+	SMPDeblock *h = (SMPDeblock *) arg;
 	const int stride = h->stride;
 	const int stride2 = stride /2;
 
@@ -91,8 +95,9 @@ stripe_deblock_h(SMPDeblock *h)
 }
 
 void 
-stripe_deblock_v(SMPDeblock *h)
+stripe_deblock_v(void *arg)
 {
+	SMPDeblock *h = (SMPDeblock *) arg;
 	const int stride = h->stride;
 	const int stride2 = stride /2;
 
@@ -130,18 +135,13 @@ stripe_deblock_v(SMPDeblock *h)
 void
 image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 				const MACROBLOCK * mbs, int mb_width, int mb_height, int mb_stride,
-				int flags, int brightness, int frame_num, int bvop, int threads)
+				int flags, int brightness, int frame_num, int bvop, SMP_POOL *pool)
 {
 	int k;
-#ifndef HAVE_PTHREAD
-	int num_threads = 1;
-#else
-	int num_threads = MAX(1, MIN(threads, 4));
-	void *status = NULL;
-#endif
-	SMPDeblock data[4];
-
-	/* horizontal deblocking, dispatch threads */
+	int num_threads = MAX(1, MIN(MIN(smp_pool_threads(pool), MAX_STRIPES), mb_width));
+	SMPDeblock data[MAX_STRIPES];
+
+	/* horizontal deblocking, one stripe of columns per thread */
 	for (k = 0; k < num_threads; k++) {
 		data[k].flags = flags;
 		data[k].img = img;
@@ -155,44 +155,15 @@ image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 
 		data[k].stop_y = mb_height*2;
 	}
-#ifdef HAVE_PTHREAD
-	/* create threads */
-	for (k = 1; k < num_threads; k++) {
-		pthread_create(&data[k].handle, NULL, 
-		               (void*)stripe_deblock_h, (void*)&data[k]);
-	}
-#endif
-	stripe_deblock_h(&data[0]);
+	smp_pool_run(pool, stripe_deblock_h, data, sizeof(SMPDeblock), num_threads);
 
-#ifdef HAVE_PTHREAD
-	/* wait until all threads are finished */
-	for (k = 1; k < num_threads; k++) {
-		pthread_join(data[k].handle, &status);
-	}
-#endif
-
-	/* vertical deblocking, dispatch threads */
+	/* vertical deblocking, one stripe of rows per thread */
 	for (k = 0; k < num_threads; k++) {
 		data[k].start_y = (k*mb_height / num_threads)*2;
 		data[k].stop_y = ((k+1)*mb_height / num_threads)*2;
 		data[k].stop_x = mb_width*2;
 	}
-
-#ifdef HAVE_PTHREAD
-	/* create threads */
-	for (k = 1; k < num_threads; k++) {
-		pthread_create(&data[k].handle, NULL, 
-		               (void*)stripe_deblock_v, (void*)&data[k]);
-	}
-#endif
-	stripe_deblock_v(&data[0]);
-
-#ifdef HAVE_PTHREAD
-	/* wait until all threads are finished */
-	for (k = 1; k < num_threads; k++) {
-		pthread_join(data[k].handle, &status);
-	}
-#endif
+	smp_pool_run(pool, stripe_deblock_v, data, sizeof(SMPDeblock), num_threads);
 
 	if (!bvop)
 		tbls->prev_quant = mbs->quant;
@@ -208,6 +179,116 @@ image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 	}
 }
 
+/* Horizontal edges of a stripe of block columns: deblock8x8_h only
+ * touches the 8 columns of its block, so stripes side by side are
+ * independent */
+static void
+stripe_planes_h(void *arg)
+{
+	SMPDeblockPlanes *h = (SMPDeblockPlanes *) arg;
+	int i, j, quant;
+
+	if ((h->flags & XVID_DEBLOCKY)) {
+		int dering = h->flags & XVID_DERINGY;
+
+		for (j = 1; j < h->bh; j++)
+		for (i = h->start_x; i < h->stop_x; i++) {
+			quant = h->mbs[(j/2)*h->mb_stride + (i/2)].quant;
+			if (quant > h->min_quant)
+				deblock8x8_h(h->tbls, h->plane[0] + j*8*h->stride[0] + i*8, h->stride[0], quant, dering);
+		}
+	}
+
+	if ((h->flags & XVID_DEBLOCKUV)) {
+		int dering = h->flags & XVID_DERINGUV;
+
+		for (j = 1; j < h->bh/2; j++)
+		for (i = h->start_x/2; i < h->stop_x/2; i++) {
+			quant = h->mbs[j*h->mb_stride + i].quant;
+			if (quant > h->min_quant) {
+				deblock8x8_h(h->tbls, h->plane[1] + j*8*h->stride[1] + i*8, h->stride[1], quant, dering);
+				deblock8x8_h(h->tbls, h->plane[2] + j*8*h->stride[2] + i*8, h->stride[2], quant, dering);
+			}
+		}
+	}
+}
+
+/* Vertical edges of a stripe of block rows, likewise independent */
+static void
+stripe_planes_v(void *arg)
+{
+	SMPDeblockPlanes *h = (SMPDeblockPlanes *) arg;
+	int i, j, quant;
+
+	if ((h->flags & XVID_DEBLOCKY)) {
+		int dering = h->flags & XVID_DERINGY;
+
+		for (j = h->start_y; j < h->stop_y; j++)
+		for (i = 1; i < h->bw; i++) {
+			quant = h->mbs[(j/2)*h->mb_stride + (i/2)].quant;
+			if (quant > h->min_quant)
+				deblock8x8_v(h->tbls, h->plane[0] + j*8*h->stride[0] + i*8, h->stride[0], quant, dering);
+		}
+	}
+
+	if ((h->flags & XVID_DEBLOCKUV)) {
+		int dering = h->flags & XVID_DERINGUV;
+
+		for (j = h->start_y/2; j < h->stop_y/2; j++)
+		for (i = 1; i < h->bw/2; i++) {
+			quant = h->mbs[j*h->mb_stride + i].quant;
+			if (quant > h->min_quant) {
+				deblock8x8_v(h->tbls, h->plane[1] + j*8*h->stride[1] + i*8, h->stride[1], quant, dering);
+				deblock8x8_v(h->tbls, h->plane[2] + j*8*h->stride[2] + i*8, h->stride[2], quant, dering);
+			}
+		}
+	}
+}
+
+/* Deblock an already output 4:2:0 planar image in place.
+ * Unlike image_postproc this works on the caller's planes (which may be
+ * cropped to width x height and have arbitrary strides), so the reference
+ * frame never has to be copied. Edges of macroblocks whose quant is at or
+ * below min_quant are left alone - fine quantizers don't block.
+ * Each pass is split into macroblock aligned stripes over the pool; the
+ * result is the same as filtering in one go. */
+void
+image_deblock_planes(XVID_POSTPROC *tbls, uint8_t *plane[3], const int stride[3],
+				int width, int height, const MACROBLOCK * mbs, int mb_stride,
+				int flags, int min_quant, SMP_POOL *pool)
+{
+	/* whole 8x8 luma blocks inside the output; chroma has half of each */
+	const int bw = width / 8, bh = height / 8;
+	const int mb_w = (bw + 1) / 2, mb_h = (bh + 1) / 2;
+	const int num_threads = MAX(1, MIN(smp_pool_threads(pool), MAX_STRIPES));
+	SMPDeblockPlanes data[MAX_STRIPES];
+	int k;
+
+	if (!(flags & (XVID_DEBLOCKY|XVID_DEBLOCKUV)) || bw == 0 || bh == 0)
+		return;
+
+	for (k = 0; k < num_threads; k++) {
+		data[k].tbls = tbls;
+		data[k].plane = plane;
+		data[k].stride = stride;
+		data[k].mbs = mbs;
+		data[k].bw = bw;
+		data[k].bh = bh;
+		data[k].mb_stride = mb_stride;
+		data[k].flags = flags;
+		data[k].min_quant = min_quant;
+
+		data[k].start_x = (k*mb_w / num_threads)*2;
+		data[k].stop_x = MIN(((k+1)*mb_w / num_threads)*2, bw);
+		data[k].start_y = (k*mb_h / num_threads)*2;
+		data[k].stop_y = MIN(((k+1)*mb_h / num_threads)*2, bh);
+	}
+
+	/* all horizontal edges first, then all vertical ones */
+	smp_pool_run(pool, stripe_planes_h, data, sizeof(SMPDeblockPlanes), num_threads);
+	smp_pool_run(pool, stripe_planes_v, data, sizeof(SMPDeblockPlanes), num_threads);
+}
+
 /******************************************************************************/
 
 void init_deblock(XVID_POSTPROC *tbls)
@@ -28,6 +28,7 @@
 
 #include <stdlib.h>
 #include "../portab.h"
+#include "../utils/smp_pool.h"
 
 /* Filtering thresholds */
 
@@ -51,8 +52,6 @@ typedef struct {
 
 typedef struct
 {
-	pthread_t handle;		/* thread's handle */
-
 	XVID_POSTPROC *tbls;
 	IMAGE * img;
 	const MACROBLOCK * mbs;
@@ -66,10 +65,34 @@ typedef struct
 	int flags;
 } SMPDeblock;
 
+/* one stripe of image_deblock_planes, bounds in 8x8 luma blocks */
+typedef struct
+{
+	XVID_POSTPROC *tbls;
+	uint8_t **plane;
+	const int *stride;
+	const MACROBLOCK * mbs;
+
+	int bw;					/* whole luma blocks across */
+	int bh;					/* and down */
+	int start_x;
+	int stop_x;
+	int start_y;
+	int stop_y;
+	int mb_stride;
+	int flags;
+	int min_quant;
+} SMPDeblockPlanes;
+
 void
 image_postproc(XVID_POSTPROC *tbls, IMAGE * img, int edged_width,
 				const MACROBLOCK * mbs, int mb_width, int mb_height, int mb_stride,
-				int flags, int brightness, int frame_num, int bvop, int threads);
+				int flags, int brightness, int frame_num, int bvop, SMP_POOL *pool);
+
+void
+image_deblock_planes(XVID_POSTPROC *tbls, uint8_t *plane[3], const int stride[3],
+				int width, int height, const MACROBLOCK * mbs, int mb_stride,
+				int flags, int min_quant, SMP_POOL *pool);
 
 void deblock8x8_h(XVID_POSTPROC *tbls, uint8_t *img, int stride, int quant, int dering);
 void deblock8x8_v(XVID_POSTPROC *tbls, uint8_t *img, int stride, int quant, int dering);
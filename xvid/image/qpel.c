@@ -342,6 +342,106 @@ XVID_QP_FUNCS xvid_QP_Add_Funcs_Altivec_C = {
 
 #endif /* ARCH_IS_PPC */
 
+/* SSE2 intrinsics impl. declaration (see x86_asm/qpel_sse2.c)
+ ****************************************************************************/
+
+#ifdef ARCH_IS_SSE2
+extern XVID_QP_PASS_SIGNATURE(H_Pass_16_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_16_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_16_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_16_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_16_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_16_SSE2_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_8_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_8_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_8_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_8_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_8_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_8_SSE2_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_16_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_16_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_16_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_16_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_16_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_16_Add_SSE2_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_8_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_8_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_8_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_8_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_8_Add_SSE2_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_8_Add_SSE2_C);
+
+XVID_QP_FUNCS xvid_QP_Funcs_SSE2_C = {
+	H_Pass_16_SSE2_C, H_Pass_Avrg_16_SSE2_C, H_Pass_Avrg_Up_16_SSE2_C,
+	V_Pass_16_SSE2_C, V_Pass_Avrg_16_SSE2_C, V_Pass_Avrg_Up_16_SSE2_C,
+
+	H_Pass_8_SSE2_C, H_Pass_Avrg_8_SSE2_C, H_Pass_Avrg_Up_8_SSE2_C,
+	V_Pass_8_SSE2_C, V_Pass_Avrg_8_SSE2_C, V_Pass_Avrg_Up_8_SSE2_C
+};
+
+XVID_QP_FUNCS xvid_QP_Add_Funcs_SSE2_C = {
+	H_Pass_16_Add_SSE2_C, H_Pass_Avrg_16_Add_SSE2_C, H_Pass_Avrg_Up_16_Add_SSE2_C,
+	V_Pass_16_Add_SSE2_C, V_Pass_Avrg_16_Add_SSE2_C, V_Pass_Avrg_Up_16_Add_SSE2_C,
+
+	H_Pass_8_Add_SSE2_C, H_Pass_Avrg_8_Add_SSE2_C, H_Pass_Avrg_Up_8_Add_SSE2_C,
+	V_Pass_8_Add_SSE2_C, V_Pass_Avrg_8_Add_SSE2_C, V_Pass_Avrg_Up_8_Add_SSE2_C
+};
+
+#endif /* ARCH_IS_SSE2 */
+
+/* NEON intrinsics impl. declaration (see arm_asm/qpel_neon.c)
+ ****************************************************************************/
+
+#ifdef ARCH_IS_NEON
+extern XVID_QP_PASS_SIGNATURE(H_Pass_16_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_16_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_16_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_16_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_16_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_16_NEON_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_8_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_8_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_8_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_8_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_8_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_8_NEON_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_16_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_16_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_16_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_16_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_16_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_16_Add_NEON_C);
+
+extern XVID_QP_PASS_SIGNATURE(H_Pass_8_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_8_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(H_Pass_Avrg_Up_8_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_8_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_8_Add_NEON_C);
+extern XVID_QP_PASS_SIGNATURE(V_Pass_Avrg_Up_8_Add_NEON_C);
+
+XVID_QP_FUNCS xvid_QP_Funcs_NEON_C = {
+	H_Pass_16_NEON_C, H_Pass_Avrg_16_NEON_C, H_Pass_Avrg_Up_16_NEON_C,
+	V_Pass_16_NEON_C, V_Pass_Avrg_16_NEON_C, V_Pass_Avrg_Up_16_NEON_C,
+
+	H_Pass_8_NEON_C, H_Pass_Avrg_8_NEON_C, H_Pass_Avrg_Up_8_NEON_C,
+	V_Pass_8_NEON_C, V_Pass_Avrg_8_NEON_C, V_Pass_Avrg_Up_8_NEON_C
+};
+
+XVID_QP_FUNCS xvid_QP_Add_Funcs_NEON_C = {
+	H_Pass_16_Add_NEON_C, H_Pass_Avrg_16_Add_NEON_C, H_Pass_Avrg_Up_16_Add_NEON_C,
+	V_Pass_16_Add_NEON_C, V_Pass_Avrg_16_Add_NEON_C, V_Pass_Avrg_Up_16_Add_NEON_C,
+
+	H_Pass_8_Add_NEON_C, H_Pass_Avrg_8_Add_NEON_C, H_Pass_Avrg_Up_8_Add_NEON_C,
+	V_Pass_8_Add_NEON_C, V_Pass_Avrg_8_Add_NEON_C, V_Pass_Avrg_Up_8_Add_NEON_C
+};
+
+#endif /* ARCH_IS_NEON */
+
 /* tables for ASM
  ****************************************************************************/
 
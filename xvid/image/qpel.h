@@ -83,6 +83,16 @@ extern XVID_QP_FUNCS xvid_QP_Funcs_Altivec_C;
 extern XVID_QP_FUNCS xvid_QP_Add_Funcs_Altivec_C;
 #endif
 
+#ifdef ARCH_IS_SSE2
+extern XVID_QP_FUNCS xvid_QP_Funcs_SSE2_C;
+extern XVID_QP_FUNCS xvid_QP_Add_Funcs_SSE2_C;
+#endif
+
+#ifdef ARCH_IS_NEON
+extern XVID_QP_FUNCS xvid_QP_Funcs_NEON_C;
+extern XVID_QP_FUNCS xvid_QP_Add_Funcs_NEON_C;
+#endif
+
 extern XVID_QP_FUNCS *xvid_QP_Funcs;      /* <- main pointer for enc/dec structure */
 extern XVID_QP_FUNCS *xvid_QP_Add_Funcs;  /* <- main pointer for enc/dec structure */
 
@@ -0,0 +1,250 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8x8 block-based halfpel interpolation, SSE2 intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_SSE2)
+
+#include <emmintrin.h>
+#include "../interpolate8x8.h"
+
+/* Two 8-pixel rows per register. pavgb rounds up; the rounding=1 average
+ * takes the lost low bit back off, so every kernel is bit-identical to
+ * its _c version. */
+
+#define LOAD8(p)     _mm_loadl_epi64((const __m128i *)(p))
+#define STORE8(p, v) _mm_storel_epi64((__m128i *)(p), (v))
+#define LOAD2(p, s)  _mm_unpacklo_epi64(LOAD8(p), LOAD8((p) + (s)))
+#define STORE2(p, s, v) \
+	do { STORE8(p, v); STORE8((p) + (s), _mm_srli_si128(v, 8)); } while (0)
+
+/* (a + b + 1 - rounding) >> 1, rnd = rounding ? 0x01.. : 0 */
+static __inline __m128i
+avg_rnd(const __m128i a, const __m128i b, const __m128i rnd)
+{
+	return _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), rnd));
+}
+
+static __inline __m128i
+rnd_mask(const uint32_t rounding)
+{
+	return rounding ? _mm_set1_epi8(1) : _mm_setzero_si128();
+}
+
+/* src[i] + src[i+1] of one row, 16 bit */
+static __inline __m128i
+pair_sum(const uint8_t * const src)
+{
+	const __m128i zero = _mm_setzero_si128();
+	return _mm_add_epi16(_mm_unpacklo_epi8(LOAD8(src), zero),
+						 _mm_unpacklo_epi8(LOAD8(src + 1), zero));
+}
+
+/* (four-pixel sum + 2 - rounding) >> 2 for rows j and j+1 */
+static __inline __m128i
+hv_rows(const __m128i s0, const __m128i s1, const __m128i s2, const __m128i r)
+{
+	const __m128i a = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s0, s1), r), 2);
+	const __m128i b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s1, s2), r), 2);
+	return _mm_packus_epi16(a, b);
+}
+
+static __inline void
+halfpel_h(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	const __m128i rnd = rnd_mask(rounding);
+
+	for (; rows > 0; rows -= 2) {
+		STORE2(dst, stride, avg_rnd(LOAD2(src, stride), LOAD2(src + 1, stride), rnd));
+		src += 2*stride;
+		dst += 2*stride;
+	}
+}
+
+static __inline void
+halfpel_v(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		  const uint32_t rounding, int rows)
+{
+	const __m128i rnd = rnd_mask(rounding);
+
+	for (; rows > 0; rows -= 2) {
+		STORE2(dst, stride, avg_rnd(LOAD2(src, stride), LOAD2(src + stride, stride), rnd));
+		src += 2*stride;
+		dst += 2*stride;
+	}
+}
+
+static __inline void
+halfpel_hv(uint8_t * dst, const uint8_t * src, const uint32_t stride,
+		   const uint32_t rounding, int rows)
+{
+	const __m128i r = _mm_set1_epi16(2 - rounding);
+	__m128i s0 = pair_sum(src);
+
+	for (; rows > 0; rows -= 2) {
+		const __m128i s1 = pair_sum(src + stride);
+		const __m128i s2 = pair_sum(src + 2*stride);
+		STORE2(dst, stride, hv_rows(s0, s1, s2, r));
+		s0 = s2;
+		src += 2*stride;
+		dst += 2*stride;
+	}
+}
+
+/* dst = interpolate(src) */
+
+void
+interpolate8x8_halfpel_h_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_v_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x8_halfpel_hv_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 8);
+}
+
+void
+interpolate8x4_halfpel_h_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_h(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_v_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_v(dst, src, stride, rounding, 4);
+}
+
+void
+interpolate8x4_halfpel_hv_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								 const uint32_t stride, const uint32_t rounding)
+{
+	halfpel_hv(dst, src, stride, rounding, 4);
+}
+
+/* dst = (dst + interpolate(src) + 1)/2, except hv with rounding: no +1 */
+
+void
+interpolate8x8_halfpel_add_sse2_c(uint8_t * const dst, const uint8_t * const src,
+								  const uint32_t stride, const uint32_t rounding)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		STORE2(d, stride, _mm_avg_epu8(LOAD2(d, stride), LOAD2(s, stride)));
+		d += 2*stride;
+		s += 2*stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_h_add_sse2_c(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	const __m128i rnd = rnd_mask(rounding);
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		const __m128i h = avg_rnd(LOAD2(s, stride), LOAD2(s + 1, stride), rnd);
+		STORE2(d, stride, _mm_avg_epu8(LOAD2(d, stride), h));
+		d += 2*stride;
+		s += 2*stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_v_add_sse2_c(uint8_t * const dst, const uint8_t * const src,
+									const uint32_t stride, const uint32_t rounding)
+{
+	const __m128i rnd = rnd_mask(rounding);
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		const __m128i v = avg_rnd(LOAD2(s, stride), LOAD2(s + stride, stride), rnd);
+		STORE2(d, stride, _mm_avg_epu8(LOAD2(d, stride), v));
+		d += 2*stride;
+		s += 2*stride;
+	}
+}
+
+void
+interpolate8x8_halfpel_hv_add_sse2_c(uint8_t * const dst, const uint8_t * const src,
+									 const uint32_t stride, const uint32_t rounding)
+{
+	const __m128i rnd = rnd_mask(rounding);
+	const __m128i r = _mm_set1_epi16(2 - rounding);
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	__m128i s0 = pair_sum(s);
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		const __m128i s1 = pair_sum(s + stride);
+		const __m128i s2 = pair_sum(s + 2*stride);
+		STORE2(d, stride, avg_rnd(LOAD2(d, stride), hv_rows(s0, s1, s2, r), rnd));
+		s0 = s2;
+		d += 2*stride;
+		s += 2*stride;
+	}
+}
+
+/* (src1 + src2 + 1 - rounding)>>1 */
+
+void
+interpolate8x8_avg2_sse2_c(uint8_t * dst, const uint8_t * src1, const uint8_t * src2,
+						   const uint32_t stride, const uint32_t rounding, const uint32_t height)
+{
+	const __m128i rnd = rnd_mask(rounding);
+	uint32_t i;
+
+	for (i = 0; i + 2 <= height; i += 2) {
+		STORE2(dst, stride, avg_rnd(LOAD2(src1, stride), LOAD2(src2, stride), rnd));
+		dst += 2*stride;
+		src1 += 2*stride;
+		src2 += 2*stride;
+	}
+	if (i < height)
+		STORE8(dst, avg_rnd(LOAD8(src1), LOAD8(src2), rnd));
+}
+
+#endif /* ARCH_IS_SSE2 */
@@ -0,0 +1,211 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - QPel interpolation, SSE2 intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_SSE2)
+
+#include <emmintrin.h>
+#include "../qpel.h"
+
+/* The FIR_Tab_8/16 filters of qpel.c are the 8-tap MPEG-4 filter
+ * (-1, 3, -6, 20, 20, -6, 3, -1) over a line mirrored at both ends:
+ * s[-1..-3] = s[0..2] and s[N+1..N+3] = s[N..N-2]. Mirrored into a
+ * 16-bit buffer, every output is the same 8-tap sum, which never leaves
+ * -3570..11746, so 16-bit lanes are exact and the results match the _c
+ * passes bit for bit. */
+
+/* (-1,3,-6,20,20,-6,3,-1) . e[0..7] + 16 - Rnd for 8 outputs, e[i] lane i */
+static __inline __m128i
+fir8(const __m128i *e, const __m128i rnd16)
+{
+	const __m128i t20 = _mm_add_epi16(e[3], e[4]);
+	const __m128i t6  = _mm_add_epi16(e[2], e[5]);
+	const __m128i t3  = _mm_add_epi16(e[1], e[6]);
+	const __m128i t1  = _mm_add_epi16(e[0], e[7]);
+	__m128i c;
+
+	c = _mm_mullo_epi16(t20, _mm_set1_epi16(20));
+	c = _mm_sub_epi16(c, _mm_mullo_epi16(t6, _mm_set1_epi16(6)));
+	c = _mm_add_epi16(c, _mm_mullo_epi16(t3, _mm_set1_epi16(3)));
+	c = _mm_sub_epi16(c, t1);
+	return _mm_srai_epi16(_mm_add_epi16(c, rnd16), 5);
+}
+
+/* (a + b + 1 - rounding) >> 1 per byte, rnd = rounding ? 0x01.. : 0 */
+static __inline __m128i
+avg_rnd(const __m128i a, const __m128i b, const __m128i rnd)
+{
+	return _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), rnd));
+}
+
+/* avrg: 0 = filter only, 1 = average with s[i], 2 = with s[i+1].
+ * add: average the result into dst (B-frames). */
+static __inline __m128i
+finish(__m128i c, const uint8_t * const s, uint8_t * const d, const int size,
+	   const int avrg, const int add, const __m128i rnd)
+{
+	if (avrg) {
+		const uint8_t * const a = s + avrg - 1;
+		c = avg_rnd(c, size == 16 ? _mm_loadu_si128((const __m128i *)a)
+								  : _mm_loadl_epi64((const __m128i *)a), rnd);
+	}
+	if (add)
+		c = _mm_avg_epu8(c, size == 16 ? _mm_loadu_si128((const __m128i *)d)
+									   : _mm_loadl_epi64((const __m128i *)d));
+	return c;
+}
+
+static __inline void
+store(uint8_t * const d, const __m128i c, const int size)
+{
+	if (size == 16)
+		_mm_storeu_si128((__m128i *)d, c);
+	else
+		_mm_storel_epi64((__m128i *)d, c);
+}
+
+static __inline void
+h_pass(uint8_t *Dst, const uint8_t *Src, int32_t H, const int32_t BpS, const int32_t Rnd,
+	   const int size, const int avrg, const int add)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rnd16 = _mm_set1_epi16(16 - Rnd);
+	const __m128i rnd = Rnd ? _mm_set1_epi8(1) : zero;
+	int16_t e[32];
+
+	while (H-- > 0) {
+		__m128i v[8], lo, hi;
+		int k;
+
+		/* e[3+k] = Src[k], k = 0..size, mirrored 3 deep at each end */
+		if (size == 16) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)Src);
+			_mm_storeu_si128((__m128i *)(e + 3), _mm_unpacklo_epi8(s, zero));
+			_mm_storeu_si128((__m128i *)(e + 11), _mm_unpackhi_epi8(s, zero));
+		} else {
+			_mm_storeu_si128((__m128i *)(e + 3),
+							 _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)Src), zero));
+		}
+		e[0] = Src[2];
+		e[1] = Src[1];
+		e[2] = Src[0];
+		e[size + 3] = Src[size];
+		e[size + 4] = Src[size];
+		e[size + 5] = Src[size - 1];
+		e[size + 6] = Src[size - 2];
+
+		for (k = 0; k < 8; k++)
+			v[k] = _mm_loadu_si128((const __m128i *)(e + k));
+		lo = fir8(v, rnd16);
+		if (size == 16) {
+			for (k = 0; k < 8; k++)
+				v[k] = _mm_loadu_si128((const __m128i *)(e + 8 + k));
+			hi = fir8(v, rnd16);
+		} else {
+			hi = lo;
+		}
+
+		store(Dst, finish(_mm_packus_epi16(lo, hi), Src, Dst, size, avrg, add, rnd), size);
+		Src += BpS;
+		Dst += BpS;
+	}
+}
+
+/* eight columns at a time; W is 8 or 16 at every call site (qpel.h) */
+static __inline void
+v_pass(uint8_t *Dst, const uint8_t *Src, int32_t W, const int32_t BpS, const int32_t Rnd,
+	   const int size, const int avrg, const int add)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rnd16 = _mm_set1_epi16(16 - Rnd);
+	const __m128i rnd = Rnd ? _mm_set1_epi8(1) : zero;
+
+	for (; W > 0; W -= 8) {
+		__m128i r[16 + 7];
+		const uint8_t *S = Src;
+		uint8_t *D = Dst;
+		int i;
+
+		for (i = 0; i <= size; i++) {
+			r[3 + i] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)S), zero);
+			S += BpS;
+		}
+		r[0] = r[5];
+		r[1] = r[4];
+		r[2] = r[3];
+		r[size + 4] = r[size + 3];
+		r[size + 5] = r[size + 2];
+		r[size + 6] = r[size + 1];
+
+		S = Src;
+		for (i = 0; i < size; i++) {
+			const __m128i c = _mm_packus_epi16(fir8(r + i, rnd16), zero);
+			__m128i o = c;
+			if (avrg)
+				o = avg_rnd(o, _mm_loadl_epi64((const __m128i *)(S + (avrg - 1)*BpS)), rnd);
+			if (add)
+				o = _mm_avg_epu8(o, _mm_loadl_epi64((const __m128i *)D));
+			_mm_storel_epi64((__m128i *)D, o);
+			S += BpS;
+			D += BpS;
+		}
+		Src += 8;
+		Dst += 8;
+	}
+}
+
+#define H_PASS(NAME, SIZE, AVRG, ADD) \
+	XVID_QP_PASS_SIGNATURE(NAME) { h_pass(dst, src, length, BpS, rounding, SIZE, AVRG, ADD); }
+#define V_PASS(NAME, SIZE, AVRG, ADD) \
+	XVID_QP_PASS_SIGNATURE(NAME) { v_pass(dst, src, length, BpS, rounding, SIZE, AVRG, ADD); }
+
+H_PASS(H_Pass_16_SSE2_C,              16, 0, 0)
+H_PASS(H_Pass_Avrg_16_SSE2_C,         16, 1, 0)
+H_PASS(H_Pass_Avrg_Up_16_SSE2_C,      16, 2, 0)
+V_PASS(V_Pass_16_SSE2_C,              16, 0, 0)
+V_PASS(V_Pass_Avrg_16_SSE2_C,         16, 1, 0)
+V_PASS(V_Pass_Avrg_Up_16_SSE2_C,      16, 2, 0)
+
+H_PASS(H_Pass_8_SSE2_C,                8, 0, 0)
+H_PASS(H_Pass_Avrg_8_SSE2_C,           8, 1, 0)
+H_PASS(H_Pass_Avrg_Up_8_SSE2_C,        8, 2, 0)
+V_PASS(V_Pass_8_SSE2_C,                8, 0, 0)
+V_PASS(V_Pass_Avrg_8_SSE2_C,           8, 1, 0)
+V_PASS(V_Pass_Avrg_Up_8_SSE2_C,        8, 2, 0)
+
+H_PASS(H_Pass_16_Add_SSE2_C,          16, 0, 1)
+H_PASS(H_Pass_Avrg_16_Add_SSE2_C,     16, 1, 1)
+H_PASS(H_Pass_Avrg_Up_16_Add_SSE2_C,  16, 2, 1)
+V_PASS(V_Pass_16_Add_SSE2_C,          16, 0, 1)
+V_PASS(V_Pass_Avrg_16_Add_SSE2_C,     16, 1, 1)
+V_PASS(V_Pass_Avrg_Up_16_Add_SSE2_C,  16, 2, 1)
+
+H_PASS(H_Pass_8_Add_SSE2_C,            8, 0, 1)
+H_PASS(H_Pass_Avrg_8_Add_SSE2_C,       8, 1, 1)
+H_PASS(H_Pass_Avrg_Up_8_Add_SSE2_C,    8, 2, 1)
+V_PASS(V_Pass_8_Add_SSE2_C,            8, 0, 1)
+V_PASS(V_Pass_Avrg_8_Add_SSE2_C,       8, 1, 1)
+V_PASS(V_Pass_Avrg_Up_8_Add_SSE2_C,    8, 2, 1)
+
+#endif /* ARCH_IS_SSE2 */
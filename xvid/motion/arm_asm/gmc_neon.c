@@ -0,0 +1,57 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - GMC interpolation core, NEON intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_NEON)
+
+#include <arm_neon.h>
+
+/* GMC_Core_Non_Lin_8() of gmc.c for a run of 8 pixels whose integer
+ * offsets advance by exactly one, same arithmetic as the _sse2_c core:
+ *
+ *   h0 = (16-fu)*a + fu*b,  h1 = (16-fu)*c + fu*d
+ *   Dst = ((16-fv)*h0 + fv*h1 + (Rounder>>16)) >> 8
+ *
+ * The sum stays below 65536, so unsigned 16-bit lanes are exact. */
+void
+GMC_Core_Lin_8_neon_c(uint8_t *Dst, const uint16_t * Offsets,
+					  const uint8_t * const Src0, const int BpS, const int Rounder)
+{
+	const uint16x8_t m15 = vdupq_n_u16(15);
+	const uint16x8_t fu = vandq_u16(vld1q_u16(Offsets), m15);
+	const uint16x8_t fv = vandq_u16(vld1q_u16(Offsets + 16), m15);
+	const uint16x8_t a = vmovl_u8(vld1_u8(Src0));
+	const uint16x8_t b = vmovl_u8(vld1_u8(Src0 + 1));
+	const uint16x8_t c = vmovl_u8(vld1_u8(Src0 + BpS));
+	const uint16x8_t d = vmovl_u8(vld1_u8(Src0 + BpS + 1));
+	uint16x8_t h0, h1, s;
+
+	h0 = vmlaq_u16(vshlq_n_u16(a, 4), fu, vsubq_u16(b, a));
+	h1 = vmlaq_u16(vshlq_n_u16(c, 4), fu, vsubq_u16(d, c));
+	s = vmlaq_u16(vshlq_n_u16(h0, 4), fv, vsubq_u16(h1, h0));
+	s = vaddq_u16(s, vdupq_n_u16((uint16_t)(Rounder >> 16)));
+	vst1_u8(Dst, vshrn_n_u16(s, 8));
+}
+
+#endif /* ARCH_IS_NEON */
@@ -385,15 +385,17 @@ void get_average_mv_1pt_C(const NEW_GMC_DATA * const Dsp, VECTOR * const mv,
 	mv->y = RSHIFT(Dsp->Vo<<qpel, 3);
 }
 
-#if defined(ARCH_IS_IA32) || defined(ARCH_IS_X86_64)
+#if defined(ARCH_IS_IA32) || defined(ARCH_IS_X86_64) || defined(ARCH_IS_SSE2) || defined(ARCH_IS_NEON)
 /* *************************************************************
- * MMX core function
+ * MMX core function (the batching below also drives the SSE2 and
+ * NEON intrinsics cores)
  */
 
 static
 void (*GMC_Core_Lin_8)(uint8_t *Dst, const uint16_t * Offsets, 
                        const uint8_t * const Src0, const int BpS, const int Rounder) = 0;
 
+#if defined(ARCH_IS_IA32) || defined(ARCH_IS_X86_64)
 extern void xvid_GMC_Core_Lin_8_mmx(uint8_t *Dst, const uint16_t * Offsets, 
                                     const uint8_t * const Src0, const int BpS, const int Rounder);
 
@@ -402,6 +404,17 @@ extern void xvid_GMC_Core_Lin_8_sse2(uint8_t *Dst, const uint16_t * Offsets,
 
 extern void xvid_GMC_Core_Lin_8_sse41(uint8_t *Dst, const uint16_t * Offsets, 
                                       const uint8_t * const Src0, const int BpS, const int Rounder);
+#endif
+
+#if defined(ARCH_IS_SSE2)
+extern void GMC_Core_Lin_8_sse2_c(uint8_t *Dst, const uint16_t * Offsets, 
+                                  const uint8_t * const Src0, const int BpS, const int Rounder);
+#endif
+
+#if defined(ARCH_IS_NEON)
+extern void GMC_Core_Lin_8_neon_c(uint8_t *Dst, const uint16_t * Offsets, 
+                                  const uint8_t * const Src0, const int BpS, const int Rounder);
+#endif
 
 /* *************************************************************/
 
@@ -579,7 +592,7 @@ void Predict_8x8_mmx(const NEW_GMC_DATA * const This,
   }
 }
 
-#endif /* ARCH_IS_IA32 */
+#endif /* ARCH_IS_IA32 || ARCH_IS_SSE2 || ARCH_IS_NEON */
 
 /* *************************************************************
  * will initialize internal pointers
@@ -607,6 +620,22 @@ void init_GMC(const unsigned int cpu_flags)
              GMC_Core_Lin_8 = xvid_GMC_Core_Lin_8_mmx;
 	}
 #endif
+
+#if defined(ARCH_IS_SSE2)
+      if (cpu_flags & XVID_CPU_SSE2) {
+	   Predict_16x16_func = Predict_16x16_mmx;
+	   Predict_8x8_func   = Predict_8x8_mmx;
+	   GMC_Core_Lin_8     = GMC_Core_Lin_8_sse2_c;
+      }
+#endif
+
+#if defined(ARCH_IS_NEON)
+      if (cpu_flags & XVID_CPU_NEON) {
+	   Predict_16x16_func = Predict_16x16_mmx;
+	   Predict_8x8_func   = Predict_8x8_mmx;
+	   GMC_Core_Lin_8     = GMC_Core_Lin_8_neon_c;
+      }
+#endif
 }
 
 /* *************************************************************
@@ -29,6 +29,8 @@
 #ifndef SF2000
 #include "../encoder.h"
 #include "../utils/mbfunctions.h"
+#else
+#include "../portab.h"
 #endif
 #include "../image/interpolate8x8.h"
 #include "../image/qpel.h"
@@ -0,0 +1,60 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - GMC core, SSE2 intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_SSE2)
+
+#include <emmintrin.h>
+
+/* GMC_Core_Non_Lin_8() of gmc.c for a run of 8 pixels whose integer
+ * offsets advance by exactly one (see Predict_16x16_mmx). Per pixel, with
+ * fu/fv the 1/16 fractions of Offsets[i]/Offsets[16+i]:
+ *
+ *   h0 = (16-fu)*a + fu*b,  h1 = (16-fu)*c + fu*d
+ *   Dst = ((16-fv)*h0 + fv*h1 + (Rounder>>16)) >> 8
+ *
+ * which is what the packed 32-bit arithmetic of the C version reduces to.
+ * The sum stays below 65536, so unsigned 16-bit lanes are exact. */
+void
+GMC_Core_Lin_8_sse2_c(uint8_t *Dst, const uint16_t * Offsets,
+					  const uint8_t * const Src0, const int BpS, const int Rounder)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i m15 = _mm_set1_epi16(15);
+	const __m128i fu = _mm_and_si128(_mm_loadu_si128((const __m128i *)Offsets), m15);
+	const __m128i fv = _mm_and_si128(_mm_loadu_si128((const __m128i *)(Offsets + 16)), m15);
+	const __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)Src0), zero);
+	const __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(Src0 + 1)), zero);
+	const __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(Src0 + BpS)), zero);
+	const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(Src0 + BpS + 1)), zero);
+	__m128i h0, h1, s;
+
+	h0 = _mm_add_epi16(_mm_slli_epi16(a, 4), _mm_mullo_epi16(fu, _mm_sub_epi16(b, a)));
+	h1 = _mm_add_epi16(_mm_slli_epi16(c, 4), _mm_mullo_epi16(fu, _mm_sub_epi16(d, c)));
+	s = _mm_add_epi16(_mm_slli_epi16(h0, 4), _mm_mullo_epi16(fv, _mm_sub_epi16(h1, h0)));
+	s = _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16((int16_t)(Rounder >> 16))), 8);
+	_mm_storel_epi64((__m128i *)Dst, _mm_packus_epi16(s, s));
+}
+
+#endif /* ARCH_IS_SSE2 */
@@ -29,7 +29,8 @@
 #define _PORTAB_H_
 
 /*****************************************************************************
- *  SF2000 Platform (MIPS32, no FPU, single-threaded)
+ *  SF2000 Platform (MIPS32, no FPU, single-threaded) and the decoder-only
+ *  host build of the core
  ****************************************************************************/
 
 #if defined(SF2000)
@@ -39,9 +40,12 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(__mips__)
+
 /* 32-bit MIPS with generic C (no asm) */
 #define ARCH_IS_32BIT
 #define ARCH_IS_GENERIC
+#define ARCH_IS_MIPS32
 
 /* Cache and pointer types */
 #define CACHE_LINE 64
@@ -50,6 +54,38 @@
 #define uintptr_t uint32_t
 #define _INTPTR_T_DEFINED
 
+#else
+
+/* Same decoder-only core built for a desktop or ARM host (platform=unix):
+ * generic C plus the SSE2 or NEON intrinsics kernels the compiler can
+ * target. xvid.c still checks the cpu at runtime before using them. */
+#if UINTPTR_MAX > 0xffffffffu
+#define ARCH_IS_64BIT
+#else
+#define ARCH_IS_32BIT
+#endif
+#define ARCH_IS_GENERIC
+#if defined(__SSE2__)
+#define ARCH_IS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ARCH_IS_NEON
+#endif
+
+/* Cache and pointer types */
+#define CACHE_LINE 64
+#define ptr_t uintptr_t
+
+#endif
+
+#if defined(HAVE_PTHREAD)
+
+/* Host build with worker threads (utils/smp_pool.c) */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#else
+
 /* Single-threaded - stub pthread functions (pthread_t is already defined by toolchain) */
 #define pthread_create(t,u,f,d) (0)
 #define pthread_join(t,s) (0)
@@ -60,16 +96,37 @@
 #define _SC_NPROCESSORS_CONF 0
 #define sysconf(x) (1)
 
+#endif
+
 /* Generic BSWAP (byte swap) */
 #define BSWAP(a) \
     ((a) = (((a) & 0xff) << 24)  | (((a) & 0xff00) << 8) | \
      (((a) >> 8) & 0xff00) | (((a) >> 24) & 0xff))
 
-/* Simple counter using clock() */
+/* Profiling counter: CP0 Count on the bare-metal SF2000 (half the core
+ * clock, wraps at 32 bits; mfc0 traps in user mode, so MIPS Linux takes
+ * the next branch), nanoseconds from clock_gettime on Linux hosts,
+ * clock() otherwise. Only differences are used, taken modulo 2^32. */
+#if defined(SF2000) && defined(__mips__) && !defined(__linux__)
+static __inline int64_t read_counter(void)
+{
+    uint32_t count;
+    __asm__ __volatile__("mfc0 %0, $9" : "=r"(count));
+    return (int64_t)count;
+}
+#elif defined(__linux__)
+static __inline int64_t read_counter(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#else
 static __inline int64_t read_counter(void)
 {
     return (int64_t)clock();
 }
+#endif
 
 /* Debug printf - disabled for SF2000 */
 static __inline void DPRINTF(int level, char *format, ...) {}
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8<->16 bit transfer functions, NEON intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_NEON)
+
+#include <arm_neon.h>
+#include "../mem_transfer.h"
+
+/*
+ * SRC - the source buffer
+ * DST - the destination buffer
+ *
+ *    DST (8bit) = clamp(SRC (16bit))
+ */
+void
+transfer_16to8copy_neon_c(uint8_t * const dst,
+						  const int16_t * const src,
+						  uint32_t stride)
+{
+	uint8_t *d = dst;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		vst1_u8(d, vqmovun_s16(vld1q_s16(src + j*8)));
+		d += stride;
+	}
+}
+
+/*
+ *    DST (8bit) = clamp(DST (8bit) + SRC (16bit))
+ *
+ * The sum wraps at 16 bits before the clamp, like the _c version.
+ */
+void
+transfer_16to8add_neon_c(uint8_t * const dst,
+						 const int16_t * const src,
+						 uint32_t stride)
+{
+	uint8_t *d = dst;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(d)));
+		vst1_u8(d, vqmovun_s16(vaddq_s16(p, vld1q_s16(src + j*8))));
+		d += stride;
+	}
+}
+
+/*
+ *    DST (8bit) = SRC (8bit)
+ */
+void
+transfer8x8_copy_neon_c(uint8_t * const dst,
+						const uint8_t * const src,
+						const uint32_t stride)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		vst1_u8(d, vld1_u8(s));
+		d += stride;
+		s += stride;
+	}
+}
+
+#endif /* ARCH_IS_NEON */
@@ -83,6 +83,18 @@ extern TRANSFER_16TO8COPY transfer_16to8copy_ia64;
 extern TRANSFER_16TO8COPY transfer_16to8copy_altivec_c;
 #endif
 
+#ifdef ARCH_IS_MIPS32
+extern TRANSFER_16TO8COPY transfer_16to8copy_mips32;
+#endif
+
+#ifdef ARCH_IS_SSE2
+extern TRANSFER_16TO8COPY transfer_16to8copy_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+extern TRANSFER_16TO8COPY transfer_16to8copy_neon_c;
+#endif
+
 #ifdef ARCH_IS_X86_64
 extern TRANSFER_16TO8COPY transfer_16to8copy_x86_64;
 #endif
@@ -242,6 +254,18 @@ extern TRANSFER_16TO8ADD transfer_16to8add_ia64;
 extern TRANSFER_16TO8ADD transfer_16to8add_altivec_c;
 #endif
 
+#ifdef ARCH_IS_MIPS32
+extern TRANSFER_16TO8ADD transfer_16to8add_mips32;
+#endif
+
+#ifdef ARCH_IS_SSE2
+extern TRANSFER_16TO8ADD transfer_16to8add_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+extern TRANSFER_16TO8ADD transfer_16to8add_neon_c;
+#endif
+
 #ifdef ARCH_IS_X86_64
 extern TRANSFER_16TO8ADD transfer_16to8add_x86_64;
 #endif
@@ -275,6 +299,18 @@ extern TRANSFER8X8_COPY transfer8x8_copy_ia64;
 extern TRANSFER8X8_COPY transfer8x8_copy_altivec_c;
 #endif
 
+#ifdef ARCH_IS_MIPS32
+extern TRANSFER8X8_COPY transfer8x8_copy_mips32;
+#endif
+
+#ifdef ARCH_IS_SSE2
+extern TRANSFER8X8_COPY transfer8x8_copy_sse2_c;
+#endif
+
+#ifdef ARCH_IS_NEON
+extern TRANSFER8X8_COPY transfer8x8_copy_neon_c;
+#endif
+
 #ifdef ARCH_IS_X86_64
 extern TRANSFER8X8_COPY transfer8x8_copy_x86_64;
 #endif
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8bit<->16bit transfer, MIPS32 word-at-a-time version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../global.h"
+#include "../mem_transfer.h"
+#include "mips32.h"
+
+/* saturate to 0..255: negative -> 0, above 255 -> 255 */
+#define CLAMP255(p) (((p) & ~255) ? (~(p) >> 31) & 255 : (p))
+
+/* Four results packed into one word. Residuals rarely leave 0..255, so
+ * one test on the OR of all four skips the per-pixel clamps */
+static __inline uint32_t
+pack4(int32_t p0, int32_t p1, int32_t p2, int32_t p3)
+{
+	if ((p0 | p1 | p2 | p3) & ~255) {
+		p0 = CLAMP255(p0);
+		p1 = CLAMP255(p1);
+		p2 = CLAMP255(p2);
+		p3 = CLAMP255(p3);
+	}
+	return ((uint32_t)p0 << LANE(0)) | ((uint32_t)p1 << LANE(1)) |
+		((uint32_t)p2 << LANE(2)) | ((uint32_t)p3 << LANE(3));
+}
+
+/*
+ * SRC - the source buffer
+ * DST - the destination buffer
+ *
+ *    DST (8bit) = clamp(SRC (16bit))
+ */
+void
+transfer_16to8copy_mips32(uint8_t * const dst,
+						  const int16_t * const src,
+						  uint32_t stride)
+{
+	uint8_t *d = dst;
+	const int16_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		st32(d,     pack4(s[0], s[1], s[2], s[3]));
+		st32(d + 4, pack4(s[4], s[5], s[6], s[7]));
+		d += stride;
+		s += 8;
+	}
+}
+
+/*
+ *    DST (8bit) = clamp(DST (8bit) + SRC (16bit))
+ */
+void
+transfer_16to8add_mips32(uint8_t * const dst,
+						 const int16_t * const src,
+						 uint32_t stride)
+{
+	uint8_t *d = dst;
+	const int16_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		const uint32_t a = ld32(d);
+		const uint32_t b = ld32(d + 4);
+		st32(d,     pack4((int32_t)((a >> LANE(0)) & 255) + s[0],
+						  (int32_t)((a >> LANE(1)) & 255) + s[1],
+						  (int32_t)((a >> LANE(2)) & 255) + s[2],
+						  (int32_t)((a >> LANE(3)) & 255) + s[3]));
+		st32(d + 4, pack4((int32_t)((b >> LANE(0)) & 255) + s[4],
+						  (int32_t)((b >> LANE(1)) & 255) + s[5],
+						  (int32_t)((b >> LANE(2)) & 255) + s[6],
+						  (int32_t)((b >> LANE(3)) & 255) + s[7]));
+		d += stride;
+		s += 8;
+	}
+}
+
+/*
+ *    DST (8bit) = SRC (8bit)
+ */
+void
+transfer8x8_copy_mips32(uint8_t * const dst,
+						const uint8_t * const src,
+						const uint32_t stride)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		st32(d,     ld32(s));
+		st32(d + 4, ld32(s + 4));
+		d += stride;
+		s += stride;
+	}
+}
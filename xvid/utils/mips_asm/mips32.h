@@ -0,0 +1,58 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - MIPS32 word-at-a-time helpers -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#ifndef _MIPS32_H_
+#define _MIPS32_H_
+
+#include <string.h>
+
+/* MIPS32 has no SIMD, but four pixels fit a register. Rows are moved as
+ * 32-bit words: a 4-byte memcpy compiles to a lwl/lwr (swl/swr) pair for
+ * the unaligned reference rows and is plain C everywhere else. */
+
+static __inline uint32_t
+ld32(const uint8_t * const p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static __inline void
+st32(uint8_t * const p, const uint32_t v)
+{
+	memcpy(p, &v, 4);
+}
+
+/* packed byte averages, exact per lane: (a+b+1)>>1 and (a+b)>>1 */
+#define AVG4_UP(a, b)   (((a) | (b)) - ((((a) ^ (b)) & 0xfefefefeu) >> 1))
+#define AVG4_DOWN(a, b) (((a) & (b)) + ((((a) ^ (b)) & 0xfefefefeu) >> 1))
+
+/* shift of byte lane i (memory order) within a loaded word */
+#ifdef ARCH_IS_BIG_ENDIAN
+#define LANE(i) (24 - 8*(i))
+#else
+#define LANE(i) (8*(i))
+#endif
+
+#endif /* _MIPS32_H_ */
@@ -0,0 +1,204 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - Persistent worker thread pool -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "../portab.h"
+#include "smp_pool.h"
+
+#ifdef HAVE_PTHREAD
+
+/* The workers sleep on 'start' between batches, so a batch costs one
+ * broadcast and one wakeup of the caller instead of a pthread_create and
+ * pthread_join per job. Jobs are handed out one at a time under the lock;
+ * the caller takes its share too and then waits for the stragglers. */
+struct _SMP_POOL
+{
+	pthread_mutex_t lock;
+	pthread_cond_t start;		/* new batch or quit */
+	pthread_cond_t finish;		/* last job of the batch done */
+	pthread_t *handles;
+	int num_workers;
+
+	SMP_JOB *job;
+	uint8_t *args;
+	int arg_size;
+	int count;
+	int next;					/* next job to hand out */
+	int done;					/* jobs finished */
+	unsigned int batch;			/* bumped for every smp_pool_run */
+	int quit;
+};
+
+/* Run the remaining jobs of the current batch; called and returns locked */
+static void
+smp_pool_work(SMP_POOL *pool)
+{
+	while (pool->next < pool->count) {
+		const int k = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+		pool->job(pool->args + k*pool->arg_size);
+		pthread_mutex_lock(&pool->lock);
+		if (++pool->done == pool->count)
+			pthread_cond_signal(&pool->finish);
+	}
+}
+
+static void *
+smp_pool_worker(void *arg)
+{
+	SMP_POOL *pool = (SMP_POOL *) arg;
+	unsigned int seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->quit && pool->batch == seen)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->quit)
+			break;
+		seen = pool->batch;
+		smp_pool_work(pool);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+SMP_POOL *
+smp_pool_create(int num_threads)
+{
+	SMP_POOL *pool;
+	int k;
+
+	if (num_threads < 2)
+		return NULL;
+
+	pool = (SMP_POOL *) calloc(1, sizeof(SMP_POOL));
+	if (pool == NULL)
+		return NULL;
+	pool->handles = (pthread_t *) calloc(num_threads - 1, sizeof(pthread_t));
+	if (pool->handles == NULL) {
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->finish, NULL);
+
+	for (k = 0; k < num_threads - 1; k++) {
+		if (pthread_create(&pool->handles[k], NULL, smp_pool_worker, pool) != 0)
+			break;
+		pool->num_workers++;
+	}
+
+	if (pool->num_workers == 0) {
+		smp_pool_destroy(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+void
+smp_pool_destroy(SMP_POOL *pool)
+{
+	int k;
+
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (k = 0; k < pool->num_workers; k++)
+		pthread_join(pool->handles[k], NULL);
+
+	pthread_cond_destroy(&pool->finish);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->handles);
+	free(pool);
+}
+
+int
+smp_pool_threads(const SMP_POOL *pool)
+{
+	return pool ? pool->num_workers + 1 : 1;
+}
+
+void
+smp_pool_run(SMP_POOL *pool, SMP_JOB *job, void *args, int arg_size, int count)
+{
+	int k;
+
+	if (pool == NULL || count < 2) {
+		for (k = 0; k < count; k++)
+			job((uint8_t *) args + k*arg_size);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->args = (uint8_t *) args;
+	pool->arg_size = arg_size;
+	pool->count = count;
+	pool->next = 0;
+	pool->done = 0;
+	pool->batch++;
+	pthread_cond_broadcast(&pool->start);
+
+	smp_pool_work(pool);
+	while (pool->done < pool->count)
+		pthread_cond_wait(&pool->finish, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+#else /* !HAVE_PTHREAD */
+
+SMP_POOL *
+smp_pool_create(int num_threads)
+{
+	return NULL;
+}
+
+void
+smp_pool_destroy(SMP_POOL *pool)
+{
+}
+
+int
+smp_pool_threads(const SMP_POOL *pool)
+{
+	return 1;
+}
+
+void
+smp_pool_run(SMP_POOL *pool, SMP_JOB *job, void *args, int arg_size, int count)
+{
+	int k;
+
+	for (k = 0; k < count; k++)
+		job((uint8_t *) args + k*arg_size);
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - Persistent worker thread pool header -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#ifndef _SMP_POOL_H_
+#define _SMP_POOL_H_
+
+/* Plain C types only, so the player can share the pool code without
+ * pulling in portab.h */
+
+/* One job of a batch; arg points to its own element of the args array */
+typedef void (SMP_JOB) (void *arg);
+
+typedef struct _SMP_POOL SMP_POOL;
+
+/* Starts num_threads-1 workers that live until smp_pool_destroy; the
+ * calling thread is the last one. Returns NULL when there is nothing to
+ * gain (num_threads < 2, no HAVE_PTHREAD, out of memory): smp_pool_run
+ * then simply runs the batch in the caller. */
+SMP_POOL *smp_pool_create(int num_threads);
+void smp_pool_destroy(SMP_POOL *pool);
+
+/* Threads available to split work between, 1 for a NULL pool */
+int smp_pool_threads(const SMP_POOL *pool);
+
+/* job(args + k*arg_size) for k = 0..count-1, spread over the pool;
+ * returns when all of them have finished */
+void smp_pool_run(SMP_POOL *pool, SMP_JOB *job, void *args, int arg_size, int count);
+
+#endif							/* _SMP_POOL_H_ */
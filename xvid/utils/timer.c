@@ -29,27 +29,12 @@
 
 #if defined(_PROFILING_)
 
-struct ts
-{
-	int64_t current;
-	int64_t global;
-	int64_t overall;
-	int64_t dct;
-	int64_t idct;
-	int64_t quant;
-	int64_t iquant;
-	int64_t motion;
-	int64_t comp;
-	int64_t edges;
-	int64_t inter;
-	int64_t conv;
-	int64_t trans;
-	int64_t prediction;
-	int64_t coding;
-	int64_t interlacing;
-};
+/* counters may wrap at 32 bits (MIPS CP0 Count): every interval is
+ * taken modulo 2^32, which is plenty for one call */
+#define ELAPSED(since) ((uint32_t)(read_counter() - (since)))
 
 struct ts tim;
+uint64_t count_frames;
 
 double frequency = 0.0;
 
@@ -85,9 +70,16 @@ init_timer()
 
 	count_frames = 0;
 
+	reset_timer();
+}
+
+/* zero the stage accumulators without recalibrating */
+void
+reset_timer()
+{
 	tim.dct = tim.quant = tim.idct = tim.iquant = tim.motion = tim.conv =
-		tim.edges = tim.inter = tim.interlacing = tim.trans = tim.trans =
-		tim.coding = tim.global = tim.overall = 0;
+		tim.edges = tim.inter = tim.interlacing = tim.trans = tim.prediction =
+		tim.comp = tim.coding = tim.global = tim.overall = 0;
 }
 
 void
@@ -105,85 +97,85 @@ start_global_timer()
 void
 stop_dct_timer()
 {
-	tim.dct += (read_counter() - tim.current);
+	tim.dct += ELAPSED(tim.current);
 }
 
 void
 stop_idct_timer()
 {
-	tim.idct += (read_counter() - tim.current);
+	tim.idct += ELAPSED(tim.current);
 }
 
 void
 stop_quant_timer()
 {
-	tim.quant += (read_counter() - tim.current);
+	tim.quant += ELAPSED(tim.current);
 }
 
 void
 stop_iquant_timer()
 {
-	tim.iquant += (read_counter() - tim.current);
+	tim.iquant += ELAPSED(tim.current);
 }
 
 void
 stop_motion_timer()
 {
-	tim.motion += (read_counter() - tim.current);
+	tim.motion += ELAPSED(tim.current);
 }
 
 void
 stop_comp_timer()
 {
-	tim.comp += (read_counter() - tim.current);
+	tim.comp += ELAPSED(tim.current);
 }
 
 void
 stop_edges_timer()
 {
-	tim.edges += (read_counter() - tim.current);
+	tim.edges += ELAPSED(tim.current);
 }
 
 void
 stop_inter_timer()
 {
-	tim.inter += (read_counter() - tim.current);
+	tim.inter += ELAPSED(tim.current);
 }
 
 void
 stop_conv_timer()
 {
-	tim.conv += (read_counter() - tim.current);
+	tim.conv += ELAPSED(tim.current);
 }
 
 void
 stop_transfer_timer()
 {
-	tim.trans += (read_counter() - tim.current);
+	tim.trans += ELAPSED(tim.current);
 }
 
 void
 stop_prediction_timer()
 {
-	tim.prediction += (read_counter() - tim.current);
+	tim.prediction += ELAPSED(tim.current);
 }
 
 void
 stop_coding_timer()
 {
-	tim.coding += (read_counter() - tim.current);
+	tim.coding += ELAPSED(tim.current);
 }
 
 void
 stop_interlacing_timer()
 {
-	tim.interlacing += (read_counter() - tim.current);
+	tim.interlacing += ELAPSED(tim.current);
 }
 
 void
 stop_global_timer()
 {
-	tim.overall += (read_counter() - tim.global);
+	tim.overall += ELAPSED(tim.global);
 }
 
 /*
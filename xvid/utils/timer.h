@@ -30,8 +30,31 @@
 
 #include "../portab.h"
 
-uint64_t count_frames;
+/* accumulated counter ticks per stage, see read_counter() */
+struct ts
+{
+	int64_t current;
+	int64_t global;
+	int64_t overall;
+	int64_t dct;
+	int64_t idct;
+	int64_t quant;
+	int64_t iquant;
+	int64_t motion;
+	int64_t comp;
+	int64_t edges;
+	int64_t inter;
+	int64_t conv;
+	int64_t trans;
+	int64_t prediction;
+	int64_t coding;
+	int64_t interlacing;
+};
 
+extern struct ts tim;
+extern uint64_t count_frames;
+
+extern void reset_timer(void);
 extern void start_timer(void);
 extern void start_global_timer(void);
 extern void stop_dct_timer(void);
@@ -106,6 +129,10 @@ init_timer(void)
 {
 }
 static __inline void
+reset_timer(void)
+{
+}
+static __inline void
 write_timer(void)
 {
 }
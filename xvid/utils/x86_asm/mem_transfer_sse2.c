@@ -0,0 +1,105 @@
+/*****************************************************************************
+ *
+ *  XVID MPEG-4 VIDEO CODEC
+ *  - 8<->16 bit transfer functions, SSE2 intrinsics version -
+ *
+ *  This program is free software ; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation ; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY ; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program ; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * $Id$
+ *
+ ****************************************************************************/
+
+#include "../../portab.h"
+
+#if defined(ARCH_IS_SSE2)
+
+#include <emmintrin.h>
+#include "../mem_transfer.h"
+
+#define LOAD8(p)     _mm_loadl_epi64((const __m128i *)(p))
+#define STORE8(p, v) _mm_storel_epi64((__m128i *)(p), (v))
+
+/*
+ * SRC - the source buffer
+ * DST - the destination buffer
+ *
+ *    DST (8bit) = clamp(SRC (16bit))
+ *
+ * Two rows per packus: the saturation is the clamp.
+ */
+void
+transfer_16to8copy_sse2_c(uint8_t * const dst,
+						  const int16_t * const src,
+						  uint32_t stride)
+{
+	uint8_t *d = dst;
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(src + j*8));
+		const __m128i b = _mm_loadu_si128((const __m128i *)(src + j*8 + 8));
+		const __m128i p = _mm_packus_epi16(a, b);
+		STORE8(d, p);
+		STORE8(d + stride, _mm_srli_si128(p, 8));
+		d += 2*stride;
+	}
+}
+
+/*
+ *    DST (8bit) = clamp(DST (8bit) + SRC (16bit))
+ *
+ * The sum wraps at 16 bits before the clamp, like the _c version.
+ */
+void
+transfer_16to8add_sse2_c(uint8_t * const dst,
+						 const int16_t * const src,
+						 uint32_t stride)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint8_t *d = dst;
+	int j;
+
+	for (j = 0; j < 8; j += 2) {
+		__m128i a = _mm_unpacklo_epi8(LOAD8(d), zero);
+		__m128i b = _mm_unpacklo_epi8(LOAD8(d + stride), zero);
+		a = _mm_add_epi16(a, _mm_loadu_si128((const __m128i *)(src + j*8)));
+		b = _mm_add_epi16(b, _mm_loadu_si128((const __m128i *)(src + j*8 + 8)));
+		a = _mm_packus_epi16(a, b);
+		STORE8(d, a);
+		STORE8(d + stride, _mm_srli_si128(a, 8));
+		d += 2*stride;
+	}
+}
+
+/*
+ *    DST (8bit) = SRC (8bit)
+ */
+void
+transfer8x8_copy_sse2_c(uint8_t * const dst,
+						const uint8_t * const src,
+						const uint32_t stride)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	int j;
+
+	for (j = 0; j < 8; j++) {
+		STORE8(d, LOAD8(s));
+		d += stride;
+		s += stride;
+	}
+}
+
+#endif /* ARCH_IS_SSE2 */
@@ -55,6 +55,7 @@
 #include "encoder.h"
 #endif
 #include "bitstream/cbp.h"
+#include "bitstream/mbcoding.h"
 #include "dct/idct.h"
 #ifndef SF2000
 #include "dct/fdct.h"
@@ -79,6 +80,10 @@
 #include "image/qpel.h"
 #include "image/postprocessing.h"
 
+#if defined(ARCH_IS_NEON) && !defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
 #if defined(_DEBUG)
 unsigned int xvid_debug = 0; /* xvid debug mask */
 #endif
@@ -184,6 +189,26 @@ detect_cpu_flags(void)
 	if (!sigill_check(altivec_trigger))
 		cpu_flags |= XVID_CPU_ALTIVEC;
 #endif
+#endif
+
+#if defined(ARCH_IS_MIPS32)
+	/* nothing to probe: the kernels are plain mips32 code */
+	cpu_flags |= XVID_CPU_MIPS32;
+#endif
+
+#if defined(ARCH_IS_SSE2)
+	/* generic build compiled for sse2: check the cpu it runs on */
+	if (__builtin_cpu_supports("sse2"))
+		cpu_flags |= XVID_CPU_SSE2;
+#endif
+
+#if defined(ARCH_IS_NEON)
+#if defined(__aarch64__)
+	cpu_flags |= XVID_CPU_NEON; /* mandatory in armv8 */
+#elif defined(__linux__)
+	if (getauxval(AT_HWCAP) & (1 << 12)) /* HWCAP_NEON */
+		cpu_flags |= XVID_CPU_NEON;
+#endif
 #endif
 
 	return cpu_flags;
@@ -698,6 +723,95 @@ int xvid_gbl_init(xvid_gbl_init_t * init)
         }
 #endif
 
+#if defined(ARCH_IS_MIPS32)
+	if ((cpu_flags & XVID_CPU_MIPS32)) {
+		/* mem transfer */
+		transfer_16to8copy = transfer_16to8copy_mips32;
+		transfer_16to8add = transfer_16to8add_mips32;
+		transfer8x8_copy = transfer8x8_copy_mips32;
+
+		/* Interpolation */
+		interpolate8x8_halfpel_h = interpolate8x8_halfpel_h_mips32;
+		interpolate8x8_halfpel_v = interpolate8x8_halfpel_v_mips32;
+		interpolate8x8_halfpel_hv = interpolate8x8_halfpel_hv_mips32;
+
+		interpolate8x4_halfpel_h = interpolate8x4_halfpel_h_mips32;
+		interpolate8x4_halfpel_v = interpolate8x4_halfpel_v_mips32;
+		interpolate8x4_halfpel_hv = interpolate8x4_halfpel_hv_mips32;
+
+		interpolate8x8_halfpel_add = interpolate8x8_halfpel_add_mips32;
+		interpolate8x8_halfpel_h_add = interpolate8x8_halfpel_h_add_mips32;
+		interpolate8x8_halfpel_v_add = interpolate8x8_halfpel_v_add_mips32;
+		interpolate8x8_halfpel_hv_add = interpolate8x8_halfpel_hv_add_mips32;
+
+		interpolate8x8_avg2 = interpolate8x8_avg2_mips32;
+	}
+#endif
+
+#if defined(ARCH_IS_SSE2)
+	if ((cpu_flags & XVID_CPU_SSE2)) {
+		/* mem transfer */
+		transfer_16to8copy = transfer_16to8copy_sse2_c;
+		transfer_16to8add = transfer_16to8add_sse2_c;
+		transfer8x8_copy = transfer8x8_copy_sse2_c;
+
+		/* Inverse DCT */
+		idct = idct_sse2_c;
+
+		/* Interpolation */
+		interpolate8x8_halfpel_h = interpolate8x8_halfpel_h_sse2_c;
+		interpolate8x8_halfpel_v = interpolate8x8_halfpel_v_sse2_c;
+		interpolate8x8_halfpel_hv = interpolate8x8_halfpel_hv_sse2_c;
+
+		interpolate8x4_halfpel_h = interpolate8x4_halfpel_h_sse2_c;
+		interpolate8x4_halfpel_v = interpolate8x4_halfpel_v_sse2_c;
+		interpolate8x4_halfpel_hv = interpolate8x4_halfpel_hv_sse2_c;
+
+		interpolate8x8_halfpel_add = interpolate8x8_halfpel_add_sse2_c;
+		interpolate8x8_halfpel_h_add = interpolate8x8_halfpel_h_add_sse2_c;
+		interpolate8x8_halfpel_v_add = interpolate8x8_halfpel_v_add_sse2_c;
+		interpolate8x8_halfpel_hv_add = interpolate8x8_halfpel_hv_add_sse2_c;
+
+		interpolate8x8_avg2 = interpolate8x8_avg2_sse2_c;
+
+		/* Qpel stuff */
+		xvid_QP_Funcs = &xvid_QP_Funcs_SSE2_C;
+		xvid_QP_Add_Funcs = &xvid_QP_Add_Funcs_SSE2_C;
+	}
+#endif
+
+#if defined(ARCH_IS_NEON)
+	if ((cpu_flags & XVID_CPU_NEON)) {
+		/* mem transfer */
+		transfer_16to8copy = transfer_16to8copy_neon_c;
+		transfer_16to8add = transfer_16to8add_neon_c;
+		transfer8x8_copy = transfer8x8_copy_neon_c;
+
+		/* Inverse DCT */
+		idct = idct_neon_c;
+
+		/* Interpolation */
+		interpolate8x8_halfpel_h = interpolate8x8_halfpel_h_neon_c;
+		interpolate8x8_halfpel_v = interpolate8x8_halfpel_v_neon_c;
+		interpolate8x8_halfpel_hv = interpolate8x8_halfpel_hv_neon_c;
+
+		interpolate8x4_halfpel_h = interpolate8x4_halfpel_h_neon_c;
+		interpolate8x4_halfpel_v = interpolate8x4_halfpel_v_neon_c;
+		interpolate8x4_halfpel_hv = interpolate8x4_halfpel_hv_neon_c;
+
+		interpolate8x8_halfpel_add = interpolate8x8_halfpel_add_neon_c;
+		interpolate8x8_halfpel_h_add = interpolate8x8_halfpel_h_add_neon_c;
+		interpolate8x8_halfpel_v_add = interpolate8x8_halfpel_v_add_neon_c;
+		interpolate8x8_halfpel_hv_add = interpolate8x8_halfpel_hv_add_neon_c;
+
+		interpolate8x8_avg2 = interpolate8x8_avg2_neon_c;
+
+		/* Qpel stuff */
+		xvid_QP_Funcs = &xvid_QP_Funcs_NEON_C;
+		xvid_QP_Add_Funcs = &xvid_QP_Add_Funcs_NEON_C;
+	}
+#endif
+
 #if defined(_DEBUG)
     xvid_debug = init->debug;
 #endif
@@ -191,6 +191,11 @@ typedef struct {
 #define XVID_CPU_TSC      (1<< 6) /*       tsc : Pentium */
 /* ARCH_IS_PPC */
 #define XVID_CPU_ALTIVEC  (1<< 0) /* altivec */
+/* ARCH_IS_SSE2 (generic build) uses XVID_CPU_SSE2 */
+/* ARCH_IS_NEON */
+#define XVID_CPU_NEON     (1<< 0) /* neon : armv7-a with neon, armv8 */
+/* ARCH_IS_MIPS32 */
+#define XVID_CPU_MIPS32   (1<< 0) /* word-at-a-time copies, packed byte averages */
 
 
 #define XVID_DEBUG_ERROR     (1<< 0)
@@ -273,18 +278,29 @@ typedef struct {
 #define XVID_DERINGUV      (1<<5) /* perform chroma deringing, requires deblocking to work */
 #define XVID_DERINGY       (1<<6) /* perform luma deringing, requires deblocking to work */
 
-#define XVID_DEC_FAST      (1<<29) /* disable postprocessing to decrease cpu usage *todo* */
-#define XVID_DEC_DROP      (1<<30) /* drop bframes to decrease cpu usage *todo* */
-#define XVID_DEC_PREROLL   (1<<31) /* decode as fast as you can, don't even show output *todo* */
+/* SF2000: approximate motion compensation in every VOP: halfpel bilinear
+ * for quarterpel vectors, one translational vector per macroblock for GMC.
+ * References drift from the true picture until the next I-VOP */
+#define XVID_DEC_FASTMC    (1<<28)
+
+#define XVID_DEC_FAST      (1<<29) /* disable postprocessing, halfpel luma MC in qpel bframes */
+#define XVID_DEC_DROP      (1<<30) /* drop bframes to decrease cpu usage */
+#define XVID_DEC_PREROLL   (1<<31) /* decode references only, don't even show output */
+
+/* bytes past the end of xvid_dec_frame_t.bitstream the decoder may load
+ * (but never decodes); callers must keep them allocated, ideally zeroed */
+#define XVID_BS_PADDING    8
 
 typedef struct {
 	int version;
 	int general;         /* [in:opt] general flags */
-	void *bitstream;     /* [in]     bitstream (read from)*/
+	void *bitstream;     /* [in]     bitstream (read from), padded by XVID_BS_PADDING */
 	int length;          /* [in]     bitstream length */
 	xvid_image_t output; /* [in]     output image (written to) */
 /* ------- v1.1.x ------- */
 	int brightness;		 /* [in]	 brightness offset (0=none) */
+/* ------- SF2000 ------- */
+	int deblock_quant;   /* [in:opt] deblock only macroblocks with quant above this (0=all) */
 } xvid_dec_frame_t;
 
 
@@ -314,6 +330,21 @@ typedef struct
 			int par_height;     /* [out] aspect ratio height [1..255] */
 		} vol;
 	} data;
+/* ------- SF2000 ------- */
+	struct {	/* tick counts are zero unless built with _PROFILING_ */
+		unsigned int overall;    /* [out] counter ticks spent in this call */
+		unsigned int coding;     /* [out] ...of which VLC/coefficient parsing */
+		unsigned int prediction; /* [out] AC/DC and motion vector prediction */
+		unsigned int iquant;     /* [out] inverse quantisation */
+		unsigned int idct;       /* [out] inverse DCT */
+		unsigned int transfer;   /* [out] block transfers into the frame */
+		unsigned int comp;       /* [out] motion compensation */
+		unsigned int edges;      /* [out] reference edge extension */
+		unsigned int conv;       /* [out] postprocessing and output conversion */
+		int vops[5];             /* [out] VOPs decoded since create: I, P, B, S, N */
+	} prof;
+	int delay;                  /* [out] pictures the output lags the input (1 with unpacked B-frames) */
+	int bvop;                   /* [out] a B-VOP was read (decoded or dropped); when packed, its reference is still held back */
 } xvid_dec_stats_t;
 
 #define XVID_ZONE_QUANT  (1<<0)